@@ -13,6 +13,7 @@
 #include "CIFlt.hpp"
 #include "matSup.hpp"
 #include "models.hpp"
+#include "bayesTrace.hpp"
 
 /* Filter namespace */
 namespace Bayesian_filter
@@ -22,7 +23,9 @@ namespace Bayesian_filter
 
 CI_scheme::CI_scheme (std::size_t x_size, std::size_t z_initialsize) :
 	Kalman_state_filter(x_size),
-	S(Empty), SI(Empty)
+	S(Empty),
+	invX(x_size,x_size), HTinvZH(x_size,x_size),
+	ZUD(Empty), tempXZ(Empty)
 /* Initialise filter and set the size of things we know about
  */
 {
@@ -49,16 +52,18 @@ void CI_scheme::init ()
 
 void CI_scheme::update ()
 {
+	BAYES_FILTER_TRACE_SPAN("CI_scheme::update");
 	// Nothing to do, implicit in observation
 }
 
 Bayes_base::Float
  CI_scheme::predict (Linrz_predict_model& f)
 {
+	BAYES_FILTER_TRACE_SPAN("CI_scheme::predict");
 	x = f.f(x);			// Extended Kalman state predict is f(x) directly
 						// Predict state covariance
 	RowMatrix tempX(f.Fx.size1(), X.size2());
-	noalias(X) = prod_SPD(f.Fx,X, tempX);
+	assign_prod_SPD (X, f.Fx, X, tempX);
 	noalias(X) += prod_SPD(f.G, f.q, tempX);
 
 	return 1;
@@ -71,12 +76,13 @@ void CI_scheme::observe_size (std::size_t z_size)
 	if (z_size != last_z_size) {
 		last_z_size = z_size;
 
-		S.resize(z_size,z_size, false);
-		SI.resize(z_size,z_size, false);
+		S_cache.exchange (S, z_size,z_size);
+		factor_size (z_size);
+		ZUD_cache.exchange (ZUD, z_size,z_size);
+		tempXZ_cache.exchange (tempXZ, x.size(),z_size);
 	}
 }
 
-
 Bayes_base::Float
  CI_scheme::observe_innovation (Linrz_uncorrelated_observe_model& h, const FM::Vec& s)
 /* Iterated Extended Kalman Filter
@@ -86,10 +92,8 @@ Bayes_base::Float
  * Uncorrelated noise
  */
 {
+	BAYES_FILTER_TRACE_SPAN("CI_scheme::observe_innovation");
 						// ISSUE: Implement simplified uncorrelated noise equations
-	std::size_t z_size = s.size();
-	SymMatrix Z(z_size,z_size);
-
 	Adapted_Linrz_correlated_observe_model hh(h);
 	return observe_innovation (hh, s);
 }
@@ -100,6 +104,7 @@ Bayes_base::Float
 /* Correlated innovation observe
  */
 {
+	BAYES_FILTER_TRACE_SPAN("CI_scheme::observe_innovation");
 	const Float one = 1;
 						// size consistency, z to model
 	if (s.size() != h.Z.size1())
@@ -107,14 +112,13 @@ Bayes_base::Float
 	observe_size (s.size());	// dynamic sizing
 
 						// Linear conditioning for omega
-	SymMatrix invZ(h.Z.size1(),h.Z.size2());
-	Float rcond = UdUinversePD (invZ, h.Z);
+	Float rcond = UdUfactor (ZUD, h.Z);
 	rclimit.check_PSD(rcond, "Z not PSD in observe");
 
-	Matrix HTinvZ (prod(trans(h.Hx), invZ));
-	SymMatrix HTinvZH (prod(HTinvZ, h.Hx));
+	noalias(tempXZ) = trans(h.Hx);		// Hx'*inv(Z) by solution with the factor of Z
+	UdUsolve_right (ZUD, tempXZ);
+	assign_prod (HTinvZH, tempXZ, h.Hx);
 
-	SymMatrix invX(X.size1(),X.size2());
 	rcond = UdUinversePD (invX, X);
 	rclimit.check_PD(rcond, "X not PD in observe");
 
@@ -123,18 +127,20 @@ Bayes_base::Float
 	Float omega = Omega(invX, HTinvZH, X);
 
 						// calculate predicted innovation
-	Matrix XHT (prod(X, trans(h.Hx)));
-	Matrix HXHT (prod(h.Hx, XHT));
-	S = HXHT * (one-omega) + h.Z * omega;
+	assign_prod_trans (tempXZ, X, h.Hx);	// X*Hx'
+	assign_prod (S, h.Hx, tempXZ);
+	S *= (one-omega);
+	noalias(S) += h.Z * omega;
 
-						// inverse innovation covariance
-	rcond = UdUinversePD (SI, S);
+						// factorise innovation covariance
+	rcond = factor_S (S);
 	rclimit.check_PD(rcond, "S not PD in observe");
 
-	Matrix K (prod(XHT*(one-omega), SI));
+	tempXZ *= (one-omega);			// gain by solution with the factor of S
+	UdUsolve_right (SUD, tempXZ);
 
 						// state update
-	noalias(x) += prod(K, s);
+	noalias(x) += prod(tempXZ, s);
 						// inverse covariance
 	invX *= omega;						
 	noalias(invX) += HTinvZH*(one-omega);
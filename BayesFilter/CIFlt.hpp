@@ -35,7 +35,7 @@
 namespace Bayesian_filter
 {
 
-class CI_scheme : public Extended_kalman_filter
+class CI_scheme : public Extended_kalman_filter, public Innovation_factor
 {
 public:
 	CI_scheme (std::size_t x_size, std::size_t z_initialsize = 0);
@@ -56,11 +56,19 @@ public:
 	}
 
 public:						// Exposed Numerical Results
-	FM::SymMatrix S, SI;		// Innovation Covariance and Inverse
+	FM::SymMatrix S;			// Innovation Covariance
+
+protected:			   		// Permanently allocated temps
+	FM::SymMatrix invX, HTinvZH;
+	FM::RowMatrix ZUD;			// UdU' factor of Z, sized by observe_size
+	FM::Matrix tempXZ;			// Hx'*inv(Z) and then X*Hx', sized by observe_size
 
 protected:					// allow fast operation if z_size remains constant
 	std::size_t last_z_size;
 	void observe_size (std::size_t z_size);
+	FM::Size_cache<FM::SymMatrix> S_cache;
+	FM::Size_cache<FM::RowMatrix> ZUD_cache;
+	FM::Size_cache<FM::Matrix> tempXZ_cache;
 };
 
 
@@ -14,8 +14,15 @@
 #include "SIRFlt.hpp"
 #include "matSup.hpp"
 #include "models.hpp"
+#include "bayesTrace.hpp"
 #include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <exception>
+#include <functional>
 #include <iterator>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 namespace {
@@ -52,6 +59,7 @@ Standard_resampler::Float
  *  A draw is made from 'r' for each particle
  */
 {
+	BAYES_FILTER_TRACE_SPAN("Standard_resampler::resample");
 	assert (presamples.size() == w.size());
 	DenseVec::iterator wi, wi_end = w.end();
 						// Normalised cumulative sum of likelihood weights (Kahan algorithm), and find smallest weight
@@ -130,6 +138,7 @@ Systematic_resampler::Float
  *  A single draw is made from 'r'
  */
 {
+	BAYES_FILTER_TRACE_SPAN("Systematic_resampler::resample");
 	std::size_t nParticles = presamples.size();
 	assert (nParticles == w.size());
 	DenseVec::iterator wi, wi_end = w.end();
@@ -191,6 +200,178 @@ Systematic_resampler::Float
 }
 
 
+/*
+ * Randomised quasi-Monte Carlo random helper
+ */
+namespace {
+
+typedef std::uint32_t Sobol_int;
+
+struct Sobol_directions
+/* Direction numbers of the Sobol sequence
+ *  Primitive polynomials and initial direction numbers from S Joe and FY Kuo "new-joe-kuo-6.21201"
+ */
+{
+	Sobol_int V[Bayesian_filter::Sobol_SIR_random::max_dimension][32];
+	Sobol_directions ()
+	{
+		static const unsigned poly[][8] = {		// s, a, m(1..s)
+			{1, 0, 1}, {2, 1, 1,3}, {3, 1, 1,3,1}, {3, 2, 1,1,1}, {4, 1, 1,1,3,3},
+			{4, 4, 1,3,5,13}, {5, 2, 1,1,5,5,17}, {5, 4, 1,1,5,5,5}, {5, 7, 1,1,7,11,19}, {5, 11, 1,1,5,1,1},
+			{5, 13, 1,1,1,3,11}, {5, 14, 1,3,5,5,31}, {6, 1, 1,3,3,9,7,49}, {6, 13, 1,1,1,15,21,21}, {6, 16, 1,3,1,13,27,49}
+		};
+		for (unsigned k = 0; k != 32; ++k)		// First dimension is van der Corput
+			V[0][k] = Sobol_int(1) << (31-k);
+		for (std::size_t d = 1; d != Bayesian_filter::Sobol_SIR_random::max_dimension; ++d) {
+			const unsigned s = poly[d-1][0], a = poly[d-1][1];
+			const unsigned* m = &poly[d-1][2];
+			for (unsigned k = 0; k != 32; ++k) {
+				if (k < s)
+					V[d][k] = Sobol_int(m[k]) << (31-k);
+				else {
+					Sobol_int v = V[d][k-s] ^ (V[d][k-s] >> s);
+					for (unsigned j = 1; j != s; ++j) {
+						if ((a >> (s-1-j)) & 1)
+							v ^= V[d][k-j];
+					}
+					V[d][k] = v;
+				}
+			}
+		}
+	}
+	Sobol_int operator() (Sobol_int i, std::size_t d) const
+	{
+		Sobol_int x = 0;
+		for (unsigned k = 0; i != 0; i >>= 1, ++k) {
+			if (i & 1)
+				x ^= V[d][k];
+		}
+		return x;
+	}
+};
+const Sobol_directions sobol;
+
+inline Sobol_int hash (Sobol_int x)
+{
+	x ^= x >> 17; x *= 0xed5ad4bbu;
+	x ^= x >> 11; x *= 0xac4c1b51u;
+	x ^= x >> 15; x *= 0x31848babu;
+	x ^= x >> 14;
+	return x;
+}
+
+inline Sobol_int hash_combine (Sobol_int seed, Sobol_int v)
+{
+	return seed ^ (v + (seed << 6) + (seed >> 2));
+}
+
+inline Sobol_int reverse_bits (Sobol_int x)
+{
+	x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+	x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+	x = ((x >> 4) & 0x0f0f0f0fu) | ((x & 0x0f0f0f0fu) << 4);
+	x = ((x >> 8) & 0x00ff00ffu) | ((x & 0x00ff00ffu) << 8);
+	return (x >> 16) | (x << 16);
+}
+
+inline Sobol_int nested_uniform_scramble (Sobol_int x, Sobol_int seed)
+/* Owen scramble using the Laine-Karras hash on reversed bits
+ */
+{
+	x = reverse_bits (x);
+	x += seed;
+	x ^= x * 0x6c50b47cu;
+	x ^= x * 0xb82f1e52u;
+	x ^= x * 0xc7afe638u;
+	x ^= x * 0x8d22f6e6u;
+	return reverse_bits (x);
+}
+
+inline Bayesian_filter::Bayes_base::Float uniform (Sobol_int x)
+// Centre of interval x in (0,1)
+{
+	return (Bayesian_filter::Bayes_base::Float(x) + Bayesian_filter::Bayes_base::Float(0.5)) * Bayesian_filter::Bayes_base::Float(1./4294967296.);
+}
+
+double inverse_normal (double p)
+/* Inverse of the standard normal distribution for p in (0,1)
+ *  Rational approximation of P Acklam refined with one step of Halley's method
+ */
+{
+	static const double a[] = {-3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02, 1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00};
+	static const double b[] = {-5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02, 6.680131188771972e+01, -1.328068155288572e+01};
+	static const double c[] = {-7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00, -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00};
+	static const double d[] = {7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00, 3.754408661907416e+00};
+	const double plow = 0.02425;
+	double x;
+	if (p < plow) {
+		const double q = std::sqrt(-2*std::log(p));
+		x = (((((c[0]*q+c[1])*q+c[2])*q+c[3])*q+c[4])*q+c[5]) / ((((d[0]*q+d[1])*q+d[2])*q+d[3])*q+1);
+	}
+	else if (p <= 1 - plow) {
+		const double q = p - 0.5, r = q*q;
+		x = (((((a[0]*r+a[1])*r+a[2])*r+a[3])*r+a[4])*r+a[5])*q / (((((b[0]*r+b[1])*r+b[2])*r+b[3])*r+b[4])*r+1);
+	}
+	else {
+		const double q = std::sqrt(-2*std::log(1-p));
+		x = -(((((c[0]*q+c[1])*q+c[2])*q+c[3])*q+c[4])*q+c[5]) / ((((d[0]*q+d[1])*q+d[2])*q+d[3])*q+1);
+	}
+	const double e = 0.5 * std::erfc(-x/std::sqrt(2.)) - p;
+	const double u = e * std::sqrt(2*3.14159265358979323846) * std::exp(x*x/2);
+	return x - u/(1 + x*u/2);
+}
+
+}//namespace
+
+Sobol_SIR_random::Sobol_SIR_random (unsigned seed, unsigned stream)
+{
+	base_seed = hash (hash_combine (hash(Sobol_int(seed)), Sobol_int(stream)));
+}
+
+Sobol_SIR_random::Stream&
+ Sobol_SIR_random::stream (std::size_t size, bool normal)
+{
+	std::pair<std::size_t, bool> key(size, normal);
+	std::map<std::pair<std::size_t, bool>, Stream>::iterator si = streams.find(key);
+	if (si == streams.end()) {
+		Stream s;
+		s.seed = hash (hash_combine (base_seed, Sobol_int(size*2 + (normal ? 1 : 0))));
+		s.index = 0;
+		si = streams.insert (std::make_pair(key, s)).first;
+	}
+	return si->second;
+}
+
+void Sobol_SIR_random::point (Stream& s, FM::DenseVec& v)
+/* Next point of the scrambled sequence of s
+ */
+{
+	const std::size_t n = v.size();
+	if (n <= max_dimension) {			// Point with a dimension for each element
+		const Sobol_int i = nested_uniform_scramble (s.index++, s.seed);
+		for (std::size_t d = 0; d != n; ++d)
+			v[d] = uniform (nested_uniform_scramble (sobol(i, d), hash_combine(s.seed, Sobol_int(d))));
+	}
+	else {								// Stratified set in one dimension, scrambled for each call
+		const Sobol_int seed = hash (hash_combine (s.seed, s.index++));
+		for (std::size_t j = 0; j != n; ++j)
+			v[j] = uniform (nested_uniform_scramble (sobol(Sobol_int(j), 0), seed));
+	}
+}
+
+void Sobol_SIR_random::uniform_01 (FM::DenseVec& v)
+{
+	point (stream (v.size(), false), v);
+}
+
+void Sobol_SIR_random::normal (FM::DenseVec& v)
+{
+	point (stream (v.size(), true), v);
+	for (FM::DenseVec::iterator vi = v.begin(); vi != v.end(); ++vi)
+		*vi = Float(inverse_normal (*vi));
+}
+
+
 /*
  * SIR filter implementation
  */
@@ -207,6 +388,7 @@ SIR_scheme::SIR_scheme (std::size_t x_size, std::size_t s_size, SIR_random& rand
 {
 	SIR_scheme::x_size = x_size;
 	rougheningK = rougheningKinit;
+	copies.reserve (s_size);
 }
 
 SIR_scheme& SIR_scheme::operator= (const SIR_scheme& a)
@@ -218,6 +400,7 @@ SIR_scheme& SIR_scheme::operator= (const SIR_scheme& a)
 	Sample_filter::operator=(a);
 	stochastic_samples = a.stochastic_samples;			// Copy weights
 	wir_update = a.wir_update;
+	copies = a.copies;
 	return *this;
 }
 
@@ -232,6 +415,7 @@ void
 	stochastic_samples = S.size2();
 	std::fill (wir.begin(), wir.end(), Float(1));		// Initial uniform weights
 	wir_update = false;
+	copies.clear();		// S may contain anything
 }
 
 
@@ -249,6 +433,7 @@ SIR_scheme::Float
  *  This should by multiplied by the number of samples to get the Likelihood function conditioning
  */
 {
+	BAYES_FILTER_TRACE_SPAN("SIR_scheme::update_resample");
 	Float lcond = 1;
 	if (wir_update)		// Resampling only required if weights have been updated
 	{
@@ -260,6 +445,15 @@ SIR_scheme::Float
 		copy_resamples (S, resamples);
 		stochastic_samples = R_unique;
 
+		copies.clear();		// Runs of identical samples, only without roughening
+		if (rougheningK == 0) {
+			Importance_resampler::Resamples_t::const_iterator pi, pi_end = resamples.end();
+			for (pi = resamples.begin(); pi != pi_end; ++pi) {
+				if (*pi > 0)
+					copies.push_back (*pi);
+			}
+		}
+
 		roughen ();			// Roughen samples
 
 		std::fill (wir.begin(), wir.end(), Float(1));		// Resampling results in uniform weights
@@ -269,6 +463,34 @@ SIR_scheme::Float
 }
 
 
+void
+ SIR_scheme::predict (Functional_predict_model& f)
+/* Predict samples without noise
+ *  Identical samples remain identical so f is evaluated once for each run of copies
+ *  Pre : S represent the prior distribution
+ *  Post: S represent the predicted distribution
+ */
+{
+	BAYES_FILTER_TRACE_SPAN("SIR_scheme::predict");
+	if (copies.empty()) {
+		Sample_filter::predict (f);
+		return;
+	}
+						// Predict first of each run and replicate
+	std::size_t si = 0;
+	Importance_resampler::Resamples_t::const_iterator ci, ci_end = copies.end();
+	for (ci = copies.begin(); ci != ci_end; ++ci) {
+		FM::ColMatrix::Column Si(S,si);
+		noalias(Si) = f.fx(Si);
+		const std::size_t run_end = si + *ci;
+		for (std::size_t i = si+1; i != run_end; ++i) {
+			noalias(FM::column(S,i)) = Si;
+		}
+		si = run_end;
+	}
+	assert (si == S.size2());
+}
+
 void
  SIR_scheme::predict (Sampled_predict_model& f)
 /* Predict state posterior with sampled noise model
@@ -276,6 +498,7 @@ void
  *  Post: S represent the predicted distribution, stochastic_samples := samples in S
  */
 {
+	BAYES_FILTER_TRACE_SPAN("SIR_scheme::predict");
 						// Predict particles S using supplied predict model
 	const std::size_t nSamples = S.size2();
 	for (std::size_t i = 0; i != nSamples; ++i) {
@@ -283,6 +506,36 @@ void
 		noalias(Si) = f.fw(Si);
 	}
 	stochastic_samples = S.size2();
+	copies.clear();		// Samples are no longer identical
+}
+
+void
+ SIR_scheme::predict (Sampled_additive_predict_model& f)
+/* Predict state posterior with sampled additive noise model
+ *  The deterministic part fd is evaluated once for each run of identical samples
+ *  Pre : S represent the prior distribution
+ *  Post: S represent the predicted distribution, stochastic_samples := samples in S
+ */
+{
+	BAYES_FILTER_TRACE_SPAN("SIR_scheme::predict");
+	if (copies.empty()) {
+		predict (static_cast<Sampled_predict_model&>(f));
+		return;
+	}
+						// Predict particles S using deterministic part once per run
+	FM::Vec fdx(S.size1());
+	std::size_t si = 0;
+	Importance_resampler::Resamples_t::const_iterator ci, ci_end = copies.end();
+	for (ci = copies.begin(); ci != ci_end; ++ci) {
+		fdx = f.fd(FM::column(S,si));
+		const std::size_t run_end = si + *ci;
+		for (; si != run_end; ++si) {
+			noalias(FM::column(S,si)) = f.add_w(fdx);
+		}
+	}
+	assert (si == S.size2());
+	stochastic_samples = S.size2();
+	copies.clear();		// Samples are no longer identical
 }
 
 
@@ -293,12 +546,28 @@ void
  * Post: wir fused (multiplicative) particle likelihood weights
  */
 {
-	h.Lz (z);			// Observe likelihood at z
+	BAYES_FILTER_TRACE_SPAN("SIR_scheme::observe");
+	{	BAYES_FILTER_TRACE_SPAN("Likelihood_observe_model::Lz");
+		h.Lz (z);			// Observe likelihood at z
+	}
 
 						// Weight Particles. Fused with previous weight
-	const std::size_t nSamples = S.size2();
-	for (std::size_t i = 0; i != nSamples; ++i) {
-		wir[i] *= h.L (FM::column(S,i));
+	if (copies.empty()) {
+		const std::size_t nSamples = S.size2();
+		for (std::size_t i = 0; i != nSamples; ++i) {
+			wir[i] *= h.L (FM::column(S,i));
+		}
+	}
+	else {				// Likelihood once for each run of identical samples
+		std::size_t si = 0;
+		Importance_resampler::Resamples_t::const_iterator ci, ci_end = copies.end();
+		for (ci = copies.begin(); ci != ci_end; ++ci) {
+			const Float l = h.L (FM::column(S,si));
+			const std::size_t run_end = si + *ci;
+			for (; si != run_end; ++si) {
+				wir[si] *= l;
+			}
+		}
 	}
 	wir_update = true;
 }
@@ -311,6 +580,7 @@ void
  * Post: wir fused (multiplicative) particle likelihood weights
  */
 {
+	BAYES_FILTER_TRACE_SPAN("SIR_scheme::observe_likelihood");
 					// Weight Particles. Fused with previous weight
 	Vec::const_iterator lw_end = lw.end();
 	for (Vec::const_iterator lw_i = lw.begin(); lw_i != lw_end; ++lw_i) {
@@ -322,14 +592,22 @@ void
 
 void SIR_scheme::copy_resamples (ColMatrix& P, const Importance_resampler::Resamples_t& presamples)
 /* Update P by selectively copying presamples
+ */
+{
+	copy_resamples (P, presamples, 0);
+}
+
+void SIR_scheme::copy_resamples (ColMatrix& P, const Importance_resampler::Resamples_t& presamples, std::size_t first)
+/* Update columns first..first+presamples.size() of P by selectively copying presamples
  * Uses a in-place copying algorithm
  * Algorithm: In-place copying
  *  First copy the live samples (those resampled) to end of P
  *  Replicate live sample in-place
  */
 {
+	const std::size_t last = first + presamples.size();
 							// reverse_copy_if live
-	std::size_t si = P.size2(), livei = si;
+	std::size_t si = last, livei = si;
 	Importance_resampler::Resamples_t::const_reverse_iterator pri, pri_end = presamples.rend();
 	for (pri = presamples.rbegin(); pri != pri_end; ++pri) {
 		--si;
@@ -338,9 +616,8 @@ void SIR_scheme::copy_resamples (ColMatrix& P, const Importance_resampler::Resam
 			noalias(FM::column(P,livei)) = FM::column(P,si);
 		}
 	}
-	assert (si == 0);
+	assert (si == first);
 							// Replicate live samples
-	si = 0;
 	Importance_resampler::Resamples_t::const_iterator pi, pi_end = presamples.end();
 	for (pi = presamples.begin(); pi != pi_end; ++pi) {
 		std::size_t res = *pi;
@@ -352,7 +629,7 @@ void SIR_scheme::copy_resamples (ColMatrix& P, const Importance_resampler::Resam
 			++livei;
 		}
 	}
-	assert (si == P.size2()); assert (livei == P.size2());
+	assert (si == last); assert (livei == last);
 }
 
 
@@ -413,6 +690,321 @@ void SIR_scheme::roughen_minmax (ColMatrix& P, Float K) const
 }
 
 
+/*
+ * Island model SIR filter
+ */
+class Island_pool
+/* Persistent threads to apply a function to each island
+ *  Island k > 0 is run on thread k-1, island 0 is run by the caller of run
+ *  Copies of an Island_SIR_scheme share its pool. Runs are serialised so copies may resample from
+ *  different threads, one at a time. run is not reentrant: the function must not run the same pool
+ */
+{
+public:
+	typedef std::function<void (std::size_t)> Island_function;
+
+	Island_pool (std::size_t islands) : job(0), job_filter(0), generation(0), pending(0), stop(false), failed(islands)
+	{
+		threads.reserve (islands - 1);
+		for (std::size_t k = 1; k < islands; ++k)
+			threads.push_back (std::thread( [this, k] () { work (k); }));
+	}
+	~Island_pool ()
+	{
+		{	std::lock_guard<std::mutex> lock(m);
+			stop = true;
+		}
+		start.notify_all();
+		for (std::vector<std::thread>::iterator ti = threads.begin(); ti != threads.end(); ++ti)
+			ti->join();
+	}
+
+	void run (const Island_function& f)
+	/* Apply f to each island concurrently, waits for any other run to complete
+	 * Exceptions:
+	 *  the exception of the first island that failed is rethrown once all islands are complete
+	 */
+	{
+		std::unique_lock<std::mutex> serial(running, std::defer_lock);
+		{	BAYES_FILTER_TRACE_SPAN("Island_pool::wait_run");
+			serial.lock();
+		}
+		{	std::lock_guard<std::mutex> lock(m);
+			job = &f;
+			job_filter = Trace::filter();
+			pending = threads.size();
+			++generation;
+		}
+		start.notify_all();
+		try {
+			BAYES_FILTER_TRACE_SPAN("Island_pool::island");
+			f(0);
+		}
+		catch (...) {
+			failed[0] = std::current_exception();
+		}
+		{	BAYES_FILTER_TRACE_SPAN("Island_pool::wait_done");
+			std::unique_lock<std::mutex> lock(m);
+			done.wait (lock, [this] () { return pending == 0; });
+			job = 0;
+		}
+		std::exception_ptr first;
+		for (std::vector<std::exception_ptr>::iterator fi = failed.begin(); fi != failed.end(); ++fi) {
+			if (*fi && !first)
+				first = *fi;
+			*fi = std::exception_ptr();
+		}
+		if (first)
+			std::rethrow_exception (first);
+	}
+
+private:
+	void work (std::size_t k)
+	{
+		std::size_t done_generation = 0;
+		std::unique_lock<std::mutex> lock(m);
+		for (;;) {
+			{	BAYES_FILTER_TRACE_SPAN("Island_pool::wait_start");
+				start.wait (lock, [this, done_generation] () { return stop || generation != done_generation; });
+			}
+			if (stop)
+				return;
+			done_generation = generation;
+			const Island_function* f = job;
+			const std::uint64_t filter = job_filter;
+			lock.unlock();
+			try {
+				Trace::Filter_scope scope(filter);		// Spans of the island are of the filter that ran it
+				BAYES_FILTER_TRACE_SPAN("Island_pool::island");
+				(*f)(k);
+			}
+			catch (...) {
+				failed[k] = std::current_exception();
+			}
+			lock.lock();
+			if (--pending == 0)
+				done.notify_one();
+		}
+	}
+
+	std::mutex running;				// Held for each run
+	std::mutex m;
+	std::condition_variable start, done;
+	const Island_function* job;		// Function of the current run
+	std::uint64_t job_filter;		// Trace filter id of the thread of the current run
+	std::size_t generation;			// Number of runs started
+	std::size_t pending;			// Threads yet to complete the current run
+	bool stop;
+	std::vector<std::exception_ptr> failed;
+	std::vector<std::thread> threads;
+};
+
+namespace {
+
+template <class Island_function>
+void for_each_island (std::size_t islands, Island_pool* pool, const Island_function& f)
+/* Apply f to each island, concurrently if there is a pool
+ */
+{
+	if (pool)
+		pool->run (f);
+	else {
+		for (std::size_t k = 0; k != islands; ++k)
+			f(k);
+	}
+}
+
+}//namespace
+
+Island_SIR_scheme::Island_SIR_scheme (std::size_t x_size, std::size_t s_size, std::size_t islands, SIR_random& random_helper) :
+		Sample_state_filter (x_size, s_size),
+		SIR_scheme (x_size, s_size, random_helper),
+		island_begin(islands + 1), island_resamples(islands), island_unique(islands), island_lcond(islands), island_weight(islands)
+/* Initialise filter and split samples into islands of equal size
+ */
+{
+	if (islands == 0 || islands > s_size)
+		error (Logic_exception("Island_SIR_scheme requires 0 < islands <= samples"));
+	island_wir.reserve (islands);
+	for (std::size_t k = 0; k <= islands; ++k)
+		island_begin[k] = k * s_size / islands;
+	for (std::size_t k = 0; k != islands; ++k) {
+		const std::size_t n = island_begin[k+1] - island_begin[k];
+		island_resamples[k].resize (n);
+		island_wir.push_back (FM::DenseVec(n));
+	}
+	exchange = ring;
+	exchange_size = 1;
+	exchange_interval = 1;
+	resamples_since_exchange = 0;
+}
+
+void Island_SIR_scheme::parallel (const std::vector<SIR_random*>& island_random)
+{
+	if (!island_random.empty() && island_random.size() != islands())
+		error (Logic_exception("Island_SIR_scheme requires a random helper for each island"));
+	Island_SIR_scheme::island_random = island_random;
+	pool.reset ();			// Join any previous threads before starting new threads
+	if (!island_random.empty())
+		pool.reset (new Island_pool(islands()));
+}
+
+Island_SIR_scheme::Float
+ Island_SIR_scheme::update_resample (const Importance_resampler& resampler)
+/* Resample each island using its weights, exchange and roughen
+ * Pre : S represent the predicted distribution
+ * Post: S represent the fused distribution, wir the island weights W_k/N_k normalised to a mean of 1
+ * Exceptions:
+ *  Bayes_filter_exception from resampler of any island
+ *  Numeric_exception if all islands have zero weight
+ *    unchanged: S, stochastic_samples
+ * Return
+ *  lcond, Smallest normalised weight of any island, 0 if any island had zero weight
+ *  lcond == 1 if no resampling performed
+ */
+{
+	BAYES_FILTER_TRACE_SPAN("Island_SIR_scheme::update_resample");
+	if (!wir_update)		// Resampling only required if weights have been updated
+		return 1;
+
+	const bool concurrent = !island_random.empty();
+						// Resample each island with non zero weight, no changes to S until all succeed
+	for_each_island (islands(), pool.get(), [this, &resampler, concurrent] (std::size_t k) {
+		FM::DenseVec& w = island_wir[k];
+		const std::size_t begin = island_begin[k];
+		Float wsum = 0;
+		for (std::size_t i = 0, n = w.size(); i != n; ++i) {
+			w[i] = wir[begin + i];
+			wsum += w[i];
+		}
+		island_weight[k] = wsum;
+		if (std::find_if (w.begin(), w.end(), [] (Float wi) { return wi != 0; }) == w.end()) {
+			island_weight[k] = 0;	// Zero or empty: refilled from the heaviest island
+			island_lcond[k] = 0;
+			island_unique[k] = 0;
+		}
+		else
+			island_lcond[k] = resampler.resample (island_resamples[k], island_unique[k], w, concurrent ? *island_random[k] : random);
+	});
+						// Heaviest island refills the zero weight islands
+	std::size_t heaviest = 0;
+	Float wtotal = 0;
+	for (std::size_t k = 0; k != islands(); ++k) {
+		if (island_weight[k] > island_weight[heaviest])
+			heaviest = k;
+		wtotal += island_weight[k];
+	}
+	if (!(wtotal > 0))		// All islands zero
+		error (Numeric_exception("total likelihood zero"));
+						// No resampling exceptions: update S
+	for_each_island (islands(), pool.get(), [this] (std::size_t k) {
+		if (island_weight[k] != 0)
+			copy_resamples (S, island_resamples[k], island_begin[k]);
+	});
+
+	Float lcond = 1;
+	stochastic_samples = 0;
+	std::size_t refilled = 0;			// Samples refilled from the heaviest island
+	for (std::size_t k = 0; k != islands(); ++k) {
+		lcond = std::min(lcond, island_lcond[k]);
+		stochastic_samples += island_unique[k];
+		if (island_weight[k] == 0) {
+			const std::size_t begin = island_begin[k], n = island_begin[k+1] - begin;
+			const std::size_t hbegin = island_begin[heaviest], hn = island_begin[heaviest+1] - hbegin;
+			for (std::size_t i = 0; i != n; ++i)
+				noalias(FM::column(S, begin + i)) = FM::column(S, hbegin + i % hn);
+			refilled += n;
+		}
+	}
+						// Island weights shared by their resamples, normalised to a mean weight of 1
+	const Float wscale = Float(S.size2()) / wtotal;
+	for (std::size_t k = 0; k != islands(); ++k) {
+		const std::size_t begin = island_begin[k], n = island_begin[k+1] - begin;
+		Float wi;
+		if (island_weight[k] == 0)
+			wi = island_weight[heaviest] / Float(island_begin[heaviest+1] - island_begin[heaviest] + refilled);
+		else if (k == heaviest)
+			wi = island_weight[k] / Float(n + refilled);
+		else
+			wi = island_weight[k] / Float(n);
+		std::fill (wir.begin() + begin, wir.begin() + begin + n, wi * wscale);
+	}
+
+	bool exchanged = false;
+	if (exchange_interval != 0 && islands() > 1 && ++resamples_since_exchange >= exchange_interval) {
+		exchange_samples ();
+		resamples_since_exchange = 0;
+		exchanged = true;
+	}
+						// Runs of identical samples, only without exchange or roughening
+	copies.clear();
+	if (!exchanged && refilled == 0 && rougheningK == 0) {
+		for (std::size_t k = 0; k != islands(); ++k) {
+			Importance_resampler::Resamples_t::const_iterator pi, pi_end = island_resamples[k].end();
+			for (pi = island_resamples[k].begin(); pi != pi_end; ++pi) {
+				if (*pi > 0)
+					copies.push_back (*pi);
+			}
+		}
+	}
+
+	roughen ();			// Roughen samples
+
+	wir_update = false;
+	return lcond;
+}
+
+void Island_SIR_scheme::exchange_samples ()
+/* Exchange samples between islands
+ *  Each island sends exchange_size samples, evenly spaced through the island, to its destination island
+ *  where they replace the samples at the same spacing. Samples keep their weights
+ */
+{
+	const std::size_t K = islands();
+	std::vector<std::size_t> dest(K);
+	for (std::size_t k = 0; k != K; ++k)
+		dest[k] = (k + 1) % K;
+	if (exchange == random_pairs) {
+		std::vector<std::size_t> order(K);		// Random permutation of islands
+		for (std::size_t k = 0; k != K; ++k)
+			order[k] = k;
+		FM::DenseVec u(K);
+		random.uniform_01 (u);
+		for (std::size_t k = K-1; k > 0; --k)
+			std::swap (order[k], order[std::min(std::size_t(u[k] * Float(k+1)), k)]);
+		for (std::size_t k = 0; k != K; ++k)	// Unpaired island keeps its samples
+			dest[order[k]] = order[k];
+		for (std::size_t k = 0; k+1 < K; k += 2) {
+			dest[order[k]] = order[k+1];
+			dest[order[k+1]] = order[k];
+		}
+	}
+
+	std::size_t m = exchange_size;			// Samples sent by each island, limited by smallest island
+	for (std::size_t k = 0; k != K; ++k)
+		m = std::min(m, island_begin[k+1] - island_begin[k]);
+	if (m == 0)
+		return;
+						// Gather samples sent by each island before any are replaced
+	FM::ColMatrix sent(S.size1(), K * m);
+	FM::DenseVec sent_w(K * m);
+	for (std::size_t k = 0; k != K; ++k) {
+		const std::size_t begin = island_begin[k], n = island_begin[k+1] - begin;
+		for (std::size_t j = 0; j != m; ++j) {
+			noalias(FM::column(sent, k*m + j)) = FM::column(S, begin + j*n/m);
+			sent_w[k*m + j] = wir[begin + j*n/m];
+		}
+	}
+	for (std::size_t k = 0; k != K; ++k) {
+		const std::size_t begin = island_begin[dest[k]], n = island_begin[dest[k]+1] - begin;
+		for (std::size_t j = 0; j != m; ++j) {
+			noalias(FM::column(S, begin + j*n/m)) = FM::column(sent, k*m + j);
+			wir[begin + j*n/m] = sent_w[k*m + j];
+		}
+	}
+}
+
+
 /*
  * SIR implementation of a Kalman filter
  */
@@ -421,6 +1013,7 @@ SIR_kalman_scheme::SIR_kalman_scheme (std::size_t x_size, std::size_t s_size, SI
 	SIR_scheme (x_size, s_size, random_helper),
 	roughen_model (x_size,x_size, random_helper)
 {
+	x_required = X_required = true;
 }
 
 void SIR_kalman_scheme::init ()
@@ -448,6 +1041,17 @@ void SIR_kalman_scheme::init ()
 	predict (roughen_model);
 
 	SIR_scheme::init_S ();
+	x_required = X_required = false;	// x,X are the initial statistics
+}
+
+void SIR_kalman_scheme::init_S ()
+/* Initialise sampling
+ *	Pre: S
+ *	Post: S, x,X required
+ */
+{
+	SIR_scheme::init_S ();
+	x_required = X_required = true;
 }
 
 
@@ -471,14 +1075,15 @@ void SIR_kalman_scheme::mean ()
 Bayes_base::Float
  SIR_kalman_scheme::update_resample (const Importance_resampler& resampler)
 /* Modified SIR_scheme update implementation
- *  update mean and covariance of sampled distribution with update_statistics
+ *  mean and covariance of sampled distribution are required, they are computed by sample_x, sample_X
  * Normal numerical circumstances (such as all identical samples)
  * may lead to illconditioned X which is not PSD when factorised.
  */
 {
+	BAYES_FILTER_TRACE_SPAN("SIR_kalman_scheme::update_resample");
 	Float lcond = SIR_scheme::update_resample(resampler);	// Resample particles
 
-	update_statistics();			// Estimate sample mean and covariance
+	x_required = X_required = true;	// Sample mean and covariance when required
 
 	return lcond;
 }
@@ -498,14 +1103,34 @@ void SIR_kalman_scheme::update_statistics ()
  */
 {
     mean ();
-    X.clear();              // Covariance
+    FM::assign_sample_covariance (X, S, x);	// Covariance
+    x_required = X_required = false;
+}
 
-	const std::size_t nSamples = S.size2();
-	for (std::size_t i = 0; i != nSamples; ++i) {
-		FM::ColMatrix::Column Si(S,i);
-		X.plus_assign (FM::outer_prod(Si-x, Si-x));
+const FM::Vec& SIR_kalman_scheme::sample_x ()
+/* Sample mean
+ *  Pre : S
+ *  Post: x
+ */
+{
+	if (x_required) {
+		mean ();
+		x_required = false;
+	}
+	return x;
+}
+
+const FM::SymMatrix& SIR_kalman_scheme::sample_X ()
+/* Sample covariance, see update_statistics
+ *  Pre : S
+ *  Post: x,X
+ */
+{
+	if (X_required) {
+		FM::assign_sample_covariance (X, S, sample_x());
+		X_required = false;
 	}
-	X /= Float(nSamples);
+	return X;
 }
 
 
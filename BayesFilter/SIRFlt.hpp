@@ -40,6 +40,9 @@
  *   for these samples.
  */
 #include "bayesFlt.hpp"
+#include <boost/shared_ptr.hpp>
+#include <cstdint>
+#include <map>
 
 /* Filter namespace */
 namespace Bayesian_filter
@@ -56,6 +59,43 @@ struct SIR_random
 	virtual ~SIR_random () {}
 };
 
+class Sobol_SIR_random : public SIR_random
+/*
+ * Randomised quasi-Monte Carlo random helper
+ *  Each call returns the next point of a scrambled Sobol sequence with one dimension per element of v.
+ *  normal applies the inverse normal distribution to the point.
+ *  Within a helper there is an independent stream for each size of v and each distribution, so the
+ *  roughening and resampling of one scheme draw from separate sequences. Streams are not otherwise
+ *  distinguished by their consumer: each consumer, such as a scheme and each sampled predict model,
+ *  should have its own helper with a distinct stream number. Consumers sharing a helper and drawing
+ *  vectors of the same size interleave their points in one sequence.
+ *  Vectors larger then max_dimension are filled with a scrambled stratified set in one dimension,
+ *  as required for resampling.
+ * Scrambling is the hashed nested uniform scramble of [4]. The sequence depends only on the seed and
+ * stream number, so separate threads using different stream numbers are reproducible.
+ * Reference
+ *  [4] "Practical Hash-based Owen Scrambling"
+ *   B Burley Journal of Computer Graphics Techniques Vol.9 No.4 2020
+ */
+{
+public:
+	Sobol_SIR_random (unsigned seed = 0, unsigned stream = 0);
+	void normal (FM::DenseVec& v);
+	void uniform_01 (FM::DenseVec& v);
+
+	static const std::size_t max_dimension = 16;
+private:
+	struct Stream
+	{
+		std::uint32_t seed;
+		std::uint32_t index;	// Index of next point
+	};
+	Stream& stream (std::size_t size, bool normal);
+	void point (Stream& s, FM::DenseVec& v);
+	std::uint32_t base_seed;
+	std::map<std::pair<std::size_t, bool>, Stream> streams;
+};
+
 
 class Importance_resampler : public Bayes_base
 /*
@@ -103,7 +143,7 @@ public:
 
 
 template <class Predict_model>
-class Sampled_general_predict_model: public Predict_model, public Sampled_predict_model
+class Sampled_general_predict_model: public Predict_model, public Sampled_additive_predict_model
 /*
  * Generalise a predict model to sampled predict model using and SIR random
  *  To instantiate template std::sqrt is required
@@ -112,7 +152,7 @@ class Sampled_general_predict_model: public Predict_model, public Sampled_predic
 public:
 	Sampled_general_predict_model (std::size_t x_size, std::size_t q_size, SIR_random& random_helper) :
 		Predict_model(x_size, q_size),
-		Sampled_predict_model(),
+		Sampled_additive_predict_model(),
 		genn(random_helper),
 		xp(x_size),
 		n(q_size), rootq(q_size)
@@ -126,11 +166,20 @@ public:
 	 *  Generate Gaussian correlated samples
 	 * Precond: init_GqG, automatic on first use
 	 */
+	{
+		return add_w (fd(x));
+	}
+
+	virtual const FM::Vec& fd(const FM::Vec& x) const
+	{						// Predict state using supplied functional predict model
+		return Predict_model::f(x);
+	}
+
+	virtual const FM::Vec& add_w(const FM::Vec& fdx) const
 	{
 		if (first_init)
 			init_GqG();
-							// Predict state using supplied functional predict model
-		xp = Predict_model::f(x);
+		xp = fdx;
 							// Additive random noise
 		genn.normal(n);				// Independent zero mean normal
 									// multiply elements by std dev
@@ -175,6 +224,13 @@ class SIR_scheme : public Sample_filter
  *  Importance resampling is delayed until an update is required. The sampler used
  *  is a parameter of update to allow a wide variety of usage.
  *  A stochastic sample is defined as a sample with a unqiue stochastic history other then roughening
+ *
+ *  Without roughening, resampling leaves runs of identical samples in S. Their lengths are kept in
+ *  copies so predict evaluates the deterministic part of a model once for each run. This optimisation
+ *  only applies after an update_resample with rougheningK == 0, otherwise copies is empty and every
+ *  sample is predicted.
+ *  Precond: S modified other than by the scheme must be followed by init_S, which clears copies,
+ *  before the next predict. Otherwise predict would overwrite samples with their runs' first sample.
  */
 {
 	friend class SIR_kalman_scheme;
@@ -198,12 +254,12 @@ public:
 	 *  Return: lcond
 	 */
 
-	void predict (Functional_predict_model& f)
+	void predict (Functional_predict_model& f);
 	// Predict samples without noise
-	{	Sample_filter::predict (f);
-	}
 	void predict (Sampled_predict_model& f);
 	// Predict samples with noise model
+	void predict (Sampled_additive_predict_model& f);
+	// Predict samples with additive noise model, deterministic part once for identical samples
 
 	void observe (Likelihood_observe_model& h, const FM::Vec& z);
 	// Weight particles using likelihood model h and z
@@ -215,12 +271,16 @@ public:
 	virtual void roughen()
 	// Generalised roughening:  Default to roughen_minmax
 	{
-		if (rougheningK != 0)
+		if (rougheningK != 0) {
 			roughen_minmax (S, rougheningK);
+			copies.clear();		// Samples are no longer identical
+		}
 	}
 
 	static void copy_resamples (FM::ColMatrix& P, const Importance_resampler::Resamples_t& presamples);
 	// Update P by selectively copying based on presamples 
+	static void copy_resamples (FM::ColMatrix& P, const Importance_resampler::Resamples_t& presamples, std::size_t first);
+	// Update columns of P starting at first by selectively copying based on presamples
 
 	SIR_random& random;			// Reference random number generator helper
 
@@ -229,17 +289,92 @@ protected:
 	Importance_resampler::Resamples_t resamples;		// resampling counts
 	FM::DenseVec wir;			// resamping weights
 	bool wir_update;			// weights have been updated requring a resampling on update
+	Importance_resampler::Resamples_t copies;	// Number of consecutive identical samples in S, empty if not known
+												// A roughen which modifies S must clear copies
 private:
 	static const Float rougheningKinit;
 	std::size_t x_size;
 };
 
 
+class Island_pool;
+
+class Island_SIR_scheme : public SIR_scheme
+/*
+ * Island model SIR filter
+ *  The samples S are split into a number of contiguous islands which are resampled independently.
+ *  Resampling within islands is a local operation so islands may be resampled concurrently,
+ *  each with its own random helper.
+ *  Islands are resampled to their own size irrespective of the total weight of the island,
+ *  the resampling with non-proportional allocation of [3]. The total weight W_k of island k is kept
+ *  by giving each of its N_k resamples the weight W_k/N_k in wir, so after resampling the weights
+ *  are uniform within each island but not between islands. Islands are kept mixed
+ *  by periodically exchanging samples, with their weights, between islands.
+ *  An island with zero total weight cannot be resampled, it is refilled with copies of the resamples
+ *  of the heaviest island which then share that island's weight.
+ *  Concurrent resampling uses a pool of threads, one for each island but the first, which persists
+ *  until parallel is called again or the scheme is destroyed.
+ *  Copies of the scheme share the pool, which serialises their concurrent resampling. parallel gives a
+ *  copy its own pool and island random helpers. As for any SIR_scheme, copies updated from different
+ *  threads also require random helpers which may be used concurrently.
+ *  To callers the islands are a single Sample_filter with samples S weighted by weights().
+ * Reference
+ *  [3] "Resampling Algorithms and Architectures for Distributed Particle Filters"
+ *   M Bolic, PM Djuric, S Hong IEEE Trans. Signal Processing Vol.53 No.7 July 2005
+ */
+{
+public:
+	Island_SIR_scheme (std::size_t x_size, std::size_t s_size, std::size_t islands, SIR_random& random_helper);
+	// Precondition: 0 < islands <= s_size
+
+	void parallel (const std::vector<SIR_random*>& island_random);
+	// Resample islands concurrently using a random helper for each island. Empty for sequential resampling with random
+
+	enum Exchange_topology {ring, random_pairs};
+	Exchange_topology exchange;		// Islands which exchange samples
+	std::size_t exchange_size;		// Samples sent by each island in an exchange
+	std::size_t exchange_interval;	// Number of resampling updates between exchanges, 0 for no exchange
+
+	Float update_resample ()
+	// Default resampling update
+	{	return update_resample (Standard_resampler());
+	}
+	Float update_resample (const Importance_resampler& resampler);
+	/* Update: resample each island using weights, exchange and then roughen
+	 *  Return: lcond, the worst conditioning of any island, 0 if an island had zero weight
+	 */
+
+	std::size_t islands () const
+	{	return island_begin.size() - 1;
+	}
+	const FM::DenseVec& weights () const
+	// Weights of the samples S, the island weights after resampling
+	{	return wir;
+	}
+
+private:
+	void exchange_samples ();
+	std::vector<std::size_t> island_begin;	// First sample of each island, and one past the last sample
+	std::vector<Importance_resampler::Resamples_t> island_resamples;
+	std::vector<FM::DenseVec> island_wir;
+	std::vector<std::size_t> island_unique;
+	std::vector<Float> island_lcond;
+	std::vector<Float> island_weight;		// Total weight of each island before resampling
+	std::vector<SIR_random*> island_random;	// Empty for sequential resampling
+	boost::shared_ptr<Island_pool> pool;	// Threads for concurrent resampling, empty for sequential
+	std::size_t resamples_since_exchange;
+};
+
+
 class SIR_kalman_scheme : public SIR_scheme, virtual public Kalman_state_filter
 /*
  * SIR implementation of a Kalman filter
  *  Updates Kalman statistics of SIR_filter
  *  These statistics are use to provide a specialised correlated roughening procedure
+ * Lazy statistics
+ *  predict, update_resample and init_S change the samples without computing x,X. The statistics are computed
+ *  when required by update, sample_x, sample_X or update_statistics. Read x,X through the accessors
+ *  after update_resample. Writing x,X remains compatible: init samples from x,X which are then current.
  */
 {
 public:
@@ -249,10 +384,28 @@ public:
 
 	void init ();
 
+	void init_S ();
+	// Initialise sampling, x,X are then computed from S when required
+
 	void update ()
-	// Implement Kalman_filter::update identically to SIR_scheme
+	// Implement Kalman_filter::update identically to SIR_scheme, x,X are then the sample statistics
 	{	(void)SIR_scheme::update_resample();
+		(void)sample_X();
+	}
+
+	void predict (Functional_predict_model& f)
+	{	SIR_scheme::predict (f);
+		x_required = X_required = true;
+	}
+	void predict (Sampled_predict_model& f)
+	{	SIR_scheme::predict (f);
+		x_required = X_required = true;
 	}
+	void predict (Sampled_additive_predict_model& f)
+	{	SIR_scheme::predict (f);
+		x_required = X_required = true;
+	}
+	// Predict samples as SIR_scheme, x,X are then required
 
 	Float update_resample ()
 	// Implement identically to SIR_scheme
@@ -265,15 +418,23 @@ public:
 	void update_statistics ();
 	// Update Kalman statistics without resampling
 
+	const FM::Vec& sample_x ();
+	// Sample mean x, computed if the samples have changed
+	const FM::SymMatrix& sample_X ();
+	// Sample covariance X, computed with x if the samples have changed
+
 	void roughen()
 	{	// Specialised correlated roughening
-		if (rougheningK != 0)
+		if (rougheningK != 0) {
 			roughen_correlated (S, rougheningK);
+			copies.clear();		// Samples are no longer identical
+		}
 	}
 
 protected:
 	void roughen_correlated (FM::ColMatrix& P, Float K);	// Roughening using covariance of P distribution
 	Sampled_LiAd_predict_model roughen_model;		// roughening predict
+	bool x_required, X_required;	// x,X are not the statistics of S and must be computed
 private:
 	static Float scaled_vector_square(const FM::Vec& v, const FM::SymMatrix& S);
 	void mean();
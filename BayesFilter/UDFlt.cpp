@@ -15,6 +15,7 @@
  */
 #include "UDFlt.hpp"
 #include "matSup.hpp"
+#include "bayesTrace.hpp"
 #include <boost/limits.hpp>
 
 /* Filter namespace */
@@ -41,6 +42,7 @@ UD_scheme (std::size_t x_size, std::size_t q_maxsize, std::size_t z_initialsize)
 {
 	last_z_size = 0;	// Matrices conform to z_initialsize, they are left Empty if z_initialsize==0
 	observe_size (z_initialsize);
+	update_required = true;	// Not a valid state, init is required before update can be used
 }
 
 UD_scheme&
@@ -52,6 +54,7 @@ UD_scheme&
 	Kalman_state_filter::operator=(a);
 	q_max = a.q_max;
 	UD = a.UD;
+	update_required = a.update_required;
 	return *this;
 }
 
@@ -72,19 +75,27 @@ void
 	UD.sub_matrix(0,x_size, 0,x_size) .assign (X);
 	Float rcond = UdUfactor (UD, x_size);
 	rclimit.check_PSD(rcond, "Initial X not PSD");
+	update_required = false;
 }
 
 
 void
  UD_scheme::update ()
 /* Defactor UD back into X
+ *  Optimised using update_required (postcondition met iff update_required false)
+ *  x is maintained by predict and observe so only X requires recomposition
  * Precond:
  *  UD
  * Postcond:
  *  X=UD  PSD iff UD is PSD
  */
 {
-	UdUrecompose (X, UD);
+	BAYES_FILTER_TRACE_SPAN("UD_scheme::update");
+	if (update_required)
+	{
+		UdUrecompose (X, UD);
+		update_required = false;
+	}
 }
 
 
@@ -98,6 +109,7 @@ UD_scheme::Float
  *  UD is PSD
  */
 {
+	BAYES_FILTER_TRACE_SPAN("UD_scheme::predict");
 	x = f.f(x);			// Extended Kalman state predict is f(x) directly
 
 						// Predict UD from model
@@ -128,6 +140,7 @@ UD_scheme::Float
 					// Check preallocated space for q size
 	if (Nq > q_max)
 		error (Logic_exception("Predict model q larger than preallocated space"));
+	update_required = true;
 
 	if (n > 0)		// Simplify reverse loop termination
 	{
@@ -254,9 +267,9 @@ void
 	if (z_size != last_z_size) {
 		last_z_size = z_size;
 
-		s.resize(z_size, false);
-		Sd.resize(z_size, false);
-		znorm.resize(z_size, false);
+		s_cache.exchange (s, z_size);
+		Sd_cache.exchange (Sd, z_size);
+		znorm_cache.exchange (znorm, z_size);
 	}
 }
 
@@ -275,6 +288,7 @@ Bayes_base::Float
  * Return: Minimum rcond of all sequential observe
  */
 {
+	BAYES_FILTER_TRACE_SPAN("UD_scheme::observe");
 	const std::size_t z_size = z.size();
 	Float s, S;			// Innovation and covariance
 
@@ -310,6 +324,7 @@ Bayes_base::Float
 /* No solution for Correlated noise and Linearised model
  */
 {
+	BAYES_FILTER_TRACE_SPAN("UD_scheme::observe");
 	error (Logic_exception("observe no Linrz_correlated_observe_model solution"));
 	return 0;	// never reached
 }
@@ -328,6 +343,7 @@ Bayes_base::Float
  * Return: Minimum rcond of all sequential observe
  */
 {
+	BAYES_FILTER_TRACE_SPAN("UD_scheme::observe");
 	std::size_t i, j, k;
 	const std::size_t x_size = x.size();
 	const std::size_t z_size = z.size();
@@ -336,9 +352,9 @@ Bayes_base::Float
 					// Dynamic sizing
 	observe_size (z_size);
 	if (z_size != zpdecol.size()) {
-		zpdecol.resize(z_size, false);
-		Gz.resize(z_size,z_size, false);
-		GIHx.resize(z_size, x_size, false);
+		zpdecol_cache.exchange (zpdecol, z_size);
+		Gz_cache.exchange (Gz, z_size,z_size);
+		GIHx_cache.exchange (GIHx, z_size, x_size);
 	}
 
 					// Factorise process noise as GzG'
@@ -408,6 +424,7 @@ Bayes_base::Float
  * Return: Minimum rcond of all sequential observe
  */
 {
+	BAYES_FILTER_TRACE_SPAN("UD_scheme::observe");
 	std::size_t o;
 	const std::size_t z_size = z.size();
 	Float s, S;			// Innovation and covariance
@@ -465,6 +482,7 @@ UD_scheme::Float
 	Float gamma, alpha_jm1, lamda;
 	// a(n) is U'a
 	// b(n) is Unweighted Kalman gain
+	update_required = true;
 
 					// Compute b = DU'h, a = U'h
 	a = h;
@@ -77,6 +77,7 @@ public:
 	/* Special Linrz observe using fast sequential model */
 
 protected:
+	bool update_required;	// Postcondition of update is not met
 	Float predictGq (const FM::Matrix& Fx, const FM::Matrix& G, const FM::Vec& q);
 	FM::Vec d, dv, v;	// predictGQ temporaries
 	Float observeUD (FM::Vec& gain, Float& alpha, const FM::Vec& h, const Float r);
@@ -90,6 +91,8 @@ protected:
 	FM::Vec zpdecol;		// Decorrelated zp
 	FM::Matrix Gz;			// Z coupling
 	FM::Matrix GIHx;		// Modified Model for linear decorrelation
+	FM::Size_cache<FM::Vec> s_cache, Sd_cache, znorm_cache, zpdecol_cache;
+	FM::Size_cache<FM::Matrix> Gz_cache, GIHx_cache;
 };
 
 
@@ -22,8 +22,15 @@
  */
 #include "bayesFlt.hpp"
 #include "matSup.hpp"
+#include "bayesTrace.hpp"
 #include <cassert>
 #include <cmath>
+#ifdef BAYES_FILTER_LAPACK
+#include "uLAPACK.hpp"
+#endif
+#ifdef BAYES_FILTER_ALIGNED
+#include "uEigen.hpp"
+#endif
 
 /* Filter Matrix Namespace */
 namespace Bayesian_filter_matrix
@@ -257,12 +264,98 @@ Negative:
 }
 
 
+#ifdef BAYES_FILTER_ALIGNED
+namespace {
+
+bool UdUfactor_vectorised (RowMatrix& M, std::size_t n)
+/* UdUfactor_variant2 with the inner loops of each column as a vectorised matrix-vector product
+ *  Column j: M(0..j,j) -= M(0..j,j+1..n) * (d(j+1..n) .* M(j,j+1..n)'), then scaled by the new d(j)
+ * Return:
+ *    false iff M is negative
+ */
+{
+	EIGEN::map_t MM = EIGEN::view(M);
+	Eigen::Map<EIGEN::vector_t> work = EIGEN::workspace (2*n);
+	std::size_t j = n-1;
+	do {
+		const std::size_t t = n-1-j;		// Elements right of the diagonal
+		const RowMatrix::value_type d = MM(j,j);
+		if (d > 0)
+		{	// Positive definite
+			Eigen::Map<EIGEN::vector_t> w(work.data(), t), e(work.data()+t, j+1);
+			w = MM.row(j).segment(j+1,t).transpose().cwiseProduct (MM.diagonal().segment(j+1,t));
+			for (std::size_t i = 0; i <= j; ++i)
+				e[i] = MM(i,j) - MM.row(i).segment(j+1,t).dot (w.transpose());
+			const RowMatrix::value_type dj = e[j];
+			MM(j,j) = dj;
+			MM.col(j).head(j) = e.head(j) / dj;
+		}
+		else if (d == 0)
+		{	// Possibly semi-definite, check not negative, whole row must be identically zero
+			if ((MM.row(j).segment(j+1,t).array() != 0).any())
+				return false;
+		}
+		else
+		{	// Negative
+			return false;
+		}
+	} while (j-- > 0);
+	return true;
+}
+
+void UdUinverse_vectorised (RowMatrix& UD)
+/* Invert U of UdUinverse in place, each row by vectorised multiply-adds of the rows below
+ *  Row i of inv(U) = -U(i,i+1..n) - Sum_k>i U(i,k) * inv(U)(k,k+1..n), the rows below are already inverted
+ */
+{
+	EIGEN::map_t U = EIGEN::view(UD);
+	const std::size_t n = UD.size1();
+	Eigen::Map<EIGEN::vector_t> work = EIGEN::workspace (n);
+	std::size_t i = n-2;
+	do {
+		const std::size_t t = n-1-i;
+		Eigen::Map<EIGEN::vector_t> r(work.data(), t);
+		r = -U.row(i).segment(i+1,t).transpose();
+		for (std::size_t k = i+1; k < n-1; ++k)
+			r.tail(n-1-k) -= U(i,k) * U.row(k).segment(k+1,n-1-k).transpose();
+		U.row(i).segment(i+1,t) = r.transpose();
+	} while (i-- > 0);
+}
+
+void UdUrecompose_transpose_vectorised (RowMatrix& M)
+/* UdUrecompose_transpose with each row of the upper triangle as a vectorised matrix-vector product
+ *  Row i of U'dU = Sum_k<i (U(k,i)*d(k)) * U(k,i..n) + d(i) * U(i,i..n)
+ *  Rows are computed from the last so the rows k<i of the factor are unmodified
+ */
+{
+	EIGEN::map_t MM = EIGEN::view(M);
+	const std::size_t n = M.size1();
+	Eigen::Map<EIGEN::vector_t> work = EIGEN::workspace (2*n);
+	std::size_t i = n-1;
+	do {
+		const std::size_t t = n-i;			// Elements of row i in the upper triangle
+		Eigen::Map<EIGEN::vector_t> c(work.data(), i), r(work.data()+n, t);
+		const RowMatrix::value_type di = MM(i,i);
+		c = MM.col(i).head(i).cwiseProduct (MM.diagonal().head(i));
+		r[0] = di;
+		r.tail(t-1) = di * MM.row(i).segment(i+1,t-1).transpose();
+		r.noalias() += MM.block(0,i, i,t).transpose() * c;
+		MM.row(i).segment(i,t) = r.transpose();
+		MM.col(i).segment(i,t) = r;
+	} while (i-- > 0);
+}
+
+}//namespace
+#endif
+
+
 RowMatrix::value_type UdUfactor_variant2 (RowMatrix& M, std::size_t n)
 /* In place modified upper triangular Cholesky factor of a
  *  Positive definite or semi-definite matrix M
  * Reference: A+G p.219 right side of table
  *  Algorithm has good locality of reference and preferable for large matrices
  *  Infinity values on the diagonal cannot be factorised
+ *  With BAYES_FILTER_ALIGNED the columns are computed by the vectorised UdUfactor_vectorised
  *
  * Strict lower triangle of M is ignored in computation
  *
@@ -275,6 +368,10 @@ RowMatrix::value_type UdUfactor_variant2 (RowMatrix& M, std::size_t n)
  *    reciprocal condition number, -1 if negative, 0 if semi-definite (including zero)
  */
 {
+#ifdef BAYES_FILTER_ALIGNED
+	if (n >= aligned_dispatch_size && n > 0)
+		return UdUfactor_vectorised (M, n) ? rcond_internal (diag(M,n)) : -1;
+#endif
 	std::size_t i,j,k;
 	RowMatrix::value_type e, d;
 	if (n > 0)
@@ -327,6 +424,109 @@ Negative:
 }
 
 
+#ifdef BAYES_FILTER_LAPACK
+namespace {
+
+bool potrf_reversed (LAPACK::matrix_t& A, const RowMatrix& M, std::size_t n)
+/* LAPACK Cholesky factor of the reversed leading n by n block of M
+ *  A = P*M*P where P is the reversal permutation, factored as A = R'*R
+ *  Reversal transforms R into an upper triangular W = P*R'*P with M = W*W'
+ *  W is the UdU' factor scaled by sqrt(d): W(i,j) = R(n-1-j,n-1-i), d(j) = W(j,j)^2
+ *  Only the upper triangle of M is referenced
+ * Return:
+ *    true iff LAPACK found M to be PD, A then contains R
+ */
+{
+	for (std::size_t r = 0; r < n; ++r)
+		for (std::size_t c = r; c < n; ++c)
+			A(r,c) = M(n-1-c, n-1-r);
+	return LAPACK::potrf ('U', A) == 0;
+}
+
+bool UdUfactor_potrf (RowMatrix& M, std::size_t n)
+/* In place UdU' factor of a Positive definite matrix M using LAPACK potrf
+ *  The UdU' factor is unique, the result is the same as UdUfactor_variant2 apart from rounding
+ * Output: (iff return true)
+ *    M as UdU' factor, strict_lower_triangle(M) is unmodified
+ * Return:
+ *    true iff LAPACK found M to be PD, otherwise M is unmodified
+ */
+{
+	LAPACK::matrix_t A(n,n);
+	if (!potrf_reversed (A, M, n))
+		return false;
+
+	for (std::size_t j = 0; j < n; ++j)
+	{
+		RowMatrix::value_type w = A(n-1-j,n-1-j);
+		M(j,j) = w*w;
+		for (std::size_t i = 0; i < j; ++i)
+			M(i,j) = A(n-1-j,n-1-i) / w;
+	}
+	return true;
+}
+
+bool UdUinversePD_potri (RowMatrix& M, RowMatrix::value_type& rcond, RowMatrix::value_type& detM)
+/* In place inverse of a Positive Definite matrix M using LAPACK potrf and potri
+ *  d of the UdU' factor is recovered from the Cholesky factor so rcond and detM are
+ *  consistent with UdUinversePD
+ * Output: (iff return true)
+ *    M inverse of M
+ *    rcond reciprocal condition number (>0), detM determinant of original M
+ * Return:
+ *    true iff M is PD, otherwise M is unmodified and UdUfactor is required for rcond
+ */
+{
+	const std::size_t n = M.size1();
+	LAPACK::matrix_t A(n,n);
+	if (!potrf_reversed (A, M, n))
+		return false;
+
+	Vec d(n);
+	RowMatrix::value_type det = 1;
+	for (std::size_t i = 0; i < n; ++i) {
+		d[i] = A(i,i)*A(i,i);
+		det *= d[i];
+	}
+	rcond = rcond_internal (d);
+	if (!(rcond > 0))			// Underflow in d
+		return false;
+
+	if (LAPACK::potri ('U', A) != 0)
+		return false;
+	detM = det;
+								// inv(M) = P*inv(A)*P from upper triangle of inv(A)
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		RowMatrix::Row Mi(M,i);
+		for (std::size_t j = i; j < n; ++j)
+			M(j,i) = Mi[j] = A(n-1-j,n-1-i);
+	}
+	return true;
+}
+
+}//namespace
+#endif
+
+
+#ifdef BAYES_FILTER_LAPACK
+RowMatrix::value_type UdUfactor (RowMatrix& M, std::size_t n)
+/* In place modified upper triangular Cholesky factor of a
+ *  Positive definite or semi-definite matrix M
+ *  See UdUfactor_variant2, which is used other than by the BLAS/LAPACK dispatch
+ *  LAPACK does not factor semi-definite or negative matrices, these are always
+ *  factored by UdUfactor_variant2 to determine the rcond
+ */
+{
+#ifdef BAYES_FILTER_LAPACK
+	if (n >= lapack_dispatch_size && UdUfactor_potrf (M, n))
+		return rcond_internal (diag(M,n));
+#endif
+	return UdUfactor_variant2 (M, n);
+}
+#endif
+
+
 LTriMatrix::value_type LdLfactor (LTriMatrix& M, std::size_t n)
 /* In place modified lower triangular Cholesky factor of a
  *  Positive definite or semi-definite matrix M
@@ -465,6 +665,7 @@ RowMatrix::value_type UdUfactor (RowMatrix& UD, const SymMatrix& M)
  *    see in-place UdUfactor
  */
 {
+	BAYES_FILTER_TRACE_FINE_SPAN("UdUfactor");
 	noalias(UD) = M;
 	RowMatrix::value_type rcond = UdUfactor (UD, M.size1());
 
@@ -483,6 +684,7 @@ LTriMatrix::value_type LdLfactor (LTriMatrix& LD, const SymMatrix& M)
  *    see in-place LdLfactor
  */
 {
+	BAYES_FILTER_TRACE_FINE_SPAN("LdLfactor");
 	noalias(LD) = M;
 	LTriMatrix::value_type rcond = LdLfactor (LD, M.size1());
 
@@ -500,12 +702,72 @@ UTriMatrix::value_type UCfactor (UTriMatrix& UC, const SymMatrix& M)
  *    see in-place UCfactor
  */
 {
+	BAYES_FILTER_TRACE_FINE_SPAN("UCfactor");
 	noalias(UC) = UpperTri(M);
 	UTriMatrix::value_type rcond = UCfactor (UC, UC.size1());
 
 	return rcond;
 }
 
+UTriMatrix::value_type UCtriangularise (UTriMatrix& UC, RowMatrix& A)
+/* Upper triangular factor of the compound matrix A (n x k, k >= n) by Householder triangularisation
+ *  Factorises A*A' without forming it: A*T = [0 UC] for an orthogonal T
+ *  Each row of A, from the last, is reflected onto its last active column.
+ * Input:
+ *    A, destroyed
+ * Output:
+ *    UC the UC*UC' factorisation of A*A', with a non-negative diagonal
+ * Return:
+ *    reciprocal condition number of A*A', as UCrcond
+ */
+{
+	BAYES_FILTER_TRACE_FINE_SPAN("UCtriangularise");
+	const std::size_t n = A.size1(), k = A.size2();
+	assert (k >= n);
+	assert (UC.size1() == n && UC.size2() == n);
+	const std::size_t offset = k - n;
+
+	for (std::size_t i = n; i-- > 0; ) {
+		const std::size_t m = offset + i + 1;		// Active columns of row i
+		RowMatrix::Row Ai = row(A,i);
+						// Householder vector u reflecting Ai[0..m) onto Ai[m-1]
+		Float norm2 = 0;
+		for (std::size_t j = 0; j != m; ++j)
+			norm2 += Ai[j]*Ai[j];
+		const Float norm = std::sqrt(norm2);
+		if (norm == 0)
+			continue;
+		const Float alpha = Ai[m-1] > 0 ? -norm : norm;
+		const Float u_last = Ai[m-1] - alpha;
+		const Float beta = norm2 - Ai[m-1]*Ai[m-1] + u_last*u_last;	// u'*u
+		if (beta == 0)
+			continue;
+						// Apply reflection to rows i..0 (rows below i are already zero in the active columns)
+		for (std::size_t r = i+1; r-- > 0; ) {
+			RowMatrix::Row Ar = row(A,r);
+			Float dot = Ar[m-1] * u_last;
+			for (std::size_t j = 0; j != m-1; ++j)
+				dot += Ar[j] * Ai[j];		// Ai[0..m-1) is u, unmodified until r == i
+			const Float scale = 2 * dot / beta;
+			if (r != i) {
+				for (std::size_t j = 0; j != m-1; ++j)
+					Ar[j] -= scale * Ai[j];
+				Ar[m-1] -= scale * u_last;
+			}
+		}
+		for (std::size_t j = 0; j != m-1; ++j)
+			Ai[j] = 0;
+		Ai[m-1] = alpha;
+	}
+						// Extract UC, negate columns to make the diagonal non-negative
+	for (std::size_t c = 0; c != n; ++c) {
+		const Float sign = A(c, offset+c) < 0 ? -1 : 1;
+		for (std::size_t r = 0; r <= c; ++r)
+			UC(r,c) = sign * A(r, offset+c);
+	}
+	return UCrcond (UC);
+}
+
 
 
 bool UdUinverse (RowMatrix& UD)
@@ -527,6 +789,11 @@ bool UdUinverse (RowMatrix& UD)
 	assert (n == UD.size2());
 
 	// Invert U in place
+#ifdef BAYES_FILTER_ALIGNED
+	if (n >= aligned_dispatch_size && n > 1)
+		UdUinverse_vectorised (UD);
+	else
+#endif
 	if (n > 1)
 	{
 		i = n-2;
@@ -620,6 +887,11 @@ void UdUrecompose_transpose (RowMatrix& M)
 	assert (n == M.size2());
 
 	// Recompose M = (U'dU) in place
+#ifdef BAYES_FILTER_ALIGNED
+	if (n >= aligned_dispatch_size && n > 0)
+		UdUrecompose_transpose_vectorised (M);
+	else
+#endif
 	if (n > 0)
 	{
 		i = n-1;
@@ -827,9 +1099,15 @@ SymMatrix::value_type UdUinversePD (SymMatrix& M)
  *     reciprocal condition number, -1 if negative, 0 if semi-definite (including zero)
  */
 {
+	BAYES_FILTER_TRACE_FINE_SPAN("UdUinversePD");
 					// Abuse as a RowMatrix
 	RowMatrix& M_matrix = M.asRowMatrix();
-	SymMatrix::value_type rcond = UdUfactor (M_matrix, M_matrix.size1());
+#ifdef BAYES_FILTER_LAPACK
+	SymMatrix::value_type lapack_rcond, lapack_detM;
+	if (M_matrix.size1() >= lapack_dispatch_size && UdUinversePD_potri (M_matrix, lapack_rcond, lapack_detM))
+		return lapack_rcond;
+#endif				// Not PD for LAPACK, or not dispatched. UdUfactor_variant2 as potrf need not be repeated
+	SymMatrix::value_type rcond = UdUfactor_variant2 (M_matrix, M_matrix.size1());
 	// Only invert and recompose if PD
 	if (rcond > 0) {
 		bool singular = UdUinverse (M_matrix);
@@ -843,9 +1121,15 @@ SymMatrix::value_type UdUinversePD (SymMatrix& M, SymMatrix::value_type& detM)
 /* As above but also computes determinant of original M if M is PSD
  */
 {
+	BAYES_FILTER_TRACE_FINE_SPAN("UdUinversePD");
 					// Abuse as a RowMatrix
 	RowMatrix& M_matrix = M.asRowMatrix();
-	SymMatrix::value_type rcond = UdUfactor (M_matrix, M_matrix.size1());
+#ifdef BAYES_FILTER_LAPACK
+	SymMatrix::value_type lapack_rcond;
+	if (M_matrix.size1() >= lapack_dispatch_size && UdUinversePD_potri (M_matrix, lapack_rcond, detM))
+		return lapack_rcond;
+#endif
+	SymMatrix::value_type rcond = UdUfactor_variant2 (M_matrix, M_matrix.size1());
 	// Only invert and recompose if PD
 	if (rcond > 0) {
 		detM = UdUdet(M_matrix);
@@ -867,10 +1151,16 @@ SymMatrix::value_type UdUinversePD (SymMatrix& MI, const SymMatrix& M)
  *    reciprocal condition number, -1 if negative, 0 if semi-definite (including zero)
  */
 {
+	BAYES_FILTER_TRACE_FINE_SPAN("UdUinversePD");
 	MI = M;
 					// Abuse as a RowMatrix
 	RowMatrix& MI_matrix = MI.asRowMatrix();
-	SymMatrix::value_type rcond = UdUfactor (MI_matrix, MI_matrix.size1());
+#ifdef BAYES_FILTER_LAPACK
+	SymMatrix::value_type lapack_rcond, lapack_detM;
+	if (MI_matrix.size1() >= lapack_dispatch_size && UdUinversePD_potri (MI_matrix, lapack_rcond, lapack_detM))
+		return lapack_rcond;
+#endif
+	SymMatrix::value_type rcond = UdUfactor_variant2 (MI_matrix, MI_matrix.size1());
 	// Only invert and recompose if PD
 	if (rcond > 0) {
 		bool singular = UdUinverse (MI_matrix);
@@ -884,10 +1174,16 @@ SymMatrix::value_type UdUinversePD (SymMatrix& MI, SymMatrix::value_type& detM,
 /* As above but also computes determinant of original M if M is PSD
  */
 {
+	BAYES_FILTER_TRACE_FINE_SPAN("UdUinversePD");
 	MI = M;
 					// Abuse as a RowMatrix
 	RowMatrix& MI_matrix = MI.asRowMatrix();
-	SymMatrix::value_type rcond = UdUfactor (MI_matrix, MI_matrix.size1());
+#ifdef BAYES_FILTER_LAPACK
+	SymMatrix::value_type lapack_rcond;
+	if (MI_matrix.size1() >= lapack_dispatch_size && UdUinversePD_potri (MI_matrix, lapack_rcond, detM))
+		return lapack_rcond;
+#endif
+	SymMatrix::value_type rcond = UdUfactor_variant2 (MI_matrix, MI_matrix.size1());
 	if (rcond >= 0) {
 		detM = UdUdet (MI_matrix);
 					// Only invert and recompose if PD
@@ -901,4 +1197,213 @@ SymMatrix::value_type UdUinversePD (SymMatrix& MI, SymMatrix::value_type& detM,
 	return rcond;
 }
 
+
+/*
+ * Functions using an existing UdU' factor
+ */
+
+namespace {
+
+template <class V>
+inline void UdUsolve_internal (const RowMatrix& UD, V& x)
+/* In-place solution of UdU' x = b
+ *  Three triangular stages: U y = b, d z = y, U' x = z
+ */
+{
+	const std::size_t n = UD.size1();
+	std::size_t i,k;
+	if (n > 0)
+	{
+						// U y = b, back substitution with unit diagonal
+		i = n-1;
+		do {
+			RowMatrix::const_Row UDi(UD,i);
+			RowMatrix::value_type e = x[i];
+			for (k = i+1; k < n; ++k)
+				e -= UDi[k] * x[k];
+			x[i] = e;
+		} while (i-- > 0);
+						// d z = y
+		for (i = 0; i < n; ++i)
+			x[i] /= UD(i,i);
+						// U' x = z, forward substitution with unit diagonal
+		for (i = 1; i < n; ++i)
+		{
+			RowMatrix::value_type e = x[i];
+			for (k = 0; k < i; ++k)
+				e -= UD(k,i) * x[k];
+			x[i] = e;
+		}
+	}
+}
+
+}//namespace
+
+void UdUsolve (const RowMatrix& UD, Vec& x)
+/* Solve M x = b in-place using the UdU' factor of M
+ * Input:
+ *    UD the UdU' factor of PD matrix M, strict lower triangle is ignored
+ *    x the right hand side b
+ * Output:
+ *    x the solution inv(M)*b
+ */
+{
+	assert (UD.size1() == UD.size2());
+	assert (UD.size1() == x.size());
+	UdUsolve_internal (UD, x);
+}
+
+void UdUsolve_right (const RowMatrix& UD, RowMatrix& B)
+/* Solve X M = B in-place using the UdU' factor of M
+ *  As M is symmetric each row of B is solved independently
+ *  Used to compute gains such as W = X*Hx'*inv(S) without forming inv(S)
+ * Input:
+ *    UD the UdU' factor of PD matrix M, strict lower triangle is ignored
+ *    B the right hand side
+ * Output:
+ *    B the solution B*inv(M)
+ */
+{
+	assert (UD.size1() == UD.size2());
+	assert (UD.size1() == B.size2());
+	const std::size_t m = B.size1();
+#ifdef BAYES_FILTER_LAPACK
+	const std::size_t n = B.size2();
+	if (std::max(m,n) >= lapack_dispatch_size && m > 0 && n > 0)
+	{	// Row major B is seen by BLAS as B', and strict upper triangle of UD as the unit lower triangle of U'
+		const int bn = int(n), bm = int(m);
+		RowMatrix::value_type* Bd = B.data().begin();
+		LAPACK::rawLAPACK::trsm ('L', 'L', 'T', 'U', bn, bm, 1, UD.data().begin(), bn, Bd, bn);	// inv(U)*B'
+		for (std::size_t r = 0; r < m; ++r)
+		{
+			RowMatrix::Row Br(B,r);
+			for (std::size_t i = 0; i < n; ++i)
+				Br[i] /= UD(i,i);
+		}
+		LAPACK::rawLAPACK::trsm ('L', 'L', 'N', 'U', bn, bm, 1, UD.data().begin(), bn, Bd, bn);	// inv(U')*inv(d)*inv(U)*B'
+		return;
+	}
+#endif
+#ifdef BAYES_FILTER_ALIGNED
+	if (std::max(m,UD.size1()) >= aligned_dispatch_size && m > 0 && UD.size1() > 0)
+	{	// Eigen: B*inv(U')*inv(d)*inv(U) by triangular solutions on the right
+		EIGEN::map_t BB = EIGEN::view(B);
+		EIGEN::const_map_t U = EIGEN::view(UD);
+		U.transpose().triangularView<Eigen::UnitLower>().solveInPlace<Eigen::OnTheRight>(BB);
+		BB = BB * U.diagonal().cwiseInverse().asDiagonal();
+		U.triangularView<Eigen::UnitUpper>().solveInPlace<Eigen::OnTheRight>(BB);
+		return;
+	}
+#endif
+	for (std::size_t r = 0; r < m; ++r)
+	{
+		RowMatrix::Row Br(B,r);
+		UdUsolve_internal (UD, Br);
+	}
+}
+
+RowMatrix::value_type UdUmahalanobis (const RowMatrix& UD, Vec& v)
+/* Mahalanobis distance squared v'*inv(M)*v using the UdU' factor of M
+ *  Only the first triangular solve is required: v'*inv(M)*v = y'*inv(d)*y, where U y = v
+ * Input:
+ *    UD the UdU' factor of PD matrix M, strict lower triangle is ignored
+ *    v vector, used as workspace
+ * Output:
+ *    v is destroyed
+ * Return:
+ *    v'*inv(M)*v
+ */
+{
+	assert (UD.size1() == UD.size2());
+	assert (UD.size1() == v.size());
+	const std::size_t n = UD.size1();
+	RowMatrix::value_type p = 0;
+	if (n > 0)
+	{
+		std::size_t i = n-1;
+		do {
+			RowMatrix::const_Row UDi(UD,i);
+			RowMatrix::value_type e = v[i];
+			for (std::size_t k = i+1; k < n; ++k)
+				e -= UDi[k] * v[k];
+			v[i] = e;
+			p += e*e / UDi[i];
+		} while (i-- > 0);
+	}
+	return p;
+}
+
+RowMatrix::value_type UdUlogdet (const RowMatrix& UD)
+/* Natural logarithm of determinant of the original PD
+ *  matrix for which UD is the factor UdU'
+ *  Sum of log(d) avoids the overflow and underflow possible with UdUdet
+ *  Defined to be 0 for 0 size UD
+ */
+{
+	const std::size_t n = UD.size1();
+	assert (n == UD.size2());
+	RowMatrix::value_type logdet = 0;
+	for (std::size_t i = 0; i < n; ++i)	{
+		logdet += std::log (UD(i,i));
+	}
+	return logdet;
+}
+
+void UdUrecompose_inverse (SymMatrix& MI, const RowMatrix& UD)
+/* Inverse of PD matrix M recomposed from its UdU' factor
+ *  Allows an inverse to be computed only when it is actually required
+ * Input:
+ *    UD the UdU' factor of PD matrix M
+ * Output:
+ *    MI inverse of M
+ */
+{
+					// Abuse as a RowMatrix
+	RowMatrix& MI_matrix = MI.asRowMatrix();
+	noalias(MI_matrix) = UD;
+	bool singular = UdUinverse (MI_matrix);
+	assert (!singular); (void)singular;
+	UdUrecompose_transpose (MI_matrix);
+}
+
+RowMatrix::value_type UdUinnovation (RowMatrix& SUD, SymMatrix& S, const RowMatrix& Hx, const SymMatrix& X, const Vec& Zv)
+/* Innovation covariance with uncorrelated noise S = Hx*X*Hx' + diag(Zv) and its factor
+ * Input:
+ *    SUD, S sized as Hx.size1()
+ * Output:
+ *    S innovation covariance, SUD the UdU' factor of S
+ * Return:
+ *    reciprocal condition number of S
+ */
+{
+	RowMatrix temp(Hx.size1(), Hx.size2());
+	assign_prod_SPD (S, Hx, X, temp);
+	for (std::size_t i = 0; i < Zv.size(); ++i)
+		S(i,i) += Zv[i];
+	return UdUfactor (SUD, S);
+}
+
+RowMatrix::value_type UdUinnovation (RowMatrix& SUD, SymMatrix& S, const RowMatrix& Hx, const SymMatrix& X, const SymMatrix& Z)
+/* Innovation covariance with correlated noise S = Hx*X*Hx' + Z and its factor
+ *  See above
+ */
+{
+	RowMatrix temp(Hx.size1(), Hx.size2());
+	assign_prod_SPD (S, Hx, X, temp);
+	noalias(S) += Z;
+	return UdUfactor (SUD, S);
+}
+
+RowMatrix::value_type UdUloglikelihood (const RowMatrix& SUD, RowMatrix::value_type d2)
+/* Log likelihood of an innovation without the constant 2*pi term
+ * Input:
+ *    SUD the UdU' factor of the PD innovation covariance S
+ *    d2 Mahalanobis distance squared of the innovation, see UdUmahalanobis
+ * Return:
+ *    -0.5*(d2 + log(det(S)))
+ */
+{
+	return RowMatrix::value_type(-0.5) * (d2 + UdUlogdet (SUD));
+}
+
 }//namespace
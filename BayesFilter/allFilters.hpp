@@ -18,6 +18,8 @@
 #include "UDFlt.hpp"
 #include "CIFlt.hpp"
 #include "unsFlt.hpp"
+#include "ddfFlt.hpp"
+#include "phdFlt.hpp"
 #include "covFlt.hpp"
 #include "infFlt.hpp"
 #include "infRtFlt.hpp"
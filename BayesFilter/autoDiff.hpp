@@ -0,0 +1,400 @@
+#ifndef _BAYES_FILTER_AUTODIFF
+#define _BAYES_FILTER_AUTODIFF
+
+/*
+ * Bayes++ the Bayesian Filtering Library
+ * Copyright (c) 2002 Michael Stevens
+ * See accompanying Bayes++.htm for terms and conditions of use.
+ *
+ * $Id$
+ */
+
+/*
+ * Forward mode automatic differentiation for Linrz models
+ *  Dual numbers carry a value and its partial derivatives with respect to N states.
+ *  A model function written once, generic in its scalar type, provides both its value
+ *  and Jacobian in a forward pass. There is no need to code Fx or Hx by hand, or to use
+ *  finite differences which require x_size+1 evaluations.
+ *
+ * Model functions are function objects of the form
+ *	struct my_f {
+ *		template <class V>
+ *		void operator() (V& fx, const V& x) const
+ *		{	using std::sin;
+ *			fx[0] = x[0] + sin(x[1]);
+ *			fx[1] = x[1];
+ *		}
+ *	};
+ *  V::value_type is either Float or Dual<N>. fx is correctly sized and all its elements must be assigned.
+ *  Unqualified calls (with using std::xxx) allow the Dual overloads to be found.
+ *
+ * Columns of the Jacobian are computed in chunks of N per pass. Any size of state can be used
+ * and when N is at least the number of states the function depends on a single pass is required.
+ *
+ * Sparsity:
+ *  detect_sparsity finds the states the function structurally depends on. Derivatives are seeded
+ *  with NaN which propagates through all arithmetic, including multiplication by zero. Columns
+ *  of states without any dependence are skipped in later evaluations and left zero.
+ *  The structure found is that of the branches taken by the function at the detection point.
+ */
+#include "bayesFlt.hpp"
+#include <cmath>
+#include <vector>
+#include <limits>
+#include <algorithm>
+
+/* Filter namespace */
+namespace Bayesian_filter
+{
+
+template <std::size_t N>
+class Dual
+/*
+ * Dual number: value and partial derivatives
+ */
+{
+public:
+	typedef FM::Float Float;
+	Float v;		// Value
+	Float d[N];		// Partial derivatives
+
+	Dual ()
+	{}	// Uninitialised
+	Dual (Float value) : v(value)
+	{	// Constant, zero derivatives
+		std::fill (d, d+N, Float(0));
+	}
+
+	Dual& operator+= (const Dual& b)
+	{	v += b.v;
+		for (std::size_t i = 0; i < N; ++i) d[i] += b.d[i];
+		return *this;
+	}
+	Dual& operator-= (const Dual& b)
+	{	v -= b.v;
+		for (std::size_t i = 0; i < N; ++i) d[i] -= b.d[i];
+		return *this;
+	}
+	Dual& operator*= (const Dual& b)
+	{	for (std::size_t i = 0; i < N; ++i) d[i] = d[i]*b.v + v*b.d[i];
+		v *= b.v;
+		return *this;
+	}
+	Dual& operator/= (const Dual& b)
+	{	v /= b.v;
+		for (std::size_t i = 0; i < N; ++i) d[i] = (d[i] - v*b.d[i]) / b.v;
+		return *this;
+	}
+	Dual& operator+= (Float b)
+	{	v += b;
+		return *this;
+	}
+	Dual& operator-= (Float b)
+	{	v -= b;
+		return *this;
+	}
+	Dual& operator*= (Float b)
+	{	v *= b;
+		for (std::size_t i = 0; i < N; ++i) d[i] *= b;
+		return *this;
+	}
+	Dual& operator/= (Float b)
+	{	v /= b;
+		for (std::size_t i = 0; i < N; ++i) d[i] /= b;
+		return *this;
+	}
+};
+
+
+template <std::size_t N> inline
+Dual<N> chain (const Dual<N>& a, FM::Float value, FM::Float derivative)
+/*
+ * Chain rule for a function with the value and derivative at a
+ */
+{
+	Dual<N> r;
+	r.v = value;
+	for (std::size_t i = 0; i < N; ++i) r.d[i] = derivative * a.d[i];
+	return r;
+}
+
+// Arithmetic
+template <std::size_t N> inline Dual<N> operator+ (const Dual<N>& a)
+{	return a;
+}
+template <std::size_t N> inline Dual<N> operator- (const Dual<N>& a)
+{	return chain (a, -a.v, FM::Float(-1));
+}
+template <std::size_t N> inline Dual<N> operator+ (Dual<N> a, const Dual<N>& b)
+{	return a += b;
+}
+template <std::size_t N> inline Dual<N> operator+ (Dual<N> a, FM::Float b)
+{	return a += b;
+}
+template <std::size_t N> inline Dual<N> operator+ (FM::Float a, Dual<N> b)
+{	return b += a;
+}
+template <std::size_t N> inline Dual<N> operator- (Dual<N> a, const Dual<N>& b)
+{	return a -= b;
+}
+template <std::size_t N> inline Dual<N> operator- (Dual<N> a, FM::Float b)
+{	return a -= b;
+}
+template <std::size_t N> inline Dual<N> operator- (FM::Float a, const Dual<N>& b)
+{	return chain (b, a - b.v, FM::Float(-1));
+}
+template <std::size_t N> inline Dual<N> operator* (Dual<N> a, const Dual<N>& b)
+{	return a *= b;
+}
+template <std::size_t N> inline Dual<N> operator* (Dual<N> a, FM::Float b)
+{	return a *= b;
+}
+template <std::size_t N> inline Dual<N> operator* (FM::Float a, Dual<N> b)
+{	return b *= a;
+}
+template <std::size_t N> inline Dual<N> operator/ (Dual<N> a, const Dual<N>& b)
+{	return a /= b;
+}
+template <std::size_t N> inline Dual<N> operator/ (Dual<N> a, FM::Float b)
+{	return a /= b;
+}
+template <std::size_t N> inline Dual<N> operator/ (FM::Float a, const Dual<N>& b)
+{	const FM::Float r = a / b.v;
+	return chain (b, r, -r / b.v);
+}
+
+// Comparison of values
+template <std::size_t N> inline bool operator== (const Dual<N>& a, const Dual<N>& b) {	return a.v == b.v; }
+template <std::size_t N> inline bool operator!= (const Dual<N>& a, const Dual<N>& b) {	return a.v != b.v; }
+template <std::size_t N> inline bool operator< (const Dual<N>& a, const Dual<N>& b) {	return a.v < b.v; }
+template <std::size_t N> inline bool operator> (const Dual<N>& a, const Dual<N>& b) {	return a.v > b.v; }
+template <std::size_t N> inline bool operator<= (const Dual<N>& a, const Dual<N>& b) {	return a.v <= b.v; }
+template <std::size_t N> inline bool operator>= (const Dual<N>& a, const Dual<N>& b) {	return a.v >= b.v; }
+template <std::size_t N> inline bool operator== (const Dual<N>& a, FM::Float b) {	return a.v == b; }
+template <std::size_t N> inline bool operator!= (const Dual<N>& a, FM::Float b) {	return a.v != b; }
+template <std::size_t N> inline bool operator< (const Dual<N>& a, FM::Float b) {	return a.v < b; }
+template <std::size_t N> inline bool operator> (const Dual<N>& a, FM::Float b) {	return a.v > b; }
+template <std::size_t N> inline bool operator<= (const Dual<N>& a, FM::Float b) {	return a.v <= b; }
+template <std::size_t N> inline bool operator>= (const Dual<N>& a, FM::Float b) {	return a.v >= b; }
+template <std::size_t N> inline bool operator== (FM::Float a, const Dual<N>& b) {	return a == b.v; }
+template <std::size_t N> inline bool operator!= (FM::Float a, const Dual<N>& b) {	return a != b.v; }
+template <std::size_t N> inline bool operator< (FM::Float a, const Dual<N>& b) {	return a < b.v; }
+template <std::size_t N> inline bool operator> (FM::Float a, const Dual<N>& b) {	return a > b.v; }
+template <std::size_t N> inline bool operator<= (FM::Float a, const Dual<N>& b) {	return a <= b.v; }
+template <std::size_t N> inline bool operator>= (FM::Float a, const Dual<N>& b) {	return a >= b.v; }
+
+// Elementary functions
+template <std::size_t N> inline Dual<N> sqrt (const Dual<N>& a)
+{	const FM::Float r = std::sqrt(a.v);
+	return chain (a, r, FM::Float(0.5) / r);
+}
+template <std::size_t N> inline Dual<N> exp (const Dual<N>& a)
+{	const FM::Float r = std::exp(a.v);
+	return chain (a, r, r);
+}
+template <std::size_t N> inline Dual<N> log (const Dual<N>& a)
+{	return chain (a, std::log(a.v), FM::Float(1) / a.v);
+}
+template <std::size_t N> inline Dual<N> pow (const Dual<N>& a, FM::Float p)
+{	return chain (a, std::pow(a.v, p), p * std::pow(a.v, p - 1));
+}
+template <std::size_t N> inline Dual<N> pow (const Dual<N>& a, const Dual<N>& p)
+{	return exp (p * log(a));
+}
+template <std::size_t N> inline Dual<N> abs (const Dual<N>& a)
+{	return a.v < 0 ? -a : a;
+}
+template <std::size_t N> inline Dual<N> fabs (const Dual<N>& a)
+{	return abs (a);
+}
+template <std::size_t N> inline Dual<N> sin (const Dual<N>& a)
+{	return chain (a, std::sin(a.v), std::cos(a.v));
+}
+template <std::size_t N> inline Dual<N> cos (const Dual<N>& a)
+{	return chain (a, std::cos(a.v), -std::sin(a.v));
+}
+template <std::size_t N> inline Dual<N> tan (const Dual<N>& a)
+{	const FM::Float r = std::tan(a.v);
+	return chain (a, r, 1 + r*r);
+}
+template <std::size_t N> inline Dual<N> asin (const Dual<N>& a)
+{	return chain (a, std::asin(a.v), 1 / std::sqrt(1 - a.v*a.v));
+}
+template <std::size_t N> inline Dual<N> acos (const Dual<N>& a)
+{	return chain (a, std::acos(a.v), -1 / std::sqrt(1 - a.v*a.v));
+}
+template <std::size_t N> inline Dual<N> atan (const Dual<N>& a)
+{	return chain (a, std::atan(a.v), 1 / (1 + a.v*a.v));
+}
+template <std::size_t N> inline Dual<N> atan2 (const Dual<N>& y, const Dual<N>& x)
+{	Dual<N> r;
+	r.v = std::atan2(y.v, x.v);
+	const FM::Float rr = x.v*x.v + y.v*y.v;
+	for (std::size_t i = 0; i < N; ++i) r.d[i] = (x.v*y.d[i] - y.v*x.d[i]) / rr;
+	return r;
+}
+template <std::size_t N> inline Dual<N> atan2 (const Dual<N>& y, FM::Float x)
+{	return atan2 (y, Dual<N>(x));
+}
+template <std::size_t N> inline Dual<N> atan2 (FM::Float y, const Dual<N>& x)
+{	return atan2 (Dual<N>(y), x);
+}
+
+
+template <class Function, std::size_t N = 8>
+class Forward_jacobian
+/*
+ * Function value and Jacobian by forward mode automatic differentiation
+ *  The value at the point of linearisation is retained so f(x) does not need to be re-evaluated
+ */
+{
+public:
+	typedef FM::Float Float;
+	Function function;
+
+	Forward_jacobian (std::size_t x_size, std::size_t fx_size, const Function& f = Function()) :
+		function(f), xd(x_size), fxd(fx_size), fx(fx_size), x_lin(x_size)
+	{
+		linearised = false;
+		for (std::size_t j = 0; j < x_size; ++j)
+			active.push_back (j);
+	}
+
+	void detect_sparsity (const FM::Vec& x)
+	/* Find the states the function structurally depends on when evaluated at x
+	 * Postcond: Only columns of states with a dependence are computed by linearise
+	 */
+	{
+		const std::size_t x_size = xd.size();
+		std::vector<bool> depends(x_size, false);
+		for (std::size_t c = 0; c < x_size; c += N)
+		{
+			const std::size_t n = std::min(N, x_size - c);
+			for (std::size_t j = 0; j < x_size; ++j)
+				xd[j] = Dual<N>(x[j]);
+			for (std::size_t k = 0; k < n; ++k)
+				xd[c+k].d[k] = std::numeric_limits<Float>::quiet_NaN();
+			function (fxd, xd);
+			for (std::size_t i = 0; i < fxd.size(); ++i)
+				for (std::size_t k = 0; k < n; ++k)
+					if (std::isnan(fxd[i].d[k]))
+						depends[c+k] = true;
+		}
+		active.clear();
+		for (std::size_t j = 0; j < x_size; ++j)
+			if (depends[j])
+				active.push_back (j);
+		linearised = false;
+	}
+
+	void linearise (FM::Matrix& Jx, const FM::Vec& x)
+	/* Jacobian Jx of the function at x, the function value is computed in the same passes
+	 * Precond: Jx is conformantly dimensioned
+	 */
+	{
+		const std::size_t n_active = active.size();
+		Jx.clear();
+		std::size_t c = 0;
+		do {						// At least one pass for the value
+			const std::size_t n = std::min(N, n_active - c);
+			for (std::size_t j = 0; j < xd.size(); ++j)
+				xd[j] = Dual<N>(x[j]);
+			for (std::size_t k = 0; k < n; ++k)
+				xd[active[c+k]].d[k] = 1;
+			function (fxd, xd);
+			for (std::size_t i = 0; i < fxd.size(); ++i)
+				for (std::size_t k = 0; k < n; ++k)
+					Jx(i, active[c+k]) = fxd[i].d[k];
+			c += n;
+		} while (c < n_active);
+
+		for (std::size_t i = 0; i < fxd.size(); ++i)
+			fx[i] = fxd[i].v;
+		x_lin = x;
+		linearised = true;
+	}
+
+	const FM::Vec& operator() (const FM::Vec& x) const
+	/* Function value at x
+	 *  Uses the value from linearise when x is the point of linearisation
+	 */
+	{
+		if (!(linearised && std::equal(x.begin(), x.end(), x_lin.begin())))
+		{
+			function (fx, x);
+			linearised = false;
+		}
+		return fx;
+	}
+
+	std::size_t active_size () const
+	/* Number of Jacobian columns computed */
+	{	return active.size();
+	}
+
+private:
+	std::vector<std::size_t> active;	// States with Jacobian columns computed
+	std::vector<Dual<N> > xd, fxd;
+	mutable FM::Vec fx;
+	FM::Vec x_lin;						// Point of linearisation
+	mutable bool linearised;
+};
+
+
+/*
+ * Linrz models with Jacobians computed from Function by forward automatic differentiation
+ *  linearise(x) computes the Jacobian, and the function value, at x.
+ *  It must be used to set the Jacobian before the model is used by a filter.
+ */
+
+template <class Function, std::size_t N = 8>
+class Autodiff_linrz_predict_model : public Linrz_predict_model
+{
+public:
+	Autodiff_linrz_predict_model (std::size_t x_size, std::size_t q_size, const Function& f = Function()) :
+		Linrz_predict_model(x_size, q_size), ad(x_size, x_size, f)
+	{}
+	void linearise (const FM::Vec& x)
+	{	ad.linearise (Fx, x);
+	}
+	const FM::Vec& f(const FM::Vec& x) const
+	{	return ad(x);
+	}
+	Forward_jacobian<Function,N> ad;
+};
+
+template <class Function, std::size_t N = 8>
+class Autodiff_linrz_uncorrelated_observe_model : public Linrz_uncorrelated_observe_model
+{
+public:
+	Autodiff_linrz_uncorrelated_observe_model (std::size_t x_size, std::size_t z_size, const Function& f = Function()) :
+		Linrz_uncorrelated_observe_model(x_size, z_size), ad(x_size, z_size, f)
+	{}
+	void linearise (const FM::Vec& x)
+	{	ad.linearise (Hx, x);
+	}
+	const FM::Vec& h(const FM::Vec& x) const
+	{	return ad(x);
+	}
+	Forward_jacobian<Function,N> ad;
+};
+
+template <class Function, std::size_t N = 8>
+class Autodiff_linrz_correlated_observe_model : public Linrz_correlated_observe_model
+{
+public:
+	Autodiff_linrz_correlated_observe_model (std::size_t x_size, std::size_t z_size, const Function& f = Function()) :
+		Linrz_correlated_observe_model(x_size, z_size), ad(x_size, z_size, f)
+	{}
+	void linearise (const FM::Vec& x)
+	{	ad.linearise (Hx, x);
+	}
+	const FM::Vec& h(const FM::Vec& x) const
+	{	return ad(x);
+	}
+	Forward_jacobian<Function,N> ad;
+};
+
+
+}//namespace
+#endif
@@ -13,6 +13,8 @@
  *  default virtual and member functions
  */
 #include "bayesFlt.hpp"
+#include "matSup.hpp"
+#include "bayesTrace.hpp"
 #include <boost/limits.hpp>
 #include <vector>		// Only for unique_samples
 
@@ -118,12 +120,16 @@ Bayes_base::Float
 /* Extended linrz correlated observe, compute innovation for observe_innovation
  */
 {
+	BAYES_FILTER_TRACE_SPAN("Extended_kalman_filter::observe");
 	update ();
-	const FM::Vec& zp = h.h(x);		// Observation model, zp is predicted observation
+	const FM::Vec* zp;
+	{	BAYES_FILTER_TRACE_SPAN("Linrz_observe_model::h");
+		zp = &h.h(x);		// Observation model, zp is predicted observation
+	}
 
 	FM::Vec s = z;
-	h.normalise(s, zp);
-	FM::noalias(s) -= zp;
+	h.normalise(s, *zp);
+	FM::noalias(s) -= *zp;
 	return observe_innovation (h, s);
 }
 
@@ -132,16 +138,51 @@ Bayes_base::Float
 /* Extended Kalman uncorrelated observe, compute innovation for observe_innovation
  */
 {
+	BAYES_FILTER_TRACE_SPAN("Extended_kalman_filter::observe");
 	update ();
-	const FM::Vec& zp = h.h(x);		// Observation model, zp is predicted observation
+	const FM::Vec* zp;
+	{	BAYES_FILTER_TRACE_SPAN("Linrz_observe_model::h");
+		zp = &h.h(x);		// Observation model, zp is predicted observation
+	}
 
 	FM::Vec s = z;
-	h.normalise(s, zp);
-	FM::noalias(s) -= zp;
+	h.normalise(s, *zp);
+	FM::noalias(s) -= *zp;
 	return observe_innovation (h, s);
 }
 
 
+Innovation_factor::Innovation_factor () :
+	SUD(FM::Empty), SIlazy(FM::Empty)
+{
+	SIlazy_valid = false;
+}
+
+const FM::SymMatrix& Innovation_factor::SI () const
+/* Innovation Covariance Inverse
+ *  Recomposed from the factor of S the first time it is requested after each factorisation
+ */
+{
+	if (!SIlazy_valid) {
+		FM::UdUrecompose_inverse (SIlazy, SUD);
+		SIlazy_valid = true;
+	}
+	return SIlazy;
+}
+
+Bayes_base::Float Innovation_factor::factor_S (const FM::SymMatrix& S)
+{
+	SIlazy_valid = false;
+	return FM::UdUfactor (SUD, S);
+}
+
+void Innovation_factor::factor_size (std::size_t z_size)
+{
+	SUD_cache.exchange (SUD, z_size,z_size);
+	SIlazy_cache.exchange (SIlazy, z_size,z_size);
+}
+
+
 Information_state_filter::Information_state_filter (std::size_t x_size) :
 /* Initialise state size
  */
@@ -260,6 +301,7 @@ void Sample_filter::predict (Functional_predict_model& f)
  *		Post: S represent the predicted distribution
  */
 {
+	BAYES_FILTER_TRACE_SPAN("Sample_filter::predict");
 						// Predict particles S using supplied predict model
 	const std::size_t nSamples = S.size2();
 	for (std::size_t i = 0; i != nSamples; ++i) {
@@ -113,6 +113,21 @@ public:
 	// Note: Reference return value as a speed optimisation, MUST be copied by caller.
 };
 
+class Sampled_additive_predict_model : public Sampled_predict_model
+/* Sampled stochastic predict model with additive noise
+    x*(k) = fd(x(k-1)) + w(k)
+   Separating the deterministic part fd allows it to be evaluated once for identical samples
+   Defines an Interface without data members
+ */
+{
+public:
+	virtual const FM::Vec& fd(const FM::Vec& x) const = 0;
+	// Deterministic part of fw
+	virtual const FM::Vec& add_w(const FM::Vec& fdx) const = 0;
+	// Sample of fw given fdx = fd(x)
+	// Note: Reference return value as a speed optimisation, MUST be copied by caller.
+};
+
 class Functional_predict_model :virtual public Predict_model_base
 /* Functional (non-stochastic) predict model f
     x*(k) = fx(x(k-1))
@@ -320,6 +335,14 @@ public:
 	FM::SymMatrix Z;	// Noise Covariance (not necessarily dense)
 };
 
+inline const FM::Vec& additive_noise (const Uncorrelated_additive_observe_model& h)
+// Noise of an additive observation model, as used by FM::UdUinnovation
+{	return h.Zv;
+}
+inline const FM::SymMatrix& additive_noise (const Correlated_additive_observe_model& h)
+{	return h.Z;
+}
+
 class Jacobian_observe_model : virtual public Observe_model_base
 /* Linrz observation model Hx, h about state x (fixed size)
     Hx(x(k|k-1) = Jacobian of h with respect to state x
@@ -493,6 +516,10 @@ public:
 	Kalman_state_filter (std::size_t x_size);
 	/* Initialise filter and set constant sizes
 	 */
+	Kalman_state_filter (const Kalman_state_filter&) = default;
+	Kalman_state_filter& operator= (const Kalman_state_filter&) = default;
+	/* Copy only: as a virtual base a move assignment could be applied more than once
+	 */
 
 	/* Virtual functions for filter algorithm */
 
@@ -525,6 +552,9 @@ class Information_state_filter : virtual public Bayes_filter_base
 {
 public:
 	Information_state_filter (std::size_t x_size);
+	Information_state_filter (const Information_state_filter&) = default;
+	Information_state_filter& operator= (const Information_state_filter&) = default;
+	// Copy only: as a virtual base a move assignment could be applied more than once
 	FM::Vec y;				// Information state
 	FM::SymMatrix Y;		// Information
 
@@ -626,6 +656,36 @@ public:
 };
 
 
+class Innovation_factor
+/*
+ * Innovation factor - Filter helper
+ *  UdU' factor of the innovation covariance S of schemes which solve for their gain with the factor,
+ *  and the inverse of S which is only computed on demand
+ */
+{
+public:
+	const FM::SymMatrix& SI () const;
+	// Innovation Covariance Inverse, only computed on demand from the factor of S
+
+protected:
+	Innovation_factor ();
+	Bayes_base::Float factor_S (const FM::SymMatrix& S);
+	/* Factorise S into SUD, SI is invalid from before the factorisation so a failed observe cannot leave
+	    the inverse of a previous S
+	    Returns: reciprocal condition number of S, as UdUfactor
+	*/
+	void factor_size (std::size_t z_size);
+	// Conform SUD and SI to z_size, for the dynamic observe sizing of the scheme
+
+	FM::RowMatrix SUD;			// UdU' factor of S
+private:
+	mutable FM::SymMatrix SIlazy;	// Inverse of S when it is requested
+	mutable bool SIlazy_valid;
+	FM::Size_cache<FM::RowMatrix> SUD_cache;
+	FM::Size_cache<FM::SymMatrix> SIlazy_cache;
+};
+
+
 /*
  * Sample State Filter - Abstract filtering property
  *
@@ -12,6 +12,11 @@
 #include "bayesFlt.hpp"
 #include "matSup.hpp"
 #include "models.hpp"
+#include "bayesTrace.hpp"
+#include <algorithm>
+#include <cmath>
+#include <istream>
+#include <ostream>
 
 
 namespace {
@@ -57,6 +62,98 @@ Simple_linear_predict_model::Simple_linear_predict_model (const FM::Matrix& Fx_i
 	q = q_init;
 }
 
+Multi_step_linear_predict_model::Composed::Composed (std::size_t x_size) :
+	F(x_size,x_size), Q(x_size,x_size)
+{}
+
+Multi_step_linear_predict_model::Factored::Factored (std::size_t x_size) :
+	Fx(x_size,x_size), G(x_size,x_size), q(x_size)
+{}
+
+Multi_step_linear_predict_model::Multi_step_linear_predict_model (const Linear_predict_model& step) :
+	Linear_predict_model (step.Fx.size1(), step.Fx.size1()),
+	max_cached (64)
+/* Precondition: step is time invariant
+ * Postcondition: Fx,G,q compose a single step
+ */
+{
+	const std::size_t x_size = step.Fx.size1();
+	Composed one(x_size);
+	one.F = step.Fx;
+	one.Q = FM::prod_SPD(step.G, step.q);
+	doubled.push_back (one);
+	steps (1);
+}
+
+void Multi_step_linear_predict_model::compose (Composed& a, const Composed& b)
+/* Compose the steps of b after a
+ *  a.F = b.F*a.F, a.Q = b.F*a.Q*b.F' + b.Q
+ */
+{
+	FM::RowMatrix temp(a.F.size1(), a.F.size2());
+	FM::assign_prod_SPD (a.Q, b.F, a.Q, temp);
+	noalias(a.Q) += b.Q;
+	noalias(temp) = FM::prod(b.F, a.F);
+	a.F = temp;
+}
+
+void Multi_step_linear_predict_model::clear_cache ()
+{
+	cache.clear();
+}
+
+void Multi_step_linear_predict_model::steps (std::size_t k)
+/* Set Fx,G,q to compose k steps
+ *  Cached composed model is used if k has been composed before
+ *  When the cache is full it is emptied before the model of k is added
+ */
+{
+	if (k == 0)
+		error (Logic_exception("Multi step predict requires at least one step"));
+
+	std::map<std::size_t, Factored>::iterator ci = cache.find(k);
+	if (ci == cache.end())
+	{
+						// Double the step until 2^i > k
+		while ((std::size_t(1) << doubled.size()) <= k)
+		{
+			Composed d (doubled.back());
+			compose (d, doubled.back());
+			doubled.push_back (d);
+		}
+						// Compose the doubled steps which sum to k
+		const std::size_t x_size = Fx.size1();
+		Composed c(x_size);
+		bool first = true;
+		for (std::size_t i = 0; i < doubled.size(); ++i)
+		{
+			if (k & (std::size_t(1) << i))
+			{
+				if (first) {
+					c.F = doubled[i].F;
+					c.Q = doubled[i].Q;
+					first = false;
+				}
+				else
+					compose (c, doubled[i]);
+			}
+		}
+						// Factor accumulated noise into G,q
+		if (cache.size() >= max_cached)
+			cache.clear();
+		ci = cache.insert (std::make_pair(k, Factored(x_size))).first;
+		Factored& f = ci->second;
+		f.Fx = c.F;
+		FM::RowMatrix UD(x_size,x_size);
+		Float rcond = FM::UdUfactor (UD, c.Q);
+		rclimit.check_PSD(rcond, "Multi step noise not PSD");
+		FM::UdUseperate (f.G, f.q, UD);
+	}
+	Fx = ci->second.Fx;
+	G = ci->second.G;
+	q = ci->second.q;
+}
+
 Simple_linrz_correlated_observe_model::Simple_linrz_correlated_observe_model (State_function f_init, const FM::Matrix& Hx_init, const FM::SymMatrix& Z_init) :
 	Linrz_correlated_observe_model (Hx_init.size2(), Hx_init.size1()),
 	ff(f_init)
@@ -159,7 +256,7 @@ Bayes_base::Float
 /* Definition of likelihood given an additive Gaussian observation model:
  *  p(z|x) = exp(-0.5*(z-h(x))'*inv(Z)*(z-h(x))) / sqrt(2pi^nz*det(Z));
  *  L(x) the the Likelihood L(x) doesn't depend on / sqrt(2pi^nz) for constant z size
- * Precond: Observation Information: z,Z_inv,detZterm
+ * Precond: Observation Information: z,ZUD,detZterm
  */
 {
 	if (!zset)
@@ -169,33 +266,32 @@ Bayes_base::Float
 	model.normalise (zInnov, zp);
 	FM::noalias(zInnov) -= zp;
 
-	Float logL = scaled_vector_square(zInnov, Z_inv);
+	Float logL = scaled_vector_square(zInnov, ZUD);
 	using namespace std;
 	return exp(Float(-0.5)*(logL + logdetZ));
 }
 
 void General_LzCoAd_observe_model::Likelihood_correlated::Lz (const Correlated_additive_observe_model& model)
 /* Set the observation zz and Z about which to evaluate the Likelihood function
- * Postcond: Observation Information: z,Z_inv,detZterm
+ * Postcond: Observation Information: z,ZUD,detZterm
  */
 {
 	zset = true;
-						// Compute inverse of Z and its reciprocal condition number
-	Float detZ;
-	Float rcond = FM::UdUinversePD (Z_inv, detZ, model.Z);
+						// Factorise Z and its reciprocal condition number
+	Float rcond = FM::UdUfactor (ZUD, model.Z);
 	model.rclimit.check_PD(rcond, "Z not PD in observe");
-						// detZ > 0 as Z PD
-	using namespace std;
-	logdetZ = log(detZ);
+						// log(det(Z)) directly from factor as Z PD
+	logdetZ = FM::UdUlogdet (ZUD);
 }
 
 
 Bayes_base::Float
- General_LzCoAd_observe_model::Likelihood_correlated::scaled_vector_square(const FM::Vec& v, const FM::SymMatrix& V)
-/* Compute covariance scaled square inner product of a Vector: v'*V*v
+ General_LzCoAd_observe_model::Likelihood_correlated::scaled_vector_square(FM::Vec& v, const FM::RowMatrix& VUD)
+/* Compute covariance scaled square inner product of a Vector: v'*inv(V)*v
+ *  Uses the UdU' factor of V, v is destroyed
  */
 {
-	return FM::inner_prod(v, FM::prod(V,v));
+	return FM::UdUmahalanobis (VUD, v);
 }
 
 
@@ -219,4 +315,195 @@ Adapted_Linrz_correlated_observe_model::Adapted_Linrz_correlated_observe_model (
 }
 
 
+struct Likelihood_field_observe_model::Field
+{
+	std::vector<float> L;	// Likelihood at grid point (ir*ny + iy)*nx + ix
+};
+
+std::map<std::vector<Bayes_base::Float>, boost::weak_ptr<const Likelihood_field_observe_model::Field> > Likelihood_field_observe_model::fields;
+std::mutex Likelihood_field_observe_model::fields_lock;
+
+namespace {
+	void lock_fields (std::unique_lock<std::mutex>& lock)
+	// Lock the shared fields, the wait is traced as other threads may be computing a table
+	{
+		BAYES_FILTER_TRACE_SPAN("Likelihood_field_observe_model::fields_lock");
+		lock.lock();
+	}
+}//namespace
+
+Likelihood_field_observe_model::Likelihood_field_observe_model (std::size_t ix, std::size_t iy, Float ax, Float ay, Float ah, Float Zv, const Grid& grid) :
+		Likelihood_observe_model(1),
+		ix(ix), iy(iy),
+		ax(ax), ay(ay), ah2(ah*ah), Zv(Zv), logZv(std::log(Zv)),
+		grid(grid)
+{
+	if (!(Zv > 0))
+		error (Numeric_exception("Zv not PD in Likelihood_field"));
+	if (grid.nx < 2 || grid.ny < 2 || grid.nr < 2 || !(grid.dxy > 0) || !(grid.dr > 0))
+		error (Logic_exception("Likelihood_field grid requires at least two points and positive cell size on each axis"));
+	const Float p[] = {ax, ay, ah, Zv, grid.x0, grid.y0, grid.r0, grid.dxy, grid.dr, Float(grid.nx), Float(grid.ny), Float(grid.nr)};
+	param.assign (p, p + sizeof(p)/sizeof(p[0]));
+	zset = false;
+}
+
+void Likelihood_field_observe_model::field_required ()
+/* Make field available
+ *  Share a table already in memory or compute the table
+ *  Tables which are no longer used are removed
+ */
+{
+	if (field)
+		return;
+	BAYES_FILTER_TRACE_SPAN("Likelihood_field_observe_model::field_required");
+	std::unique_lock<std::mutex> lock(fields_lock, std::defer_lock);
+	lock_fields (lock);
+	std::map<std::vector<Float>, boost::weak_ptr<const Field> >::iterator fi = fields.find(param);
+	if (fi != fields.end()) {
+		field = fi->second.lock();
+		if (field)
+			return;
+	}
+	for (fi = fields.begin(); fi != fields.end(); ) {
+		if (fi->second.expired())
+			fields.erase (fi++);
+		else
+			++fi;
+	}
+
+	boost::shared_ptr<Field> f(new Field);
+	f->L.resize (grid.nx * grid.ny * grid.nr);
+	std::vector<float>::iterator li = f->L.begin();
+	for (std::size_t r = 0; r != grid.nr; ++r) {
+		const Float rg = grid.r0 + Float(r) * grid.dr;
+		for (std::size_t y = 0; y != grid.ny; ++y) {
+			const Float dy = grid.y0 + Float(y) * grid.dxy - ay;
+			for (std::size_t x = 0; x != grid.nx; ++x, ++li) {
+				const Float dx = grid.x0 + Float(x) * grid.dxy - ax;
+				const Float innov = rg - std::sqrt(dx*dx + dy*dy + ah2);
+				*li = float(std::exp(Float(-0.5) * (innov*innov / Zv + logZv)));
+			}
+		}
+	}
+	field = f;
+	fields[param] = field;
+}
+
+void Likelihood_field_observe_model::Lz (const FM::Vec& zz)
+/* Set the observed range and interpolate the table at the range into the slab
+ */
+{
+	Likelihood_observe_model::z = zz;
+	Likelihood_field_observe_model::zz = zz[0];
+	zset = true;
+	Float fr = (Likelihood_field_observe_model::zz - grid.r0) / grid.dr;
+	zgrid = (fr >= 0 && fr <= Float(grid.nr - 1));
+	if (zgrid) {
+		const std::size_t ir = std::min(std::size_t(fr), grid.nr - 2);
+		fr -= Float(ir);
+		field_required();
+		const std::size_t n = grid.nx * grid.ny;
+		slab.resize (n);
+		const float* l0 = &field->L[ir * n];
+		const float* l1 = l0 + n;
+		const float f0 = float(1-fr), f1 = float(fr);
+		for (std::size_t i = 0; i != n; ++i)
+			slab[i] = f0 * l0[i] + f1 * l1[i];
+	}
+}
+
+Bayes_base::Float
+ Likelihood_field_observe_model::L_analytic (Float px, Float py) const
+{
+	const Float dx = px - ax, dy = py - ay;
+	const Float innov = zz - std::sqrt(dx*dx + dy*dy + ah2);
+	return std::exp(Float(-0.5) * (innov*innov / Zv + logZv));
+}
+
+Bayes_base::Float
+ Likelihood_field_observe_model::lookup (Float fx, Float fy) const
+/* Bilinear interpolation of the slab at fractional grid position fx,fy
+ * Precond: fx,fy on the grid
+ */
+{
+	const std::size_t i = std::min(std::size_t(fx), grid.nx - 2);
+	const std::size_t j = std::min(std::size_t(fy), grid.ny - 2);
+	fx -= Float(i); fy -= Float(j);
+	const float* l = &slab[j*grid.nx + i];
+	return (1-fy) * ((1-fx)*l[0] + fx*l[1]) + fy * ((1-fx)*l[grid.nx] + fx*l[grid.nx+1]);
+}
+
+Bayes_base::Float
+ Likelihood_field_observe_model::L (const FM::Vec& x) const
+{
+	if (!zset)
+		error (Logic_exception("Likelihood_field used without Lz set"));
+	const Float px = x[ix], py = x[iy];
+	if (zgrid) {
+		const Float fx = (px - grid.x0) / grid.dxy;
+		const Float fy = (py - grid.y0) / grid.dxy;
+		if (fx >= 0 && fx <= Float(grid.nx - 1) && fy >= 0 && fy <= Float(grid.ny - 1))
+			return lookup (fx, fy);
+	}
+	return L_analytic (px, py);		// Off grid
+}
+
+void Likelihood_field_observe_model::Ls (const FM::ColMatrix& S, FM::Vec& l) const
+/* Likelihood of all samples
+ *  Avoids the virtual L and sample copy for each sample
+ * Precond: l.size() == S.size2()
+ */
+{
+	if (!zset)
+		error (Logic_exception("Likelihood_field used without Lz set"));
+	const std::size_t nSamples = S.size2();
+	const Float xmax = Float(grid.nx - 1), ymax = Float(grid.ny - 1);
+	const Float rdxy = 1 / grid.dxy;
+	for (std::size_t i = 0; i != nSamples; ++i) {
+		const Float px = S(ix,i), py = S(iy,i);
+		const Float fx = (px - grid.x0) * rdxy;
+		const Float fy = (py - grid.y0) * rdxy;
+		if (zgrid && fx >= 0 && fx <= xmax && fy >= 0 && fy <= ymax)
+			l[i] = lookup (fx, fy);
+		else
+			l[i] = L_analytic (px, py);
+	}
+}
+
+namespace {
+	const char field_magic[8] = {'B','a','y','e','s','L','F','2'};
+}
+
+void Likelihood_field_observe_model::save (std::ostream& os)
+/* Write parameters and table in native binary format
+ */
+{
+	field_required();
+	os.write (field_magic, sizeof(field_magic));
+	os.write (reinterpret_cast<const char*>(&param[0]), std::streamsize(param.size() * sizeof(Float)));
+	os.write (reinterpret_cast<const char*>(&field->L[0]), std::streamsize(field->L.size() * sizeof(float)));
+}
+
+bool Likelihood_field_observe_model::load (std::istream& is)
+/* Read parameters and table written by save
+ */
+{
+	char magic[sizeof(field_magic)];
+	std::vector<Float> p(param.size());
+	if (!is.read (magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), field_magic))
+		return false;
+	if (!is.read (reinterpret_cast<char*>(&p[0]), std::streamsize(p.size() * sizeof(Float))) || p != param)
+		return false;
+	boost::shared_ptr<Field> f(new Field);
+	f->L.resize (grid.nx * grid.ny * grid.nr);
+	if (!is.read (reinterpret_cast<char*>(&f->L[0]), std::streamsize(f->L.size() * sizeof(float))))
+		return false;
+	field = f;
+	std::unique_lock<std::mutex> lock(fields_lock, std::defer_lock);
+	lock_fields (lock);
+	fields[param] = field;
+	return true;
+}
+
+
 }//namespace
@@ -0,0 +1,170 @@
+/*
+ * Bayes++ the Bayesian Filtering Library
+ * Copyright (c) 2002 Michael Stevens
+ * See accompanying Bayes++.htm for terms and conditions of use.
+ *
+ * $Id$
+ */
+
+/*
+ * Span tracing.
+ */
+#include "bayesTrace.hpp"
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+
+/* Filter namespace */
+namespace Bayesian_filter
+{
+namespace Trace
+{
+
+std::atomic<bool> active(false);
+
+namespace {
+	struct Event
+	{
+		const char* name;
+		std::int64_t start, end;
+		std::uint64_t filter;
+	};
+
+	struct Buffer
+	// Ring buffer of one thread, written only by that thread
+	{
+		Buffer (std::size_t capacity, unsigned tid) : events(capacity), head(0), tid(tid)
+		{}
+		std::vector<Event> events;
+		std::atomic<std::size_t> head;	// Number of events recorded
+		const unsigned tid;
+	};
+
+	std::mutex registry_mutex;
+	std::vector<std::shared_ptr<Buffer> > registry;		// Buffers outlive their threads
+	std::size_t capacity = 1 << 16;
+
+	thread_local std::shared_ptr<Buffer> local;
+	thread_local std::uint64_t filter_id = 0;
+
+	const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+	Buffer& local_buffer ()
+	{
+		if (!local) {
+			std::lock_guard<std::mutex> lock(registry_mutex);
+			local.reset (new Buffer(capacity, unsigned(registry.size()) + 1));
+			registry.push_back (local);
+		}
+		return *local;
+	}
+
+	void write_string (std::ostream& os, const char* s)
+	{
+		os << '"';
+		for (; *s; ++s) {
+			if (*s == '"' || *s == '\\')
+				os << '\\';
+			os << *s;
+		}
+		os << '"';
+	}
+
+	void write_microseconds (std::ostream& os, std::int64_t ns)
+	// Fixed point microseconds with nanosecond resolution
+	{
+		if (ns < 0) {
+			os << '-';
+			ns = -ns;
+		}
+		const int fraction = int(ns % 1000);
+		os << ns / 1000 << '.' << char('0' + fraction / 100) << char('0' + fraction / 10 % 10) << char('0' + fraction % 10);
+	}
+}//namespace
+
+
+void enable (bool on)
+{
+	active.store (on, std::memory_order_relaxed);
+}
+
+void set_capacity (std::size_t events)
+{
+	std::lock_guard<std::mutex> lock(registry_mutex);
+	capacity = events > 0 ? events : 1;
+}
+
+void clear ()
+{
+	std::lock_guard<std::mutex> lock(registry_mutex);
+	for (std::size_t b = 0; b != registry.size(); ++b)
+		registry[b]->head.store (0, std::memory_order_release);
+}
+
+std::int64_t now ()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void record (const char* name, std::int64_t start, std::int64_t end)
+{
+	Buffer& b = local_buffer();
+	const std::size_t h = b.head.load (std::memory_order_relaxed);
+	Event& e = b.events[h % b.events.size()];
+	e.name = name;
+	e.start = start;
+	e.end = end;
+	e.filter = filter_id;
+	b.head.store (h+1, std::memory_order_release);
+}
+
+std::uint64_t filter ()
+{
+	return filter_id;
+}
+
+void write_chrome_json (std::ostream& os)
+/* Complete ("X") events with fixed point times in microseconds, the filter id is an argument of each event
+ */
+{
+	std::lock_guard<std::mutex> lock(registry_mutex);
+	os << "{\"traceEvents\":[";
+	bool first = true;
+	for (std::size_t b = 0; b != registry.size(); ++b) {
+		const Buffer& buf = *registry[b];
+		const std::size_t head = buf.head.load (std::memory_order_acquire);
+		const std::size_t n = head < buf.events.size() ? head : buf.events.size();
+		for (std::size_t i = head - n; i != head; ++i) {
+			const Event& e = buf.events[i % buf.events.size()];
+			os << (first ? "\n" : ",\n");
+			first = false;
+			os << "{\"name\":";
+			write_string (os, e.name);
+			os << ",\"cat\":\"bayes\",\"ph\":\"X\",\"ts\":";
+			write_microseconds (os, e.start);
+			os << ",\"dur\":";
+			write_microseconds (os, e.end - e.start);
+			os << ",\"pid\":1,\"tid\":" << buf.tid
+			   << ",\"args\":{\"filter\":" << e.filter << "}}";
+		}
+	}
+	os << "\n],\"displayTimeUnit\":\"ns\"}\n";
+}
+
+
+Filter_scope::Filter_scope (std::uint64_t id) : previous(filter_id)
+{
+	filter_id = id;
+}
+
+Filter_scope::~Filter_scope ()
+{
+	filter_id = previous;
+}
+
+
+}//namespace Trace
+}//namespace
@@ -0,0 +1,115 @@
+#ifndef _BAYES_FILTER_TRACE
+#define _BAYES_FILTER_TRACE
+
+/*
+ * Bayes++ the Bayesian Filtering Library
+ * Copyright (c) 2002 Michael Stevens
+ * See accompanying Bayes++.htm for terms and conditions of use.
+ *
+ * $Id$
+ */
+
+/*
+ * Span tracing of filter operations for inspection on a timeline
+ *
+ * A Span records the interval of its lifetime, tagged with the thread and the filter id of that thread.
+ * Spans are written to a ring buffer of each thread, so recording requires no locks and the most recent
+ * spans are kept. write_chrome_json dumps the spans of all threads in the Chrome trace event format,
+ * which may be viewed with chrome://tracing or Perfetto. Spans should be dumped when filters are quiescent.
+ *
+ * When the library is built with BAYES_FILTER_TRACE the schemes trace their predict, observe, update,
+ * resampling and the model callbacks made once per operation with BAYES_FILTER_TRACE_SPAN. Islands of
+ * concurrent resampling are traced on their own thread, with the filter id of the thread that ran them,
+ * as are waits for the island threads and for shared likelihood tables.
+ * Schemes used as the components of a Gaussian sum or the hypotheses of a tracker still record a span
+ * for each component. Without BAYES_FILTER_TRACE the macro is empty. Tracing is then recorded only
+ * while enabled, a disabled span costs one relaxed atomic load.
+ *
+ * Matrix factorisations are traced with BAYES_FILTER_TRACE_FINE_SPAN, which is empty unless
+ * BAYES_FILTER_TRACE_FINE is also defined. They are made for each component, hypothesis or sample of
+ * many schemes so their spans may soon fill the ring buffers.
+ */
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+
+/* Filter namespace */
+namespace Bayesian_filter
+{
+namespace Trace
+{
+
+extern std::atomic<bool> active;
+
+void enable (bool on);
+// Enable or disable recording of spans
+inline bool enabled ()
+{
+	return active.load (std::memory_order_relaxed);
+}
+
+void set_capacity (std::size_t events);
+// Capacity of ring buffers of threads which have not yet recorded a span
+void clear ();
+// Discard recorded spans
+void write_chrome_json (std::ostream& os);
+// Write recorded spans of all threads as a Chrome trace event JSON object
+
+std::int64_t now ();
+// Nanoseconds from an arbitrary epoch
+void record (const char* name, std::int64_t start, std::int64_t end);
+// Record a span of this thread
+std::uint64_t filter ();
+// Filter id of spans recorded by this thread
+
+class Filter_scope
+/* Filter id of spans recorded by this thread during the scope
+ */
+{
+public:
+	explicit Filter_scope (std::uint64_t id);
+	~Filter_scope ();
+private:
+	Filter_scope (const Filter_scope&);
+	Filter_scope& operator= (const Filter_scope&);
+	std::uint64_t previous;
+};
+
+class Span
+/* Record the lifetime of the span
+ *  name must be a string with static storage duration
+ */
+{
+public:
+	explicit Span (const char* name) : name(name), start(enabled() ? now() : -1)
+	{}
+	~Span ()
+	{
+		if (start >= 0)
+			record (name, start, now());
+	}
+private:
+	Span (const Span&);
+	Span& operator= (const Span&);
+	const char* name;
+	const std::int64_t start;	// Negative if not recorded
+};
+
+
+}//namespace Trace
+}//namespace
+
+
+#ifdef BAYES_FILTER_TRACE
+#define BAYES_FILTER_TRACE_SPAN(name) Bayesian_filter::Trace::Span bayes_filter_trace_span(name)
+#else
+#define BAYES_FILTER_TRACE_SPAN(name)
+#endif
+
+#if defined(BAYES_FILTER_TRACE) && defined(BAYES_FILTER_TRACE_FINE)
+#define BAYES_FILTER_TRACE_FINE_SPAN(name) Bayesian_filter::Trace::Span bayes_filter_trace_span(name)
+#else
+#define BAYES_FILTER_TRACE_FINE_SPAN(name)
+#endif
+
+#endif
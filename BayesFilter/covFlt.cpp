@@ -12,6 +12,7 @@
  */
 #include "covFlt.hpp"
 #include "matSup.hpp"
+#include "bayesTrace.hpp"
 
 /* Filter namespace */
 namespace Bayesian_filter
@@ -21,8 +22,8 @@ namespace Bayesian_filter
 
 Covariance_scheme::Covariance_scheme (std::size_t x_size, std::size_t z_initialsize) :
 	Kalman_state_filter(x_size),
-	S(Empty), SI(Empty), W(Empty),
-	tempX(x_size,x_size)
+	S(Empty), W(Empty),
+	tempX(x_size,x_size), tempXZ(Empty)
 /* Initialise filter and set the size of things we know about
  */
 {
@@ -49,6 +50,7 @@ void Covariance_scheme::init ()
 
 void Covariance_scheme::update ()
 {
+	BAYES_FILTER_TRACE_SPAN("Covariance_scheme::update");
 	// Nothing to do, implicit in observation
 }
 
@@ -57,9 +59,12 @@ Bayes_base::Float
 /* Standard Linrz prediction
  */
 {
-	x = f.f(x);		// Extended Kalman state predict is f(x) directly
+	BAYES_FILTER_TRACE_SPAN("Covariance_scheme::predict");
+	{	BAYES_FILTER_TRACE_SPAN("Linrz_predict_model::f");
+		x = f.f(x);		// Extended Kalman state predict is f(x) directly
+	}
 						// Predict state covariance
-	noalias(X) = prod_SPD(f.Fx,X, tempX);
+	assign_prod_SPD (X, f.Fx, X, tempX);
 	noalias(X) += prod_SPD(f.G, f.q, tempX);
 
 	return 1;
@@ -70,6 +75,7 @@ Bayes_base::Float
 /* Specialised 'stationary' predict, only additive noise
  */
 {
+	BAYES_FILTER_TRACE_SPAN("Covariance_scheme::predict");
 						// Predict state covariance, simply add in noise
 	noalias(X) += prod_SPD(f.G, f.q, tempX);
   
@@ -84,9 +90,33 @@ void Covariance_scheme::observe_size (std::size_t z_size)
 	if (z_size != last_z_size) {
 		last_z_size = z_size;
 
-		S.resize(z_size,z_size, false);
-		SI.resize(z_size,z_size, false);
-		W.resize(x.size(),z_size, false);
+		S_cache.exchange (S, z_size,z_size);
+		factor_size (z_size);
+		W_cache.exchange (W, x.size(),z_size);
+		tempXZ_cache.exchange (tempXZ, x.size(),z_size);
+	}
+}
+
+void Covariance_scheme::innovation_covariance (FM::Matrix& XHxT, const FM::Matrix& Hx)
+/* Innovation covariance without observation noise
+ *  S = Hx*X*Hx', XHxT = X*Hx'
+ *  When Hx is a selection the products are gathered from X without multiplication
+ */
+{
+	if (isSelection (Hx, Hx_selection))
+	{
+		const std::size_t z_size = Hx_selection.size();
+		for (std::size_t j = 0; j < z_size; ++j) {
+			const std::size_t k = Hx_selection[j];
+			noalias(column(XHxT,j)) = row(X,k);		// X is symmetric
+			for (std::size_t i = 0; i <= j; ++i)
+				S(i,j) = X(Hx_selection[i],k);
+		}
+	}
+	else
+	{
+		assign_prod_trans (XHxT, X, Hx);
+		assign_prod (S, Hx, XHxT);
 	}
 }
 
@@ -95,25 +125,27 @@ Bayes_base::Float
 /* Correlated innovation observe
  */
 {
+	BAYES_FILTER_TRACE_SPAN("Covariance_scheme::observe_innovation");
 						// Size consistency, z to model
 	if (s.size() != h.Z.size1())
 		error (Logic_exception("observation and model size inconsistent"));
 	observe_size (s.size());// Dynamic sizing
 
 						// Innovation covariance
-	Matrix temp_XZ (prod(X, trans(h.Hx)));
-	noalias(S) = prod(h.Hx, temp_XZ) + h.Z;
+	innovation_covariance (tempXZ, h.Hx);
+	noalias(S) += h.Z;
 
-						// Inverse innovation covariance
-	Float rcond = UdUinversePD (SI, S);
+						// Factorise innovation covariance
+	Float rcond = factor_S (S);
 	rclimit.check_PD(rcond, "S not PD in observe");
 
-						// Kalman gain, X*Hx'*SI
-	noalias(W) = prod(temp_XZ, SI);
+						// Kalman gain, X*Hx'*inv(S) by solution with the factor of S
+	noalias(W) = tempXZ;
+	UdUsolve_right (SUD, W);
 
 						// State update
 	noalias(x) += prod(W, s);
-	noalias(X) -= prod_SPD(W, S, temp_XZ);
+	minus_assign_prod_SPD (X, W, S, tempXZ);
 
 	return rcond;
 }
@@ -124,27 +156,28 @@ Bayes_base::Float
 /* Uncorrelated innovation observe
  */
 {
+	BAYES_FILTER_TRACE_SPAN("Covariance_scheme::observe_innovation");
 						// Size consistency, z to model
 	if (s.size() != h.Zv.size())
 		error (Logic_exception("observation and model size inconsistent"));
 	observe_size (s.size());// Dynamic sizing
 
 						// Innovation covariance
-	Matrix temp_XZ (prod(X, trans(h.Hx)));
-	noalias(S) = prod(h.Hx, temp_XZ);
+	innovation_covariance (tempXZ, h.Hx);
 	for (std::size_t i = 0; i < h.Zv.size(); ++i)
 		S(i,i) += Float(h.Zv[i]);	// ISSUE mixed type proxy assignment
 
-						// Inverse innovation covariance
-	Float rcond = UdUinversePD (SI, S);
+						// Factorise innovation covariance
+	Float rcond = factor_S (S);
 	rclimit.check_PD(rcond, "S not PD in observe");
 
-						// Kalman gain, X*Hx'*SI
-	noalias(W) = prod(temp_XZ, SI);
+						// Kalman gain, X*Hx'*inv(S) by solution with the factor of S
+	noalias(W) = tempXZ;
+	UdUsolve_right (SUD, W);
 
 						// State update
 	noalias(x) += prod(W, s);
-	noalias(X) -= prod_SPD(W, S, temp_XZ);
+	minus_assign_prod_SPD (X, W, S, tempXZ);
 
 	return rcond;
 }
@@ -31,7 +31,7 @@
 namespace Bayesian_filter
 {
 
-class Covariance_scheme : public Extended_kalman_filter
+class Covariance_scheme : public Extended_kalman_filter, public Innovation_factor
 {
 public:
 	Covariance_scheme (std::size_t x_size, std::size_t z_initialsize = 0);
@@ -50,14 +50,20 @@ public:
 	Float observe_innovation (Linrz_correlated_observe_model& h, const FM::Vec& s);
 
 public:						// Exposed Numerical Results
-	FM::SymMatrix S, SI;		// Innovation Covariance and Inverse
+	FM::SymMatrix S;			// Innovation Covariance
 	FM::Matrix W;				// Kalman Gain
 
 protected:			   		// Permanently allocated temps
 	FM::RowMatrix tempX;
+	FM::Matrix tempXZ;			// X*Hx', sized by observe_size
+	std::vector<std::size_t> Hx_selection;
+	void innovation_covariance (FM::Matrix& XHxT, const FM::Matrix& Hx);
 protected:					// allow fast operation if z_size remains constant
 	std::size_t last_z_size;
 	void observe_size (std::size_t z_size);
+	FM::Size_cache<FM::SymMatrix> S_cache;
+	FM::Size_cache<FM::RowMatrix> W_cache;
+	FM::Size_cache<FM::Matrix> tempXZ_cache;
 };
 
 
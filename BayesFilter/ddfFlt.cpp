@@ -0,0 +1,312 @@
+/*
+ * Bayes++ the Bayesian Filtering Library
+ * Copyright (c) 2002 Michael Stevens
+ * See accompanying Bayes++.htm for terms and conditions of use.
+ *
+ * $Id$
+ */
+
+/*
+ * Divided Difference Filter.
+ */
+#include "ddfFlt.hpp"
+#include "matSup.hpp"
+#include "bayesTrace.hpp"
+#include <cmath>
+
+
+/* Filter namespace */
+namespace Bayesian_filter
+{
+	using namespace Bayesian_filter_matrix;
+
+
+const DDF_scheme::Float DDF_scheme::h2 = 3;
+		// optimal interval for Gaussian distributions
+
+DDF_scheme::DDF_scheme (std::size_t x_size, std::size_t z_initialsize) :
+		Kalman_state_filter(x_size), Functional_filter(),
+		SX(x_size,x_size),
+		s(Empty), SS(Empty)
+/* Initialise filter and set the size of things we know about
+ */
+{
+	DDF_scheme::x_size = x_size;
+	last_z_size = 0;	// Matrices conform to z_initialsize, they are left Empty if z_initialsize==0
+	observe_size (z_initialsize);
+	update_required = true;
+}
+
+DDF_scheme& DDF_scheme::operator= (const DDF_scheme& a)
+/* Optimise copy assignment to only copy filter state
+ * Precond: matrix size conformance
+ */
+{
+	Kalman_state_filter::operator=(a);
+	SX = a.SX;
+	update_required = a.update_required;
+	return *this;
+}
+
+void DDF_scheme::init ()
+/* Initialise state
+ *  Pre : x,X
+ *  Post: x,X,SX
+ */
+{
+	Float rcond = UCfactor (SX, X);
+	rclimit.check_PSD(rcond, "Initial X not PSD");
+	update_required = false;
+}
+
+void DDF_scheme::update ()
+/* Update state
+ *  Pre : x,SX
+ *  Post: x,X,SX
+ */
+{
+	BAYES_FILTER_TRACE_SPAN("DDF_scheme::update");
+	if (update_required) {
+		noalias(X) = prod(SX, trans(SX));
+		update_required = false;
+	}
+}
+
+
+// ISSUE GCC2.95 cannot link if these are locally defined in member function
+// Move them back into member functions for standard compilers
+namespace {
+	class Adapted_zero_model : public Unscented_predict_model
+	{
+	public:
+		Adapted_zero_model(Functional_predict_model& fm) :
+			Unscented_predict_model(0),
+			fmodel(fm), zeroQ(0,0)
+		{}
+		const Vec& f(const Vec& x) const
+		{
+			return fmodel.fx(x);
+		}
+		const SymMatrix& Q(const FM::Vec& /*x*/) const
+		{
+			return zeroQ;
+		}
+	private:
+		Functional_predict_model& fmodel;
+		SymMatrix zeroQ;
+	};
+
+	class Adapted_additive_model : public Unscented_predict_model
+	{
+	public:
+		Adapted_additive_model(Additive_predict_model& am) :
+			Unscented_predict_model(am.G.size1()),
+			amodel(am), zeroQ(0,0)
+		{}
+		const Vec& f(const Vec& x) const
+		{
+			return amodel.f(x);
+		}
+		const SymMatrix& Q(const FM::Vec& /*x*/) const
+		{	// Noise is represented by its root in predict_root
+			return zeroQ;
+		}
+	private:
+		Additive_predict_model& amodel;
+		SymMatrix zeroQ;
+	};
+}//namespace
+
+
+void DDF_scheme::predict (Functional_predict_model& f)
+/* Adapt model by creating a predict with zero noise
+ */
+{
+	BAYES_FILTER_TRACE_SPAN("DDF_scheme::predict");
+	Adapted_zero_model adaptedmodel(f);
+	Matrix SQ(x_size, 0);
+	predict_root (adaptedmodel, SQ);
+}
+
+void DDF_scheme::predict (Additive_predict_model& f)
+/* Adapt model by creating a predict with additive noise
+ *  Noise root is G*sqrt(q) so no factorisation is required
+ */
+{
+	BAYES_FILTER_TRACE_SPAN("DDF_scheme::predict");
+	Adapted_additive_model adaptedmodel(f);
+	Matrix SQ(f.G);
+	for (std::size_t j = 0; j < SQ.size2(); ++j) {
+		if (f.q[j] < 0)		// allow PSD q, let zero propagate
+			error (Numeric_exception("Predict q Not PSD"));
+		column(SQ,j) *= std::sqrt(f.q[j]);
+	}
+	predict_root (adaptedmodel, SQ);
+}
+
+void DDF_scheme::predict (Unscented_predict_model& f)
+/* Predict forward
+ *  Noise root is the Cholesky factor of Q, computed about the predicted center point
+ */
+{
+	BAYES_FILTER_TRACE_SPAN("DDF_scheme::predict");
+	Vec fx(x_size);
+	fx = f.f(x);
+	UTriMatrix UQ(x_size,x_size);
+	Float rcond = UCfactor (UQ, f.Q(fx));
+	rclimit.check_PSD(rcond, "Q not PSD in predict");
+	Matrix SQ(UQ);
+	predict_root (f, SQ);
+}
+
+void DDF_scheme::predict_root (Unscented_predict_model& f, const FM::Matrix& SQ)
+/* Predict forward with additive noise root SQ
+ *  Pre : x,SX
+ *  Post: x,SX
+ * Compound root [SXx1 SQ SXx2] of first order differences, noise and second order differences
+ */
+{
+	using std::sqrt;
+	const Float dh = sqrt(h2);		// Divided difference interval
+	const std::size_t q_size = SQ.size2();
+	Matrix A(x_size, 2*x_size + q_size);
+	Vec f0(x_size), fp(x_size), fm(x_size), xh(x_size);
+
+	f0 = f.f(x);
+	Vec xp(x_size);
+	noalias(xp) = f0 * ((h2 - Float(x_size)) / h2);
+
+	for (std::size_t j = 0; j < x_size; ++j) {
+		UTriMatrix::Column SXj = column(SX,j);
+		noalias(xh) = x + dh * SXj;
+		fp = f.f(xh);
+		noalias(xh) = x - dh * SXj;
+		fm = f.f(xh);
+		column(A,j) = (fp - fm) / (2*dh);
+		column(A,x_size+q_size+j) = (fp + fm - 2*f0) * (sqrt(h2-1) / (2*h2));
+		noalias(xp) += (fp + fm) / (2*h2);
+	}
+	for (std::size_t j = 0; j < q_size; ++j)
+		column(A,x_size+j) = column(SQ,j);
+
+	x = xp;
+	(void)UCtriangularise (SX, A);
+	update_required = true;
+}
+
+
+void DDF_scheme::observe_size (std::size_t z_size)
+/* Optimised dynamic observation sizing
+ */
+{
+	if (z_size != last_z_size) {
+		last_z_size = z_size;
+
+		s_cache.exchange (s, z_size);
+		SS_cache.exchange (SS, z_size,z_size);
+	}
+}
+
+
+Bayes_base::Float DDF_scheme::observe (Uncorrelated_additive_observe_model& h, const FM::Vec& z)
+/* Observation fusion
+ *  Noise root is sqrt(Zv) so no factorisation is required
+ */
+{
+	BAYES_FILTER_TRACE_SPAN("DDF_scheme::observe");
+	const std::size_t z_size = z.size();
+	Matrix SZ(z_size,z_size);
+	SZ.clear();
+	for (std::size_t i = 0; i < z_size; ++i) {
+		if (h.Zv[i] < 0)
+			error (Numeric_exception("Zv not PSD in observe"));
+		SZ(i,i) = std::sqrt(h.Zv[i]);
+	}
+	return observe_root (h, z, SZ);
+}
+
+Bayes_base::Float DDF_scheme::observe (Correlated_additive_observe_model& h, const FM::Vec& z)
+/* Observation fusion
+ *  Noise root is the Cholesky factor of Z
+ */
+{
+	BAYES_FILTER_TRACE_SPAN("DDF_scheme::observe");
+	UTriMatrix UZ(z.size(),z.size());
+	Float rcond = UCfactor (UZ, h.Z);
+	rclimit.check_PSD(rcond, "Z not PSD in observe");
+	Matrix SZ(UZ);
+	return observe_root (h, z, SZ);
+}
+
+Bayes_base::Float DDF_scheme::observe_root (Parametised_observe_model& h, const FM::Vec& z, const FM::Matrix& SZ)
+/* Observation fusion with additive noise root SZ
+ *  Pre : x,SX
+ *  Post: x,SX
+ * Innovation root SS from compound [SZx1 SZ SZx2] of first order differences, noise and second order differences
+ * State root from compound [SX-W*SZx1 W*SZ W*SZx2]
+ */
+{
+	using std::sqrt;
+	const Float dh = sqrt(h2);		// Divided difference interval
+	const std::size_t z_size = z.size();
+	observe_size (z_size);	// Dynamic sizing
+
+	Matrix SZx1(z_size,x_size), SZx2(z_size,x_size);
+	Vec z0(z_size), zp(z_size), zm(z_size), zpred(z_size), xh(x_size);
+
+						// Divided differences of h about x
+	z0 = h.h(x);
+	noalias(zpred) = z0 * ((h2 - Float(x_size)) / h2);
+	for (std::size_t j = 0; j < x_size; ++j) {
+		UTriMatrix::Column SXj = column(SX,j);
+		noalias(xh) = x + dh * SXj;
+		zp = h.h(xh);
+		h.normalise (zp, z0);
+		noalias(xh) = x - dh * SXj;
+		zm = h.h(xh);
+		h.normalise (zm, z0);
+		column(SZx1,j) = (zp - zm) / (2*dh);
+		column(SZx2,j) = (zp + zm - 2*z0) * (sqrt(h2-1) / (2*h2));
+		noalias(zpred) += (zp + zm) / (2*h2);
+	}
+
+						// Innovation root
+	{
+		Matrix A(z_size, 2*x_size + z_size);
+		A.sub_matrix(0,z_size, 0,x_size) = SZx1;
+		A.sub_matrix(0,z_size, x_size,x_size+z_size) = SZ;
+		A.sub_matrix(0,z_size, x_size+z_size,2*x_size+z_size) = SZx2;
+		Float rcond = UCtriangularise (SS, A);
+		rclimit.check_PD(rcond, "S not PD in observe");
+	}
+
+						// Gain W = SX*SZx1' * inv(SS*SS')
+	Matrix W(x_size, z_size);
+	{
+		Matrix WT(z_size, x_size);		// Solve SS*SS'*W' = SZx1*SX'
+		noalias(WT) = prod(SZx1, trans(SX));
+		ublas::inplace_solve (SS, WT, ublas::upper_tag());
+		ublas::inplace_solve (trans(SS), WT, ublas::lower_tag());
+		noalias(W) = trans(WT);
+	}
+
+						// Innovation
+	s = z;
+	h.normalise (s, zpred);
+	noalias(s) -= zpred;
+	noalias(x) += prod(W, s);
+
+						// State root
+	{
+		Matrix A(x_size, 2*x_size + z_size);
+		A.sub_matrix(0,x_size, 0,x_size) = SX - prod(W, SZx1);
+		A.sub_matrix(0,x_size, x_size,x_size+z_size) = prod(W, SZ);
+		A.sub_matrix(0,x_size, x_size+z_size,2*x_size+z_size) = prod(W, SZx2);
+		(void)UCtriangularise (SX, A);
+	}
+	update_required = true;
+	return UCrcond(SS);
+}
+
+
+}//namespace
@@ -0,0 +1,103 @@
+#ifndef _BAYES_FILTER_DDF
+#define _BAYES_FILTER_DDF
+
+/*
+ * Bayes++ the Bayesian Filtering Library
+ * Copyright (c) 2002 Michael Stevens
+ * See accompanying Bayes++.htm for terms and conditions of use.
+ *
+ * $Id$
+ */
+
+/*
+ * Divided Difference Filter Scheme.
+ *  A second order divided difference (DDF2) non-linear Kalman filter in square root form
+ *
+ * Predict and observe models are interpolated with Stirling's formula using central divided
+ * differences along the columns of a square root of the state covariance. The interval
+ * h = sqrt(3) is optimal for Gaussian distributions. Model Jacobians are not required.
+ * The square root is propagated directly: compound matrices of the first and second order
+ * differences and noise roots are triangularised with Householder reflections.
+ * The covariance itself is never formed by predict or observe and remains PSD by construction.
+ *
+ * The predict model is represented by the state prediction function and a
+ * separate prediction noise matrix, as for the Unscented_scheme.
+ * The observe model is represented by the observation prediction function and
+ * a function to normalise observations.
+ *
+ * The filter is operated by performing a
+ *  predict, observe
+ * cycle defined by the base class
+ *
+ * Reference
+ *  [1] "New developments in state estimation for nonlinear systems"
+ *   M Norgaard, NK Poulsen, O Ravn Automatica Vol.36 No.11 2000
+ */
+#include "bayesFlt.hpp"
+#include "unsFlt.hpp"
+
+/* Filter namespace */
+namespace Bayesian_filter
+{
+
+class DDF_scheme : public Linrz_kalman_filter, public Functional_filter
+{
+public:
+	FM::UTriMatrix SX;		// Square root of state covariance X = SX*SX'
+
+	DDF_scheme (std::size_t x_size, std::size_t z_initialsize = 0);
+	DDF_scheme& operator= (const DDF_scheme&);
+	// Optimise copy assignment to only copy filter state
+
+	void init ();
+	void update ();
+	// Update X from SX, only computed when required
+
+	void predict (Unscented_predict_model& f);
+	void predict (Functional_predict_model& f);
+	void predict (Additive_predict_model& f);
+	Float predict (Linrz_predict_model& f)
+	{	// Adapt to use the more general additive model
+		predict(static_cast<Additive_predict_model&>(f));
+		return 1.;		// Always well condition for additive predict
+	}
+
+	Float observe (Uncorrelated_additive_observe_model& h, const FM::Vec& z);
+	Float observe (Correlated_additive_observe_model& h, const FM::Vec& z);
+	// DDF implements general additive observe models
+
+	Float observe (Linrz_uncorrelated_observe_model& h, const FM::Vec& z)
+	{	// Adapt to use the more general additive model
+		return observe (static_cast<Uncorrelated_additive_observe_model&>(h),z);
+	}
+	Float observe (Linrz_correlated_observe_model& h, const FM::Vec& z)
+	{	// Adapt to use the more general additive model
+		return observe (static_cast<Correlated_additive_observe_model&>(h),z);
+	}
+
+public:						// Exposed Numerical Results
+	FM::Vec s;					// Innovation
+	FM::UTriMatrix SS;			// Square root of Innovation Covariance S = SS*SS'
+
+	static const Float h2;		// Square of divided difference interval h
+
+protected:
+	void predict_root (Unscented_predict_model& f, const FM::Matrix& SQ);
+	// Predict with additive noise root Q = SQ*SQ'
+	Float observe_root (Parametised_observe_model& h, const FM::Vec& z, const FM::Matrix& SZ);
+	// Observe with additive noise root Z = SZ*SZ'
+	bool update_required;	// Postcondition of update is not met, X does not represent SX
+
+protected:					// allow fast operation if z_size remains constant
+	std::size_t last_z_size;
+	void observe_size (std::size_t z_size);
+	FM::Size_cache<FM::Vec> s_cache;
+	FM::Size_cache<FM::UTriMatrix> SS_cache;
+
+private:
+	std::size_t x_size;
+};
+
+
+}//namespace
+#endif
@@ -0,0 +1,314 @@
+/*
+ * Bayes++ the Bayesian Filtering Library
+ * Copyright (c) 2002 Michael Stevens
+ * See accompanying Bayes++.htm for terms and conditions of use.
+ *
+ * $Id$
+ */
+
+/*
+ * Compact binary stream of Kalman state estimates.
+ */
+#include "estimateStream.hpp"
+#include "matSup.hpp"
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+
+/* Filter namespace */
+namespace Bayesian_filter
+{
+	using namespace Bayesian_filter_matrix;
+
+
+namespace {
+	const unsigned char magic[4] = {'B','E','S','T'};
+	const unsigned char version = 1;
+	const std::size_t header_size = 4 + 4 + 4 + 4 + 8 + 8;
+
+	void put_u32 (std::vector<unsigned char>& b, std::uint32_t v)
+	{
+		for (int i = 0; i != 4; ++i)
+			b.push_back (static_cast<unsigned char>(v >> (8*i)));
+	}
+	void put_u64 (std::vector<unsigned char>& b, std::uint64_t v)
+	{
+		for (int i = 0; i != 8; ++i)
+			b.push_back (static_cast<unsigned char>(v >> (8*i)));
+	}
+	void put_f32 (std::vector<unsigned char>& b, float f)
+	{
+		std::uint32_t v;
+		std::memcpy (&v, &f, sizeof(v));
+		put_u32 (b, v);
+	}
+	void put_f64 (std::vector<unsigned char>& b, double f)
+	{
+		std::uint64_t v;
+		std::memcpy (&v, &f, sizeof(v));
+		put_u64 (b, v);
+	}
+	void put_varint (std::vector<unsigned char>& b, std::int64_t i)
+	// Zig-zag variable length integer
+	{
+		std::uint64_t v = (static_cast<std::uint64_t>(i) << 1) ^ static_cast<std::uint64_t>(i >> 63);
+		while (v >= 0x80) {
+			b.push_back (static_cast<unsigned char>(v | 0x80));
+			v >>= 7;
+		}
+		b.push_back (static_cast<unsigned char>(v));
+	}
+
+	std::uint32_t get_u32 (const unsigned char* p)
+	{
+		return std::uint32_t(p[0]) | std::uint32_t(p[1]) << 8 | std::uint32_t(p[2]) << 16 | std::uint32_t(p[3]) << 24;
+	}
+	std::uint64_t get_u64 (const unsigned char* p)
+	{
+		return std::uint64_t(get_u32(p)) | std::uint64_t(get_u32(p+4)) << 32;
+	}
+	float get_f32 (const unsigned char* p)
+	{
+		std::uint32_t v = get_u32(p);
+		float f;
+		std::memcpy (&f, &v, sizeof(f));
+		return f;
+	}
+	double get_f64 (const unsigned char* p)
+	{
+		std::uint64_t v = get_u64(p);
+		double f;
+		std::memcpy (&f, &v, sizeof(f));
+		return f;
+	}
+	bool get_varint (const unsigned char*& p, const unsigned char* p_end, std::int64_t& i)
+	{
+		std::uint64_t v = 0;
+		for (unsigned shift = 0; p != p_end && shift < 64; shift += 7) {
+			const unsigned char c = *p++;
+			v |= std::uint64_t(c & 0x7f) << shift;
+			if (!(c & 0x80)) {
+				i = static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+				return true;
+			}
+		}
+		return false;
+	}
+}//namespace
+
+
+Estimate_encoder::Estimate_encoder (std::size_t x_size, Form form, Precision precision, Float x_step, Float X_step) :
+		x_size(x_size), form(form), precision(precision), x_step(x_step), X_step(X_step),
+		values(x_size + x_size*(x_size+1)/2),
+		UD(x_size,x_size), UC(x_size,x_size)
+{
+	if (precision == Quantised && !(x_step > 0 && X_step > 0))
+		error (Logic_exception("Quantised steps must be positive"));
+	key_interval = 0;
+	count = 0;
+}
+
+void Estimate_encoder::reset ()
+{
+	previous.clear();
+}
+
+void Estimate_encoder::begin ()
+{
+	buffer.clear();
+	for (int i = 0; i != 4; ++i)
+		buffer.push_back (magic[i]);
+	buffer.push_back (version);
+	buffer.push_back (static_cast<unsigned char>(form));
+	buffer.push_back (static_cast<unsigned char>(precision));
+	buffer.push_back (0);
+	put_u32 (buffer, std::uint32_t(x_size));
+	put_u32 (buffer, 0);			// Count written by end
+	put_f64 (buffer, x_step);
+	put_f64 (buffer, X_step);
+	count = 0;
+}
+
+void Estimate_encoder::add (std::uint32_t tag, Kalman_state_filter& f)
+{
+	f.update ();
+	add (tag, f.x, f.X);
+}
+
+void Estimate_encoder::add (std::uint32_t tag, const FM::Vec& x, const FM::SymMatrix& X)
+/* Encode x and the upper triangle of the form of X
+ *  Deltas are from the values reconstructed by the decoder
+ */
+{
+	assert (x.size() == x_size && X.size1() == x_size);
+	std::size_t v = 0;
+	for (std::size_t i = 0; i != x_size; ++i)
+		values[v++] = x[i];
+	switch (form) {
+	case Covariance:
+		for (std::size_t r = 0; r != x_size; ++r)
+			for (std::size_t c = r; c != x_size; ++c)
+				values[v++] = X(r,c);
+		break;
+	case UdU: {
+		Float rcond = UdUfactor (UD, X);
+		rclimit.check_PSD(rcond, "X not PSD in Estimate_encoder");
+		for (std::size_t r = 0; r != x_size; ++r)
+			for (std::size_t c = r; c != x_size; ++c)
+				values[v++] = UD(r,c);
+		}
+		break;
+	case Cholesky: {
+		Float rcond = UCfactor (UC, X);
+		rclimit.check_PSD(rcond, "X not PSD in Estimate_encoder");
+		for (std::size_t r = 0; r != x_size; ++r)
+			for (std::size_t c = r; c != x_size; ++c)
+				values[v++] = UC(r,c);
+		}
+		break;
+	}
+
+	Previous& prev = previous[tag];
+	const bool key = prev.values.empty() || (key_interval != 0 && prev.records % key_interval == 0);
+	if (key) {
+		prev.values.assign (values.size(), Float(0));
+		prev.records = 0;
+	}
+	++prev.records;
+
+	put_u32 (buffer, tag);
+	buffer.push_back (key ? 1 : 0);
+	for (std::size_t i = 0; i != values.size(); ++i) {
+		const Float delta = values[i] - prev.values[i];
+		if (precision == Single) {
+			const float d = float(delta);
+			put_f32 (buffer, d);
+			prev.values[i] += d;
+		}
+		else {
+			const Float step = i < x_size ? x_step : X_step;
+			const std::int64_t q = static_cast<std::int64_t>(std::floor(delta / step + Float(0.5)));
+			put_varint (buffer, q);
+			prev.values[i] += Float(q) * step;
+		}
+	}
+	++count;
+}
+
+const std::vector<unsigned char>& Estimate_encoder::end ()
+{
+	for (int i = 0; i != 4; ++i)
+		buffer[12+i] = static_cast<unsigned char>(count >> (8*i));
+	return buffer;
+}
+
+
+Estimate_decoder::Estimate_decoder () :
+		UD(Empty), UC(Empty)
+{
+	x_size = 0;
+	form = Estimate_encoder::Covariance;
+	precision = Estimate_encoder::Single;
+	x_step = X_step = 0;
+	p = p_end = 0;
+	count = decoded = 0;
+}
+
+void Estimate_decoder::begin (const unsigned char* data, std::size_t size)
+{
+	if (size < header_size || std::memcmp (data, magic, 4) != 0 || data[4] != version || data[5] > Estimate_encoder::Cholesky || data[6] > Estimate_encoder::Quantised)
+		error (Numeric_exception("Estimate_decoder bad header"));
+	form = static_cast<Estimate_encoder::Form>(data[5]);
+	precision = static_cast<Estimate_encoder::Precision>(data[6]);
+	const std::size_t n = get_u32(data+8);
+	if (n != x_size) {
+		x_size = n;
+		values.resize (x_size + x_size*(x_size+1)/2);
+		UD.resize (x_size,x_size, false);
+		UC.resize (x_size,x_size, false);
+	}
+	count = get_u32(data+12);
+	x_step = get_f64(data+16);
+	X_step = get_f64(data+24);
+	p = data + header_size;
+	p_end = data + size;
+	decoded = 0;
+}
+
+bool Estimate_decoder::next (std::uint32_t& tag, FM::Vec& x, FM::SymMatrix& X)
+/* The whole record is decoded into values before the previous values of the tag are changed, so a
+ *  malformed record does not corrupt the deltas of later batches
+ */
+{
+	if (decoded == count)
+		return false;
+	if (x.size() != x_size || X.size1() != x_size || X.size2() != x_size)
+		error (Logic_exception("Estimate_decoder x,X do not match x_size"));
+	const unsigned char* rp = p;
+	if (p_end - rp < 5)
+		error (Numeric_exception("Estimate_decoder truncated record"));
+	const std::uint32_t record_tag = get_u32(rp);
+	const bool key = rp[4] != 0;
+	rp += 5;
+
+	std::unordered_map<std::uint32_t, std::vector<Float> >::iterator pi = previous.find(record_tag);
+	if (!key && (pi == previous.end() || pi->second.size() != values.size()))
+		error (Numeric_exception("Estimate_decoder delta without key"));
+
+	for (std::size_t i = 0; i != values.size(); ++i) {
+		Float delta;
+		if (precision == Estimate_encoder::Single) {
+			if (p_end - rp < 4)
+				error (Numeric_exception("Estimate_decoder truncated record"));
+			delta = get_f32(rp);
+			rp += 4;
+		}
+		else {
+			std::int64_t q = 0;
+			if (!get_varint (rp, p_end, q))
+				error (Numeric_exception("Estimate_decoder truncated record"));
+			delta = Float(q) * (i < x_size ? x_step : X_step);
+		}
+		values[i] = key ? delta : pi->second[i] + delta;
+	}
+						// Record complete
+	if (key)
+		previous[record_tag] = values;
+	else
+		pi->second = values;
+	p = rp;
+	tag = record_tag;
+	++decoded;
+
+	std::size_t v = 0;
+	for (std::size_t i = 0; i != x_size; ++i)
+		x[i] = values[v++];
+	switch (form) {
+	case Estimate_encoder::Covariance:
+		for (std::size_t r = 0; r != x_size; ++r)
+			for (std::size_t c = r; c != x_size; ++c)
+				X(r,c) = values[v++];
+		break;
+	case Estimate_encoder::UdU:
+		for (std::size_t r = 0; r != x_size; ++r) {
+			for (std::size_t c = 0; c != r; ++c)
+				UD(r,c) = 0;
+			for (std::size_t c = r; c != x_size; ++c)
+				UD(r,c) = values[v++];
+		}
+		UdUrecompose (X, UD);
+		break;
+	case Estimate_encoder::Cholesky:
+		UC.clear();
+		for (std::size_t r = 0; r != x_size; ++r)
+			for (std::size_t c = r; c != x_size; ++c)
+				UC(r,c) = values[v++];
+		noalias(X) = prod(UC, trans(UC));
+		break;
+	}
+	return true;
+}
+
+
+}//namespace
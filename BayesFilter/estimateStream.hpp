@@ -0,0 +1,120 @@
+#ifndef _BAYES_FILTER_ESTIMATE_STREAM
+#define _BAYES_FILTER_ESTIMATE_STREAM
+
+/*
+ * Bayes++ the Bayesian Filtering Library
+ * Copyright (c) 2002 Michael Stevens
+ * See accompanying Bayes++.htm for terms and conditions of use.
+ *
+ * $Id$
+ */
+
+/*
+ * Compact binary stream of Kalman state estimates
+ *
+ * Estimates x,X of many tags are encoded into a single batch buffer. Only the upper triangle of X is
+ * encoded, or of its UdU' or Cholesky factor, from which the decoder recomposes a PSD X.
+ * Values are either single precision or quantised with fixed steps. Each value is encoded as a delta
+ * from the previous publication of the tag, as reconstructed by the decoder, so quantisation errors do
+ * not accumulate. Quantised deltas are zig-zag variable length integers; small changes take a single byte.
+ * The first record of a tag, and every key_interval'th record, is a key record encoded without deltas.
+ * Deltas require the decoder to receive every batch in order; reset forces key records after a loss.
+ *
+ * Batch format, little endian
+ *  header: "BEST" version:u8 form:u8 precision:u8 0:u8 x_size:u32 count:u32 x_step:f64 X_step:f64
+ *  record: tag:u32 key:u8 values
+ *  values: x then upper triangle of X (or factor) by rows, f32 or varint
+ * The decoder reads records in place from the caller's buffer.
+ */
+#include "bayesFlt.hpp"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/* Filter namespace */
+namespace Bayesian_filter
+{
+
+class Estimate_encoder : public Bayes_base
+{
+public:
+	enum Form { Covariance, UdU, Cholesky };	// Representation of X
+	enum Precision { Single, Quantised };
+
+	Estimate_encoder (std::size_t x_size, Form form, Precision precision, Float x_step = 0, Float X_step = 0);
+	/* x_step and X_step are the quantisation steps of x and of X or its factor, for Quantised precision
+	 */
+
+	void begin ();
+	// Begin a batch
+	void add (std::uint32_t tag, Kalman_state_filter& f);
+	void add (std::uint32_t tag, const FM::Vec& x, const FM::SymMatrix& X);
+	// Add the estimate of tag to the batch
+	const std::vector<unsigned char>& end ();
+	// End the batch, Return: the batch buffer valid until the next begin
+
+	void reset ();
+	// Force key records for all tags
+
+	std::size_t key_interval;		// Records of a tag between key records, 0 for only the first
+
+	const std::size_t x_size;
+	const Form form;
+	const Precision precision;
+	const Float x_step, X_step;
+	Numerical_rcond rclimit;
+
+private:
+	struct Previous
+	{
+		std::vector<Float> values;	// Reconstructed by the decoder
+		std::size_t records;
+	};
+	std::unordered_map<std::uint32_t, Previous> previous;
+	std::vector<unsigned char> buffer;
+	std::uint32_t count;
+	std::vector<Float> values;
+	FM::RowMatrix UD;
+	FM::UTriMatrix UC;
+};
+
+
+class Estimate_decoder : public Bayes_base
+{
+public:
+	Estimate_decoder ();
+
+	void begin (const unsigned char* data, std::size_t size);
+	/* Begin decoding a batch in place, data must remain valid while decoding
+	 *  Throws Numeric_exception for a malformed header
+	 */
+	bool next (std::uint32_t& tag, FM::Vec& x, FM::SymMatrix& X);
+	/* Decode the next record of the batch into tag,x,X
+	 *  Return: false at end of batch
+	 *  Throws Numeric_exception for a malformed record or a delta record of an unknown tag,
+	 *   the record is not decoded and the tag's previous values are unchanged
+	 *  Throws Logic_exception if x,X are not of the batch's x_size
+	 */
+	std::size_t size () const
+	// Records in the batch
+	{	return count;
+	}
+
+	std::size_t x_size;
+	Estimate_encoder::Form form;
+	Estimate_encoder::Precision precision;
+	Float x_step, X_step;
+
+private:
+	std::unordered_map<std::uint32_t, std::vector<Float> > previous;
+	const unsigned char* p;
+	const unsigned char* p_end;
+	std::size_t count, decoded;
+	std::vector<Float> values;
+	FM::RowMatrix UD;
+	FM::UTriMatrix UC;
+};
+
+
+}//namespace
+#endif
@@ -0,0 +1,324 @@
+#ifndef _BAYES_FILTER_GAUSSIAN_SUM
+#define _BAYES_FILTER_GAUSSIAN_SUM
+
+/*
+ * Bayes++ the Bayesian Filtering Library
+ * Copyright (c) 2002 Michael Stevens
+ * See accompanying Bayes++.htm for terms and conditions of use.
+ *
+ * $Id$
+ */
+
+/*
+ * Predefined filter: Gaussian_sum_scheme
+ *  A Gaussian sum filter for multimodal distributions with any linearised Kalman filter Scheme
+ *
+ * The distribution is represented by a weighted bank of Kalman components (x,X). Predict and observe
+ * of each component are computed by a single working Scheme. The moment matched x,X of the mixture
+ * are exposed through Kalman_state_filter.
+ *
+ * Observe may use a mixture observation noise model; each component is then split into one component
+ * for each noise mode, weighted by the mode's weight and the likelihood of its innovation. This
+ * represents observations such as ranges which may be either direct or reflected.
+ *
+ * Each cycle the mixture is reduced: components with small weights are pruned, then pairs are merged
+ * until there are at most max_components. The pair merged is that of least Runnalls' cost [1], the
+ * bound on the Kullback-Leibler discrimination of the mixture before and after the merge. Pair costs
+ * are held in a priority queue. A merge only adds the costs of the merged component with the others,
+ * costs of removed components are discarded lazily, so costs are not recomputed for each merge.
+ *
+ * References
+ *  [1] "Kullback-Leibler approach to Gaussian mixture reduction"
+ *   AR Runnalls IEEE Transactions on Aerospace and Electronic Systems Vol.43 No.3 2007
+ *  [2] "Recursive Bayesian estimation using Gaussian sums"
+ *   HW Sorenson, DL Alspach Automatica Vol.7 1971
+ */
+#include "../matSup.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <vector>
+
+/* Filter namespace */
+namespace Bayesian_filter
+{
+
+template <class Scheme>
+class Gaussian_sum_scheme : public Linrz_kalman_filter
+{
+public:
+	struct Component
+	{
+		Component (Float weight, const FM::Vec& x, const FM::SymMatrix& X) : weight(weight), x(x), X(X)
+		{}
+		Float weight;
+		FM::Vec x;
+		FM::SymMatrix X;
+	};
+	typedef std::vector<Component> Components;
+
+	struct Noise_mode
+	// Mode of a mixture of uncorrelated observation noise, z = h(x) + mean + N(0,Zv)
+	{
+		Noise_mode (Float weight, const FM::Vec& mean, const FM::Vec& Zv) : weight(weight), mean(mean), Zv(Zv)
+		{}
+		Float weight;
+		FM::Vec mean;
+		FM::Vec Zv;
+	};
+	typedef std::vector<Noise_mode> Noise_modes;
+
+	Gaussian_sum_scheme (std::size_t x_size, Scheme& working, std::size_t max_components) :
+		Kalman_state_filter(x_size),
+		max_components(max_components), working(working)
+	/* working scheme is used to compute predict and observe for all components
+	 */
+	{
+		prune_threshold = Float(1e-6);
+	}
+
+	void init ()
+	// Initialise with a single component
+	{
+		components.assign (1, Component(1, x, X));
+	}
+
+	void update ()
+	// Moment matched x,X of the mixture
+	{
+		x.clear();
+		for (typename Components::const_iterator ci = components.begin(); ci != components.end(); ++ci)
+			noalias(x) += ci->weight * ci->x;
+		X.clear();
+		FM::Vec d(x.size());
+		for (typename Components::const_iterator ci = components.begin(); ci != components.end(); ++ci) {
+			noalias(d) = ci->x - x;
+			noalias(X) += ci->weight * ci->X;		// Separate terms, uBLAS cannot evaluate sym + outer_prod
+			noalias(X) += ci->weight * FM::outer_prod(d, d);
+		}
+	}
+
+	Float predict (Linrz_predict_model& f)
+	{
+		Float rcond = 1;
+		for (typename Components::iterator ci = components.begin(); ci != components.end(); ++ci) {
+			working.init_kalman (ci->x, ci->X);
+			rcond = std::min(rcond, working.predict (f));
+			working.update ();
+			ci->x = working.x;
+			ci->X = working.X;
+		}
+		return rcond;
+	}
+
+	Float observe (Linrz_uncorrelated_observe_model& h, const FM::Vec& z)
+	{
+		return observe_components (h, z);
+	}
+	Float observe (Linrz_correlated_observe_model& h, const FM::Vec& z)
+	{
+		return observe_components (h, z);
+	}
+
+	Float observe (Linrz_uncorrelated_observe_model& h, const Noise_modes& modes, const FM::Vec& z)
+	/* Observation z with a mixture observation noise model, h.Zv is replaced by that of each mode
+	 *  Each component is split into one component for each mode
+	 */
+	{
+		const FM::Vec Zv(h.Zv);
+		Components split;
+		split.reserve (components.size() * modes.size());
+		std::vector<Float> logw;
+		logw.reserve (split.capacity());
+		FM::Vec zm(z.size());
+		Float rcond = 1;
+		for (typename Components::const_iterator ci = components.begin(); ci != components.end(); ++ci) {
+			for (typename Noise_modes::const_iterator mi = modes.begin(); mi != modes.end(); ++mi) {
+				noalias(h.Zv) = mi->Zv;
+				noalias(zm) = z - mi->mean;
+				logw.push_back (std::log(ci->weight * mi->weight) + innovation_likelihood (h, *ci, zm));
+				working.init_kalman (ci->x, ci->X);
+				rcond = std::min(rcond, working.observe (h, zm));
+				working.update ();
+				split.push_back (Component(0, working.x, working.X));
+			}
+		}
+		noalias(h.Zv) = Zv;
+		components.swap (split);
+		normalise (logw);
+		reduce ();
+		return rcond;
+	}
+
+	void reduce ()
+	/* Prune components with small weights, then merge the pairs of least Runnalls' cost
+	 * until there are at most max_components
+	 */
+	{
+		typename Components::iterator last = components.begin();
+		for (typename Components::iterator ci = components.begin(); ci != components.end(); ++ci) {
+			if (ci->weight >= prune_threshold)
+				*last++ = *ci;
+		}
+		components.erase (last, components.end());
+		renormalise ();
+		if (components.size() <= max_components)
+			return;
+
+		const std::size_t n = components.size();
+		std::vector<Float> logdet(n);
+		std::vector<unsigned> version(n, 0);
+		std::vector<bool> alive(n, true);
+		for (std::size_t i = 0; i != n; ++i)
+			logdet[i] = log_det (components[i].X);
+
+		std::priority_queue<Pair, std::vector<Pair>, std::greater<Pair> > costs;
+		for (std::size_t i = 0; i != n; ++i)
+			for (std::size_t j = i+1; j != n; ++j)
+				costs.push (pair (i, j, logdet, version));
+
+		std::size_t nalive = n;
+		while (nalive > max_components) {
+			const Pair p = costs.top();
+			costs.pop();
+			if (!alive[p.i] || !alive[p.j] || version[p.i] != p.vi || version[p.j] != p.vj)
+				continue;			// Cost of a removed or merged component
+			merge (components[p.i], components[p.j]);
+			alive[p.j] = false;
+			--nalive;
+			++version[p.i];
+			++version[p.j];
+			logdet[p.i] = log_det (components[p.i].X);
+			for (std::size_t k = 0; k != n; ++k) {
+				if (alive[k] && k != p.i)
+					costs.push (k < p.i ? pair (k, p.i, logdet, version) : pair (p.i, k, logdet, version));
+			}
+		}
+
+		Components reduced;
+		reduced.reserve (nalive);
+		for (std::size_t i = 0; i != n; ++i) {
+			if (alive[i])
+				reduced.push_back (components[i]);
+		}
+		components.swap (reduced);
+		assert (std::abs(total_weight() - 1) < 1e-9);	// Merging conserves weight
+	}
+
+	Components components;			// Weighted bank of Kalman components
+	const std::size_t max_components;	// Bound on components after reduce
+	Float prune_threshold;			// Components with smaller weights are removed
+
+private:
+	template <class Observe_model>
+	Float observe_components (Observe_model& h, const FM::Vec& z)
+	{
+		std::vector<Float> logw;
+		logw.reserve (components.size());
+		Float rcond = 1;
+		for (typename Components::iterator ci = components.begin(); ci != components.end(); ++ci) {
+			logw.push_back (std::log(ci->weight) + innovation_likelihood (h, *ci, z));
+			working.init_kalman (ci->x, ci->X);
+			rcond = std::min(rcond, working.observe (h, z));
+			working.update ();
+			ci->x = working.x;
+			ci->X = working.X;
+		}
+		normalise (logw);
+		reduce ();
+		return rcond;
+	}
+
+	template <class Observe_model>
+	Float innovation_likelihood (Observe_model& h, const Component& c, const FM::Vec& z)
+	// Log likelihood of innovation of z given component c, -0.5*(s'*inv(S)*s + log(det(S)))
+	{
+		const std::size_t z_size = z.size();
+		FM::Vec zp(z_size), s(z_size);
+		zp = h.h(c.x);
+		s = z;
+		h.normalise (s, zp);
+		noalias(s) -= zp;
+		FM::SymMatrix S(z_size,z_size);
+		FM::RowMatrix SUD(z_size,z_size);
+		Float rcond = FM::UdUinnovation (SUD, S, h.Hx, c.X, additive_noise(h));
+		h.rclimit.check_PD(rcond, "S not PD in Gaussian_sum_scheme");
+		return FM::UdUloglikelihood (SUD, FM::UdUmahalanobis (SUD, s));
+	}
+
+	void normalise (const std::vector<Float>& logw)
+	// Weights from log weights, scaled by the largest to avoid underflow
+	{
+		const Float logw_max = *std::max_element(logw.begin(), logw.end());
+		for (std::size_t i = 0; i != components.size(); ++i)
+			components[i].weight = std::exp(logw[i] - logw_max);
+		renormalise ();
+	}
+	Float total_weight () const
+	{
+		Float sum = 0;
+		for (typename Components::const_iterator ci = components.begin(); ci != components.end(); ++ci)
+			sum += ci->weight;
+		return sum;
+	}
+	void renormalise ()
+	{
+		const Float sum = total_weight();
+		for (typename Components::iterator ci = components.begin(); ci != components.end(); ++ci)
+			ci->weight /= sum;
+	}
+
+	struct Pair
+	// Merge cost of components i < j at their versions
+	{
+		Float cost;
+		std::size_t i, j;
+		unsigned vi, vj;
+		bool operator> (const Pair& b) const
+		{	return cost > b.cost;
+		}
+	};
+
+	Pair pair (std::size_t i, std::size_t j, const std::vector<Float>& logdet, const std::vector<unsigned>& version)
+	/* Runnalls' cost of merging components i and j
+	 *  0.5*((wi+wj)*log(det(Xij)) - wi*log(det(Xi)) - wj*log(det(Xj)))
+	 */
+	{
+		Component m = components[i];
+		merge (m, components[j]);
+		Pair p;
+		p.cost = Float(0.5) * (m.weight * log_det (m.X) - components[i].weight * logdet[i] - components[j].weight * logdet[j]);
+		p.i = i; p.j = j;
+		p.vi = version[i]; p.vj = version[j];
+		return p;
+	}
+
+	static void merge (Component& a, const Component& b)
+	// Moment matched merge of b into a
+	{
+		const Float w = a.weight + b.weight;
+		const Float wa = a.weight / w, wb = b.weight / w;
+		FM::Vec d(a.x - b.x);
+		a.X *= wa;
+		noalias(a.X) += wb * b.X;
+		noalias(a.X) += (wa * wb) * FM::outer_prod(d, d);
+		noalias(a.x) = wa * a.x + wb * b.x;
+		a.weight = w;
+	}
+
+	Float log_det (const FM::SymMatrix& X)
+	{
+		FM::RowMatrix UD(X.size1(), X.size2());
+		Float rcond = FM::UdUfactor (UD, X);
+		rclimit.check_PD(rcond, "Component X not PD in reduce");
+		return FM::UdUlogdet (UD);
+	}
+
+	Scheme& working;
+};
+
+
+}//namespace
+#endif
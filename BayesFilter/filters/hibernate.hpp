@@ -0,0 +1,179 @@
+#ifndef _BAYES_FILTER_HIBERNATE
+#define _BAYES_FILTER_HIBERNATE
+
+/*
+ * Bayes++ the Bayesian Filtering Library
+ * Copyright (c) 2002 Michael Stevens
+ * See accompanying Bayes++.htm for terms and conditions of use.
+ *
+ * $Id$
+ */
+
+/*
+ * Predefined filter: Hibernating_filter
+ *  Hibernation of idle Kalman filters into a shared compact store
+ *
+ * A scheme holds its state and also the workspace matrices and vectors of its algorithms. For
+ * many idle filters the workspaces dominate resident memory. Hibernate reduces a filter to its minimal
+ * state, x and the packed upper triangle of the UdU' factor of X, stored in a Compact_state_store shared
+ * by many filters. The scheme, and so all its workspaces, is then destroyed.
+ * The Value type of the store is Float by default. It may be float to halve the storage again, at the
+ * cost of rounding the state to single precision on each hibernation.
+ * A hibernating filter is woken lazily when next accessed: the scheme is recreated by a factory and
+ * initialised from the stored state.
+ */
+#include "../matSup.hpp"
+#include <boost/function.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <vector>
+
+/* Filter namespace */
+namespace Bayesian_filter
+{
+
+template <class Value>
+class Compact_state_store : public Bayes_base
+/* Contiguous storage of fixed size records of a Kalman state
+ *  Record: x followed by the upper triangle of the UdU' factor of X by rows, with d on the diagonal
+ */
+{
+public:
+	typedef std::size_t Slot;
+
+	Compact_state_store (std::size_t x_size) :
+		x_size(x_size), record_size(x_size + x_size*(x_size+1)/2)
+	{}
+
+	Slot store (const FM::Vec& x, const FM::SymMatrix& X)
+	// Store state x,X in a free slot
+	{
+		FM::RowMatrix UD(x_size,x_size);
+		Float rcond = FM::UdUfactor (UD, X);
+		rclimit.check_PSD(rcond, "X not PSD in store");
+		Slot slot;
+		if (free_slots.empty()) {
+			slot = values.size() / record_size;
+			values.resize (values.size() + record_size);
+		}
+		else {
+			slot = free_slots.back();
+			free_slots.pop_back();
+		}
+		typename std::vector<Value>::iterator vi = values.begin() + slot*record_size;
+		for (std::size_t i = 0; i != x_size; ++i)
+			*vi++ = Value(x[i]);
+		for (std::size_t r = 0; r != x_size; ++r)
+			for (std::size_t c = r; c != x_size; ++c)
+				*vi++ = Value(UD(r,c));
+		return slot;
+	}
+
+	void load (Slot slot, FM::Vec& x, FM::SymMatrix& X) const
+	// Load state x,X from slot
+	{
+		typename std::vector<Value>::const_iterator vi = values.begin() + slot*record_size;
+		for (std::size_t i = 0; i != x_size; ++i)
+			x[i] = *vi++;
+		FM::RowMatrix UD(x_size,x_size);
+		for (std::size_t r = 0; r != x_size; ++r) {
+			for (std::size_t c = 0; c != r; ++c)
+				UD(r,c) = 0;
+			for (std::size_t c = r; c != x_size; ++c)
+				UD(r,c) = *vi++;
+		}
+		FM::UdUrecompose (X, UD);
+	}
+
+	void release (Slot slot)
+	// Slot is free for reuse
+	{
+		free_slots.push_back (slot);
+	}
+
+	std::size_t bytes () const
+	// Storage of all slots
+	{
+		return values.capacity() * sizeof(Value) + free_slots.capacity() * sizeof(Slot);
+	}
+
+	const std::size_t x_size;
+	const std::size_t record_size;		// Values in each record
+	Numerical_rcond rclimit;
+
+private:
+	std::vector<Value> values;
+	std::vector<Slot> free_slots;
+};
+
+
+template <class Scheme, class Value = Bayes_base::Float>
+class Hibernating_filter
+/* A Kalman filter Scheme which may hibernate into a Compact_state_store
+ *  The scheme is created by factory, initially and on waking
+ */
+{
+public:
+	typedef boost::function0<Scheme*> Factory;
+
+	Hibernating_filter (const Factory& factory, Compact_state_store<Value>& store) :
+		factory(factory), compact(store), scheme(factory())
+	{}
+	~Hibernating_filter ()
+	{
+		if (!scheme)
+			compact.release (slot);
+	}
+
+	Scheme& filter ()
+	// The scheme, woken if hibernating
+	{
+		if (!scheme) {
+			scheme.reset (factory());
+			compact.load (slot, scheme->x, scheme->X);
+			compact.release (slot);
+			scheme->init ();
+		}
+		return *scheme;
+	}
+
+	bool hibernating () const
+	{
+		return !scheme;
+	}
+
+	void hibernate ()
+	/* Store the state and destroy the scheme
+	 *  Post: hibernating
+	 */
+	{
+		if (scheme) {
+			scheme->update ();
+			slot = compact.store (scheme->x, scheme->X);
+			scheme.reset ();
+		}
+	}
+
+	template <class Predict_model>
+	auto predict (Predict_model& f) -> decltype(filter().predict(f))
+	{
+		return filter().predict (f);
+	}
+	template <class Observe_model>
+	auto observe (Observe_model& h, const FM::Vec& z) -> decltype(filter().observe(h, z))
+	{
+		return filter().observe (h, z);
+	}
+
+private:
+	Hibernating_filter (const Hibernating_filter&);
+	Hibernating_filter& operator= (const Hibernating_filter&);
+
+	Factory factory;
+	Compact_state_store<Value>& compact;
+	boost::scoped_ptr<Scheme> scheme;		// Empty when hibernating
+	typename Compact_state_store<Value>::Slot slot;
+};
+
+
+}//namespace
+#endif
@@ -0,0 +1,265 @@
+#ifndef _BAYES_FILTER_MHT
+#define _BAYES_FILTER_MHT
+
+/*
+ * Bayes++ the Bayesian Filtering Library
+ * Copyright (c) 2002 Michael Stevens
+ * See accompanying Bayes++.htm for terms and conditions of use.
+ *
+ * $Id$
+ */
+
+/*
+ * Predefined filter: Hypothesis_tracker
+ *  Multiple hypothesis tracking (MHT) for a single target over any Kalman_state_filter scheme
+ *
+ * Hypotheses are leaves of a hypothesis tree. Each refers to an immutable Kalman state (x,X) by a
+ * shared pointer, so forking a hypothesis copies no state: a missed detection hypothesis and its
+ * parent share the same state, and all hypotheses forked from one parent share its predicted state.
+ * A new state is only created when a hypothesis is modified (copy on write), and predict is computed
+ * once for each distinct state.
+ * Predict and observe are computed by a single working Scheme, so its factors and temporary
+ * storage are shared by all hypotheses rather than copied with them.
+ *
+ * Each scan every hypothesis forks into a missed detection and one hypothesis for each gated measurement.
+ * Pruning:
+ *  N-scan: hypotheses which do not share the best hypothesis' ancestor N scans ago are removed,
+ *   so hypotheses differ only in their last N decisions
+ *  Budget: the least likely hypotheses are removed until the number of hypotheses and the storage of
+ *   their distinct states are within bounds
+ *
+ * Reference
+ *  [1] "Multiple hypothesis tracking for multiple target tracking"
+ *   SS Blackman IEEE Aerospace and Electronic Systems Magazine Vol.19 No.1 2004
+ */
+#include "../matSup.hpp"
+#include <boost/shared_ptr.hpp>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <vector>
+
+/* Filter namespace */
+namespace Bayesian_filter
+{
+
+template <class Scheme>
+class Hypothesis_tracker : public Bayes_base
+{
+public:
+	struct State
+	// Immutable Kalman state shared by hypotheses
+	{
+		State (const FM::Vec& x, const FM::SymMatrix& X) : x(x), X(X)
+		{}
+		const FM::Vec x;
+		const FM::SymMatrix X;
+	};
+	struct Node
+	// Node of the hypothesis tree, only the ancestry is represented
+	{
+		Node (const boost::shared_ptr<Node>& parent, std::size_t scan) : parent(parent), scan(scan)
+		{}
+		boost::shared_ptr<Node> parent;		// Empty beyond the N-scan window
+		const std::size_t scan;
+	};
+	struct Hypothesis
+	{
+		boost::shared_ptr<const State> state;
+		boost::shared_ptr<Node> node;
+		Float log_weight;		// Log likelihood of measurement history, normalised so the best is 0
+	};
+	typedef std::vector<Hypothesis> Hypotheses;
+
+	Hypothesis_tracker (Scheme& working, std::size_t n_scan, std::size_t max_hypotheses, std::size_t max_state_bytes) :
+		n_scan(n_scan), max_hypotheses(max_hypotheses), max_state_bytes(max_state_bytes), working(working)
+	/* working scheme is used to compute predict and observe for all hypotheses
+	 *  Precond: max_hypotheses > 0
+	 */
+	{
+		if (max_hypotheses == 0)
+			error (Logic_exception("Hypothesis_tracker requires at least one hypothesis"));
+		scan = 0;
+		gate = 16;
+	}
+
+	void init (const FM::Vec& x, const FM::SymMatrix& X)
+	// Initialise with a single hypothesis
+	{
+		Hypothesis h;
+		h.state.reset (new State(x, X));
+		h.node.reset (new Node(boost::shared_ptr<Node>(), scan));
+		h.log_weight = 0;
+		hypotheses.assign (1, h);
+	}
+
+	template <class Predict_model>
+	void predict (Predict_model& f)
+	/* Predict all hypotheses
+	 *  Predict is computed once for each distinct state
+	 */
+	{
+		std::map<const State*, boost::shared_ptr<const State> > predicted;
+		for (typename Hypotheses::iterator hi = hypotheses.begin(); hi != hypotheses.end(); ++hi) {
+			boost::shared_ptr<const State>& p = predicted[hi->state.get()];
+			if (!p) {
+				working.init_kalman (hi->state->x, hi->state->X);
+				working.predict (f);
+				working.update ();
+				p.reset (new State(working.x, working.X));
+			}
+			hi->state = p;
+		}
+	}
+
+	template <class Observe_model>
+	void observe (Observe_model& h, const std::vector<FM::Vec>& zs, Float log_missed)
+	/* Scan of measurements zs, any (or none) of which may be the target
+	 *  Each hypothesis forks into a missed detection, with additional log likelihood log_missed, and an
+	 *  observation of each z within the gate. Observation log likelihood is that of the innovation.
+	 *  The hypotheses are then pruned
+	 */
+	{
+		++scan;
+		Hypotheses forked;
+		forked.reserve (hypotheses.size() * (zs.size() + 1));
+		for (typename Hypotheses::const_iterator hi = hypotheses.begin(); hi != hypotheses.end(); ++hi) {
+			Hypothesis missed;				// Shares state with the parent
+			missed.state = hi->state;
+			missed.node.reset (new Node(hi->node, scan));
+			missed.log_weight = hi->log_weight + log_missed;
+			forked.push_back (missed);
+
+			for (typename std::vector<FM::Vec>::const_iterator zi = zs.begin(); zi != zs.end(); ++zi) {
+				Float logL;
+				if (!innovation_likelihood (h, *hi->state, *zi, logL))
+					continue;				// Outside gate
+				working.init_kalman (hi->state->x, hi->state->X);
+				working.observe (h, *zi);
+				working.update ();
+				Hypothesis observed;
+				observed.state.reset (new State(working.x, working.X));
+				observed.node.reset (new Node(hi->node, scan));
+				observed.log_weight = hi->log_weight + logL;
+				forked.push_back (observed);
+			}
+		}
+		hypotheses.swap (forked);
+		prune ();
+	}
+
+	const Hypothesis& best () const
+	// Most likely hypothesis, Precond: init
+	{
+		return hypotheses.front();
+	}
+
+	const Hypotheses& all () const
+	// All hypotheses ordered by decreasing likelihood
+	{
+		return hypotheses;
+	}
+
+	std::size_t state_bytes () const
+	// Storage of distinct states of all hypotheses
+	{
+		std::map<const State*, bool> distinct;
+		for (typename Hypotheses::const_iterator hi = hypotheses.begin(); hi != hypotheses.end(); ++hi)
+			distinct[hi->state.get()] = true;
+		return distinct.size() * bytes (hypotheses.front().state->x.size());
+	}
+
+	const std::size_t n_scan;			// Depth of N-scan pruning
+	const std::size_t max_hypotheses;	// Bound on number of hypotheses
+	const std::size_t max_state_bytes;	// Bound on storage of distinct states
+	Float gate;							// Mahalanobis gate on innovations
+
+private:
+	template <class Observe_model>
+	bool innovation_likelihood (Observe_model& h, const State& s, const FM::Vec& z, Float& logL)
+	/* Log likelihood of innovation of z given state s, -0.5*(s'*inv(S)*s + log(det(S)))
+	 *  Return false if z is outside the gate
+	 */
+	{
+		const std::size_t z_size = z.size();
+		FM::Vec zp(z_size), si(z_size);
+		zp = h.h(s.x);
+		si = z;
+		h.normalise (si, zp);
+		noalias(si) -= zp;
+		FM::SymMatrix S(z_size,z_size);
+		FM::RowMatrix SUD(z_size,z_size);
+		Float rcond = FM::UdUinnovation (SUD, S, h.Hx, s.X, additive_noise(h));
+		h.rclimit.check_PD(rcond, "S not PD in Hypothesis_tracker");
+		const Float d2 = FM::UdUmahalanobis (SUD, si);
+		if (d2 > gate)
+			return false;
+		logL = FM::UdUloglikelihood (SUD, d2);
+		return true;
+	}
+
+	static std::size_t bytes (std::size_t x_size)
+	{
+		return sizeof(State) + (x_size + x_size*x_size) * sizeof(Float);
+	}
+
+	struct More_likely
+	{
+		bool operator() (const Hypothesis& a, const Hypothesis& b) const
+		{	return a.log_weight > b.log_weight;
+		}
+	};
+
+	void prune ()
+	/* N-scan then budget pruning
+	 *  Post: hypotheses ordered by decreasing likelihood, the best has log_weight 0
+	 */
+	{
+		std::stable_sort (hypotheses.begin(), hypotheses.end(), More_likely());
+		if (scan >= n_scan) {			// N-scan
+			Node* keep = ancestor (hypotheses.front().node.get());
+			typename Hypotheses::iterator last = hypotheses.begin();
+			for (typename Hypotheses::iterator hi = hypotheses.begin(); hi != hypotheses.end(); ++hi) {
+				if (ancestor (hi->node.get()) == keep)
+					*last++ = *hi;
+			}
+			hypotheses.erase (last, hypotheses.end());
+			keep->parent.reset();		// All hypotheses share this ancestry, so it can be forgotten
+		}
+										// Budget
+		if (hypotheses.size() > max_hypotheses)
+			hypotheses.erase (hypotheses.begin() + max_hypotheses, hypotheses.end());
+		const std::size_t state_size = bytes (hypotheses.front().state->x.size());
+		std::map<const State*, bool> distinct;
+		for (std::size_t i = 0; i != hypotheses.size(); ++i) {
+			distinct[hypotheses[i].state.get()] = true;
+			if (i > 0 && distinct.size() * state_size > max_state_bytes) {
+				hypotheses.erase (hypotheses.begin() + i, hypotheses.end());
+				break;
+			}
+		}
+
+		const Float best_weight = hypotheses.front().log_weight;
+		for (typename Hypotheses::iterator hi = hypotheses.begin(); hi != hypotheses.end(); ++hi)
+			hi->log_weight -= best_weight;
+	}
+
+	Node* ancestor (Node* node) const
+	/* Ancestor n_scan scans ago
+	 *  Each hypothesis has its own node, so hypotheses with the same ancestor differ only in their
+	 *  last n_scan decisions. n_scan 0 keeps only the best hypothesis
+	 */
+	{
+		for (std::size_t n = 0; n != n_scan && node->parent; ++n)
+			node = node->parent.get();
+		return node;
+	}
+
+	std::size_t scan;		// Number of observe scans
+	Hypotheses hypotheses;
+	Scheme& working;
+};
+
+
+}//namespace
+#endif
@@ -0,0 +1,202 @@
+#ifndef _BAYES_FILTER_PDA
+#define _BAYES_FILTER_PDA
+
+/*
+ * Bayes++ the Bayesian Filtering Library
+ * Copyright (c) 2002 Michael Stevens
+ * See accompanying Bayes++.htm for terms and conditions of use.
+ *
+ * $Id$
+ */
+
+/*
+ * Predefined filter: Data_association
+ *  Probabilistic data association (PDA) and joint probabilistic data association (JPDA)
+ *  of cluttered measurements for any Kalman_state_filter scheme with a linearised observe model
+ *
+ * Measurements are gated by the Mahalanobis distance of their innovation. The likelihood of each gated
+ * measurement is PD*N(s;0,S), that of clutter is the clutter density scaled by the probability the target
+ * is not detected within the gate, (1-PD*PG). From these association probabilities beta are computed, and
+ * each target has a single combined update with the weighted innovation sum(beta_i*s_i). The spread of
+ * innovations is added to the covariance so that association uncertainty is represented:
+ *  X = X - W*((1-beta_0)*S - (sum(beta_i*s_i*s_i') - s*s'))*W'
+ *
+ * For multiple targets the joint association probabilities are approximated with the cheap JPDA of [2].
+ * Each target-measurement probability is normalised by the competing likelihoods of the target and of the
+ * measurement, so the cost is that of the gated likelihoods. It is exact for a single target.
+ *
+ * References
+ *  [1] "Tracking and Data Association"
+ *   Y Bar-Shalom, TE Fortmann Academic Press 1988
+ *  [2] "Development of practical PDA logic for multitarget tracking by microprocessor"
+ *   RJ Fitzgerald Proc. American Control Conference 1986
+ */
+#include "../matSup.hpp"
+#include <cmath>
+#include <vector>
+
+/* Filter namespace */
+namespace Bayesian_filter
+{
+
+class Data_association : public Bayes_base
+{
+public:
+	struct Association
+	// Gated measurements of one target
+	{
+		Association () : S(FM::Empty), W(FM::Empty)
+		{}
+		std::vector<std::size_t> gated;		// Index of gated measurements
+		std::vector<FM::Vec> s;				// Innovation of gated measurements
+		std::vector<Float> G;				// Likelihood of gated measurements, PD*N(s;0,S)
+		FM::SymMatrix S;					// Innovation covariance
+		FM::RowMatrix W;					// Kalman gain
+	};
+
+	Data_association (Float PD, Float PG, Float clutter_density) :
+		PD(PD), PG(PG), clutter_density(clutter_density)
+	/* PD probability of detection, PG probability a detection is within the gate,
+	 *  clutter_density expected number of clutter measurements per unit volume of measurement space
+	 */
+	{
+		gate = 16;
+	}
+
+	template <class Observe_model>
+	Float pda (Kalman_state_filter& f, Observe_model& h, const std::vector<FM::Vec>& zs)
+	/* Probabilistic data association of measurements zs with the target f
+	 *  Post: f is initialised with the combined update, unchanged if there is no clutter
+	 *   and no measurement is gated, a missed detection
+	 *  Return the probability that no measurement is the target
+	 */
+	{
+		Association a;
+		associate (a, f, h, zs);
+		const Float b = clutter();
+		Float sumG = 0;
+		for (std::size_t i = 0; i != a.G.size(); ++i)
+			sumG += a.G[i];
+		if (b + sumG <= 0)
+			return 1;
+		std::vector<Float> beta(a.G.size());
+		for (std::size_t i = 0; i != a.G.size(); ++i)
+			beta[i] = a.G[i] / (b + sumG);
+		const Float beta0 = b / (b + sumG);
+		combine (f, a, beta, beta0);
+		return beta0;
+	}
+
+	template <class Observe_model>
+	void jpda (const std::vector<Kalman_state_filter*>& targets, Observe_model& h, const std::vector<FM::Vec>& zs, std::vector<Float>& beta0)
+	/* Cheap joint probabilistic data association of measurements zs with the targets
+	 *  The targets share the observe model h, which is linearised at each target in turn
+	 *  Post: targets are initialised with their combined update,
+	 *   beta0 the probability that no measurement is each target
+	 */
+	{
+		const std::size_t nt = targets.size();
+		std::vector<Association> a(nt);
+		std::vector<Float> sum_target(nt, Float(0)), sum_measurement(zs.size(), Float(0));
+		for (std::size_t t = 0; t != nt; ++t) {
+			associate (a[t], *targets[t], h, zs);
+			for (std::size_t i = 0; i != a[t].G.size(); ++i) {
+				sum_target[t] += a[t].G[i];
+				sum_measurement[a[t].gated[i]] += a[t].G[i];
+			}
+		}
+
+		const Float b = clutter();
+		beta0.resize (nt);
+		std::vector<Float> beta;
+		for (std::size_t t = 0; t != nt; ++t) {
+			beta.resize (a[t].G.size());
+			Float sum_beta = 0;
+			for (std::size_t i = 0; i != a[t].G.size(); ++i) {
+				const Float G = a[t].G[i];
+				const Float norm = sum_target[t] + sum_measurement[a[t].gated[i]] - G + b;
+				beta[i] = norm > 0 ? G / norm : 0;
+				sum_beta += beta[i];
+			}
+			beta0[t] = 1 - sum_beta;
+			combine (*targets[t], a[t], beta, beta0[t]);
+		}
+	}
+
+	template <class Observe_model>
+	void associate (Association& a, Kalman_state_filter& f, Observe_model& h, const std::vector<FM::Vec>& zs)
+	/* Gate measurements zs and compute their likelihood for target f
+	 *  Post: a, f.x,f.X are current
+	 */
+	{
+		f.update ();
+		const std::size_t x_size = f.x.size(), z_size = h.Hx.size1();
+		FM::Vec zp(z_size), si(z_size);
+		zp = h.h(f.x);				// Also linearises Hx about x
+
+		a.S.resize (z_size,z_size, false);
+		FM::RowMatrix SUD(z_size,z_size);
+		Float rcond = FM::UdUinnovation (SUD, a.S, h.Hx, f.X, additive_noise(h));
+		h.rclimit.check_PD(rcond, "S not PD in Data_association");
+
+		a.W.resize (x_size,z_size, false);
+		noalias(a.W) = FM::prod(f.X, FM::trans(h.Hx));
+		FM::UdUsolve_right (SUD, a.W);
+
+		const Float two_pi = Float(2) * std::acos(Float(-1));
+		const Float lognorm = Float(-0.5) * Float(z_size) * std::log(two_pi);	// Gaussian normalisation
+		a.gated.clear(); a.s.clear(); a.G.clear();
+		for (std::size_t i = 0; i != zs.size(); ++i) {
+			si = zs[i];
+			h.normalise (si, zp);
+			noalias(si) -= zp;
+			FM::Vec sv(si);
+			const Float d2 = FM::UdUmahalanobis (SUD, si);
+			if (d2 > gate)
+				continue;				// Outside gate
+			a.gated.push_back (i);
+			a.s.push_back (sv);
+			a.G.push_back (PD * std::exp(FM::UdUloglikelihood (SUD, d2) + lognorm));
+		}
+	}
+
+	static void combine (Kalman_state_filter& f, const Association& a, const std::vector<Float>& beta, Float beta0)
+	/* Combined update of target f with association probabilities beta of the gated measurements and beta0 of none
+	 *  Pre : f.x,f.X are those of associate
+	 *  Post: f is initialised with the update
+	 */
+	{
+		const std::size_t z_size = a.S.size1();
+		FM::Vec s(z_size);
+		s.clear();
+		for (std::size_t i = 0; i != beta.size(); ++i)
+			noalias(s) += beta[i] * a.s[i];
+						// Covariance reduction less the spread of innovations
+		FM::SymMatrix M(z_size,z_size);
+		noalias(M) = (1 - beta0) * a.S;
+		for (std::size_t i = 0; i != beta.size(); ++i)
+			noalias(M) -= beta[i] * FM::outer_prod(a.s[i], a.s[i]);
+		noalias(M) += FM::outer_prod(s, s);
+
+		noalias(f.x) += FM::prod(a.W, s);
+		FM::RowMatrix temp(a.W.size1(), z_size);
+		FM::minus_assign_prod_SPD (f.X, a.W, M, temp);
+		f.init ();
+	}
+
+	const Float PD;					// Probability of detection
+	const Float PG;					// Probability a detection is within the gate
+	const Float clutter_density;	// Clutter measurements per unit volume
+	Float gate;						// Mahalanobis gate on innovations
+
+private:
+	Float clutter () const
+	// Likelihood that a measurement is clutter relative to a target
+	{
+		return clutter_density * (1 - PD*PG);
+	}
+};
+
+
+}//namespace
+#endif
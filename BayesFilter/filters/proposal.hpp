@@ -0,0 +1,170 @@
+#ifndef _BAYES_FILTER_PROPOSAL
+#define _BAYES_FILTER_PROPOSAL
+
+/*
+ * Bayes++ the Bayesian Filtering Library
+ * Copyright (c) 2002 Michael Stevens
+ * See accompanying Bayes++.htm for terms and conditions of use.
+ *
+ * $Id$
+ */
+
+/*
+ * Predefined filter: Proposal_SIR_scheme
+ *  SIR filter sampling from a linearised proposal which includes the observation
+ *  The bootstrap proposal of SIR_scheme::predict samples the prior transition only. With sharp
+ *  likelihoods most samples then have negligible weight. Here the proposal for each sample is the
+ *  posterior of a local Kalman filter (Local_filter) which observes the sample's predicted noise.
+ *  Weights are corrected by the ratio of prior transition to proposal.
+ *   Local_filter = Unscented_scheme: unscented proposal
+ *   Local_filter = Covariance_scheme: extended Kalman filter proposal, Hx must be valid after h(x) is evaluated
+ *
+ * References
+ *  [1] "On sequential Monte Carlo sampling methods for Bayesian filtering"
+ *   A Doucet, S Godsill, C Andrieu Statistics and Computing Vol.10 2000
+ *  [2] "The Unscented Particle Filter"
+ *   R van der Merwe, A Doucet, N de Freitas, E Wan Technical Report CUED/F-INFENG/TR 380 2000
+ */
+#include "../matSup.hpp"
+#include <algorithm>
+#include <cmath>
+
+/* Filter namespace */
+namespace Bayesian_filter
+{
+
+template <class Local_filter>
+class Proposal_SIR_scheme : public SIR_scheme
+{
+public:
+	Proposal_SIR_scheme (std::size_t x_size, std::size_t s_size, std::size_t q_size, SIR_random& random_helper) :
+		Sample_state_filter (x_size, s_size),
+		SIR_scheme (x_size, s_size, random_helper),
+		local(q_size, 0)
+	{}
+
+	void predict_observe (Additive_predict_model& f, Linrz_uncorrelated_observe_model& h, const FM::Vec& z)
+	/* Predict samples with the additive noise f and weight by the observation z of h
+	 *  The proposal is computed in the space of the predict noise G*w so f may have singular G*q*G'.
+	 *  Identical samples from resampling share one proposal
+	 *  Pre : S represent the prior distribution, f.q > 0
+	 *  Post: S represent the predicted distribution, wir fused (multiplicative) with the corrected weights
+	 */
+	{
+		const std::size_t x_size = S.size1(), q_size = f.q.size(), z_size = z.size();
+		Noise_observe_model hw(f, h, x_size, q_size, z_size);
+		FM::Vec w(q_size), n(q_size), zp(z_size), zInnov(z_size);
+		FM::Vec::value_type logdetQ = 0, logdetZ = 0;
+		for (std::size_t j = 0; j != q_size; ++j)
+			logdetQ += std::log(f.q[j]);
+		for (std::size_t j = 0; j != z_size; ++j)
+			logdetZ += std::log(h.Zv[j]);
+		FM::RowMatrix UD(q_size, q_size), U(q_size, q_size);
+		FM::Vec d(q_size);
+		FM::DenseVec logw(S.size2());
+
+		FM::DenseVec nd(q_size);
+		const std::size_t nSamples = S.size2();
+		std::size_t si = 0, ri = 0;
+		while (si != nSamples)
+		{						// Run of identical samples
+			const std::size_t run_end = copies.empty() ? si+1 : si + copies[ri++];
+			noalias(hw.m) = f.f(FM::column(S,si));
+			hw.relinearise ();
+
+								// Local Kalman filter of the noise w ~ N(0,q) observing z
+			local.x.clear();
+			local.X.clear();
+			for (std::size_t j = 0; j != q_size; ++j)
+				local.X(j,j) = f.q[j];
+			local.init ();
+			local.observe (hw, z);
+			local.update ();
+								// Proposal N(local.x, local.X) = local.x + U*sqrt(d)*n
+			FM::Float rcond = FM::UdUfactor (UD, local.X);
+			f.rclimit.check_PD(rcond, "Proposal not PD in predict_observe");
+			FM::UdUseperate (U, d, UD);
+			FM::Vec::value_type logdetP = 0;
+			for (std::size_t j = 0; j != q_size; ++j) {
+				logdetP += std::log(d[j]);
+				d[j] = std::sqrt(d[j]);
+			}
+
+			for (; si != run_end; ++si) {
+				random.normal (nd);
+				n = nd;
+				FM::Vec::value_type logq = 0;
+				for (std::size_t j = 0; j != q_size; ++j) {
+					logq += n[j]*n[j];
+					n[j] *= d[j];
+				}
+				noalias(w) = local.x;
+				noalias(w) += FM::prod(U, n);
+				FM::Vec::value_type logp = 0;
+				for (std::size_t j = 0; j != q_size; ++j)
+					logp += w[j]*w[j] / f.q[j];
+				FM::ColMatrix::Column Si(S,si);
+				noalias(Si) = hw.m;
+				noalias(Si) += FM::prod(f.G, w);
+								// Likelihood of z at the sample
+				noalias(zp) = h.h(Si);
+				zInnov = z;
+				h.normalise (zInnov, zp);
+				noalias(zInnov) -= zp;
+				FM::Vec::value_type logL = 0;
+				for (std::size_t j = 0; j != z_size; ++j)
+					logL += zInnov[j]*zInnov[j] / h.Zv[j];
+
+				logw[si] = FM::Float(-0.5) * ((logL + logdetZ) + (logp + logdetQ) - (logq + logdetP));
+			}
+		}
+								// Fuse weights, scaled by the largest to avoid underflow
+		const FM::Float logw_max = *std::max_element(logw.begin(), logw.end());
+		for (std::size_t i = 0; i != nSamples; ++i)
+			wir[i] *= std::exp(logw[i] - logw_max);
+		wir_update = true;
+		stochastic_samples = nSamples;
+		copies.clear();
+	}
+
+private:
+	class Noise_observe_model : public Linrz_uncorrelated_observe_model
+	/* Observation of predict noise w: h(f(x) + G*w)
+	 */
+	{
+	public:
+		Noise_observe_model (const Additive_predict_model& f, Linrz_uncorrelated_observe_model& h, std::size_t x_size, std::size_t q_size, std::size_t z_size) :
+			Linrz_uncorrelated_observe_model(q_size, z_size),
+			m(x_size), f(f), hx(h), xw(x_size)
+		{
+			Zv = hx.Zv;
+		}
+		void relinearise ()
+		// Linearise about w = 0 for the current m
+		{
+			(void)hx.h(m);
+			noalias(Hx) = FM::prod(hx.Hx, f.G);
+		}
+		const FM::Vec& h (const FM::Vec& w) const
+		{
+			noalias(xw) = m;
+			noalias(xw) += FM::prod(f.G, w);
+			return hx.h(xw);
+		}
+		void normalise (FM::Vec& z_denorm, const FM::Vec& z_from) const
+		{
+			hx.normalise (z_denorm, z_from);
+		}
+		FM::Vec m;		// f(x) of the sample
+	private:
+		const Additive_predict_model& f;
+		Linrz_uncorrelated_observe_model& hx;
+		mutable FM::Vec xw;
+	};
+
+	Local_filter local;
+};
+
+
+}//namespace
+#endif
@@ -11,6 +11,7 @@
  */
 #include "infFlt.hpp"
 #include "matSup.hpp"
+#include "bayesTrace.hpp"
 
 /* Filter namespace */
 namespace Bayesian_filter
@@ -29,6 +30,7 @@ Information_scheme::Information_scheme (std::size_t x_size, std::size_t z_initia
 	last_z_size = 0;	// Matrices conform to z_initialsize, they are left Empty if z_initialsize==0
 	observe_size (z_initialsize);
 	update_required = true;	// Not a valid state, init is required before update can be used
+	update_yY_required = false;
 }
 
 Information_scheme::Linear_predict_byproducts::Linear_predict_byproducts (std::size_t x_size, std::size_t q_size) :
@@ -46,6 +48,8 @@ Information_scheme& Information_scheme::operator= (const Information_scheme& a)
 {
 	Information_state_filter::operator=(a);
 	Kalman_state_filter::operator=(a);
+	update_required = a.update_required;
+	update_yY_required = a.update_yY_required;
 	return *this;
 }
 
@@ -65,6 +69,7 @@ void Information_scheme::init ()
 						// Information state
 	noalias(y) = prod(Y,x);
 	update_required = false;
+	update_yY_required = false;
 }
 
 void Information_scheme::init_yY ()
@@ -79,13 +84,27 @@ void Information_scheme::init_yY ()
 	if (!isPSD (Y))
 		error (Numeric_exception("Initial Y not PSD"));
 	update_required = true;
+	update_yY_required = false;
 }
 
 void Information_scheme::update_yY ()
-/* Postcondition:
- *		y, Y is PSD
+/* Recompute y,Y from x,X
+ *  Optimised using update_yY_required (postcondition met iff update_yY_required false)
+ * Precondition:
+ *		x, X is PD
+ * Postcondition:
+ *		y=Y*x, Y=inv(X) is PD
+ *		x, X is PD
  */
 {
+	if (update_yY_required)
+	{		// Information
+		Float rcond = UdUinversePD (Y, X);
+		rclimit.check_PD(rcond, "X not PD in update_yY");
+
+		noalias(y) = prod(Y,x);
+		update_yY_required = false;
+	}
 }
 
 void Information_scheme::update ()
@@ -98,6 +117,7 @@ void Information_scheme::update ()
  *		y, Y is PD
  */
 {
+	BAYES_FILTER_TRACE_SPAN("Information_scheme::update");
 	if (update_required)
 	{		// Covariance
 		Float rcond = UdUinversePD (X, Y);
@@ -112,20 +132,19 @@ Bayes_base::Float
  Information_scheme::predict (Linrz_predict_model& f)
 /* Extended linrz information prediction
  *  Computation is through state to accommodate linearised model
+ *  The information form is not predicted: y,Y are recomputed by update_yY only when required.
+ *  Therefore a sequence of predicts requires no inversions
  */
 {
+	BAYES_FILTER_TRACE_SPAN("Information_scheme::predict");
 	update ();			// x,X required
 	x = f.f(x);			// Extended Kalman state predict is f(x) directly
-						// Predict information matrix, and state covariance
-	noalias(X) = prod_SPD(f.Fx,X, tempX);
+						// Predict state covariance
+	assign_prod_SPD (X, f.Fx, X, tempX);
 	noalias(X) += prod_SPD(f.G, f.q, tempX);
 
-						// Information
-	Float rcond = UdUinversePD (Y, X);
-	rclimit.check_PD(rcond, "X not PD in predict");
-						// Predict information state
-	noalias(y) = prod(Y,x);
-	return rcond;
+	update_yY_required = true;
+	return 1;
 }
 
 Float Information_scheme::predict (Linear_invertable_predict_model& f, Linear_predict_byproducts& b)
@@ -140,6 +159,8 @@ Float Information_scheme::predict (Linear_invertable_predict_model& f, Linear_pr
  * Therefore both zero noises and zeros in the couplings can be used
  */
 {
+	BAYES_FILTER_TRACE_SPAN("Information_scheme::predict");
+	update_yY ();		// y,Y required
 						// A = invFx'*Y*invFx ,Inverse Predict covariance
 	noalias(b.A) = prod_SPDT(f.inv.Fx, Y, tempX);
 						// B = G'*A*G+invQ , A in coupled additive noise space
@@ -178,7 +199,7 @@ inline void Information_scheme::observe_size (std::size_t z_size)
 	if (z_size != last_z_size) {
 		last_z_size = z_size;
 
-		ZI.resize(z_size,z_size, false);
+		ZI_cache.exchange (ZI, z_size,z_size);
 	}
 }
 
@@ -187,10 +208,12 @@ Bayes_base::Float
 /* Correlated innovation observe
  */
 {
+	BAYES_FILTER_TRACE_SPAN("Information_scheme::observe_innovation");
 						// Size consistency, z to model
 	if (s.size() != h.Z.size1())
 		error (Logic_exception("observation and model size inconsistent"));
 	observe_size (s.size());// Dynamic sizing
+	update_yY ();			// y,Y required
 
 	Vec zz(s + prod(h.Hx,x));		// Strange EIF observation object
 
@@ -198,15 +221,31 @@ Bayes_base::Float
 	Float rcond = UdUinversePD (ZI, h.Z);
 	rclimit.check_PD(rcond, "Z not PD in observe");
 
-	RowMatrix HxT (trans(h.Hx));
-	RowMatrix HxTZI (prod(HxT, ZI));
+	if (isSelection (h.Hx, Hx_selection))
+	{						// Selection Hx: scatter ZI*zz and ZI directly into y,Y
+		Vec ZIzz (prod(ZI, zz));
+		const std::size_t z_size = Hx_selection.size();
+		for (std::size_t a = 0; a < z_size; ++a) {
+			const std::size_t k = Hx_selection[a];
+			y[k] += ZIzz[a];
+			for (std::size_t b = 0; b < z_size; ++b) {
+				if (k <= Hx_selection[b])		// Only the upper triangle of Y, which includes duplicate selections
+					Y(k,Hx_selection[b]) += ZI(a,b);
+			}
+		}
+	}
+	else
+	{
+		RowMatrix HxT (trans(h.Hx));
+		RowMatrix HxTZI (prod(HxT, ZI));
 												// Calculate EIF i = Hx'*ZI*zz
-	noalias(i) = prod(HxTZI, zz);
+		noalias(i) = prod(HxTZI, zz);
 												// Calculate EIF I = Hx'*ZI*Hx
-	noalias(I) = prod(HxTZI, trans(HxT));				// use column matrix trans(HxT)
+		noalias(I) = prod(HxTZI, trans(HxT));				// use column matrix trans(HxT)
 
-	noalias(y) += i;
-	noalias(Y) += I;
+		noalias(y) += i;
+		noalias(Y) += I;
+	}
 	update_required = true;
 
 	return rcond;
@@ -217,10 +256,12 @@ Bayes_base::Float
 /* Extended linrz uncorrelated observe
  */
 {
+	BAYES_FILTER_TRACE_SPAN("Information_scheme::observe_innovation");
 						// Size consistency, z to model
 	if (s.size() != h.Zv.size())
 		error (Logic_exception("observation and model size inconsistent"));
 	observe_size (s.size());// Dynamic sizing
+	update_yY ();			// y,Y required
 
 	Vec zz(s + prod(h.Hx,x));		// Strange EIF observation object
 
@@ -228,16 +269,28 @@ Bayes_base::Float
 	Float rcond = UdUrcond(h.Zv);
 	rclimit.check_PD(rcond, "Zv not PD in observe");
 
-	RowMatrix HxT (trans(h.Hx));      			// HxT = Hx'*inverse(Z)
-	for (std::size_t w = 0; w < h.Zv.size(); ++w)
-		column(HxT, w) *= 1 / h.Zv[w];
+	if (isSelection (h.Hx, Hx_selection))
+	{						// Selection Hx: scatter diagonal ZI and ZI*zz directly into y,Y
+		for (std::size_t w = 0; w < h.Zv.size(); ++w) {
+			const std::size_t k = Hx_selection[w];
+			const Float zi = 1 / h.Zv[w];
+			y[k] += zi * zz[w];
+			Y(k,k) += zi;
+		}
+	}
+	else
+	{
+		RowMatrix HxT (trans(h.Hx));      			// HxT = Hx'*inverse(Z)
+		for (std::size_t w = 0; w < h.Zv.size(); ++w)
+			column(HxT, w) *= 1 / h.Zv[w];
 												// Calculate EIF i = Hx'*ZI*zz
-	noalias(i) = prod(HxT, zz);
+		noalias(i) = prod(HxT, zz);
 												// Calculate EIF I = Hx'*ZI*Hx
-	noalias(I) = prod(HxT, h.Hx);
+		noalias(I) = prod(HxT, h.Hx);
 
-	noalias(y) += i;
-	noalias(Y) += I;
+		noalias(y) += i;
+		noalias(Y) += I;
+	}
 	update_required = true;
 
 	return rcond;
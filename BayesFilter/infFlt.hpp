@@ -27,6 +27,11 @@
  * For linear invertible models predict can be done directly without computing x
  * Discontinuous observe models require that predict is normailised with
  * respect to the observation.
+ * Representation
+ *  Both covariance x,X and information y,Y forms are maintained lazily. Extended predict works
+ *  in covariance form and leaves y,Y to be recomputed by update_yY. Observe and linear predict work
+ *  in information form and leave x,X to be recomputed by update. A chain of predicts or a chain of observes
+ *  therefore requires no inversions, only a switch between the two requires one.
  * NUMERICS
  *  The state x is represented by prod(X,y). This may be ill conditioned if the product is
  *  ill conditioned. At present only the conditioning of X if checked, if y has a large range the product
@@ -81,15 +86,18 @@ public:
 
 protected:
 	bool update_required;	// Postcondition of update is not met
+	bool update_yY_required;	// Postcondition of update_yY is not met
 
 protected:			   		// Permanently allocated temps
 	FM::RowMatrix tempX;
 	FM::Vec i;
 	FM::SymMatrix I;
+	std::vector<std::size_t> Hx_selection;
 					// allow fast operation if z_size remains constant
 	FM::SymMatrix ZI;
 	std::size_t last_z_size;
 	void observe_size (std::size_t z_size);
+	FM::Size_cache<FM::SymMatrix> ZI_cache;
 };
 
 
@@ -11,6 +11,7 @@
  */
 #include "infRtFlt.hpp"
 #include "matSup.hpp"
+#include "bayesTrace.hpp"
 #include "uLAPACK.hpp"	// Common LAPACK interface
 #include <algorithm>
 
@@ -25,7 +26,9 @@ Information_root_scheme::Information_root_scheme (std::size_t x_size, std::size_
 		r(x_size), R(x_size,x_size)
 /* Set the size of things we know about
  */
-{}
+{
+	update_required = true;	// Not a valid state, init is required before update can be used
+}
 
 Information_root_info_scheme::Information_root_info_scheme (std::size_t x_size, std::size_t z_initialsize) :
 		Kalman_state_filter(x_size), Information_state_filter (x_size), 
@@ -49,6 +52,7 @@ void Information_root_scheme::init ()
 	assert (!singular); (void)singular;
 						// Information Root state r=R*x
 	noalias(r) = prod(R,x);
+	update_required = false;
 }
 
 void Information_root_info_scheme::init_yY ()
@@ -89,10 +93,12 @@ void Information_root_info_scheme::init_yY ()
 	bool singular = UTinverse(RI);
 	assert (!singular); (void)singular;
 	noalias(r) = prod(FM::trans(RI),y);
+	update_required = true;
 }
 
 void Information_root_scheme::update ()
 /* Recompute x,X from r,R
+ *  Optimised using update_required (postcondition met iff update_required false)
  * Precondition:
  *		r(k|k),R(k|k)
  * Postcondition:
@@ -101,13 +107,42 @@ void Information_root_scheme::update ()
  *		X = inv(R)*inv(R)'
  */
 {
-	UTriMatrix RI (R);	// Invert Cholesky factor
-	bool singular = UTinverse (RI);
-	if (singular)
-		error (Numeric_exception("R not PD"));
+	BAYES_FILTER_TRACE_SPAN("Information_root_scheme::update");
+	if (update_required)
+	{
+		UTriMatrix RI (R);	// Invert Cholesky factor
+		bool singular = UTinverse (RI);
+		if (singular)
+			error (Numeric_exception("R not PD"));
+
+		noalias(X) = prod_SPD(RI);		// X = RI*RI'
+		noalias(x) = prod(RI,r);
+		update_required = false;
+	}
+}
 
-	noalias(X) = prod_SPD(RI);		// X = RI*RI'
-	noalias(x) = prod(RI,r);
+void Information_root_scheme::update_x ()
+/* Recompute x from r,R without forming X
+ *  Back substitution of R*x = r avoids inverting R
+ * Precondition:
+ *		r(k|k),R(k|k)
+ * Postcondition:
+ *		x = inv(R)*r
+ */
+{
+	if (update_required)
+	{
+		const std::size_t n = x.size();
+		for (std::size_t i = n; i-- > 0; )
+		{
+			Float xi = r[i];
+			for (std::size_t j = i+1; j < n; ++j)
+				xi -= R(i,j) * x[j];
+			if (R(i,i) == 0)
+				error (Numeric_exception("R not PD"));
+			x[i] = xi / R(i,i);
+		}
+	}
 }
 
 void Information_root_info_scheme::update_yY ()
@@ -163,8 +198,9 @@ Bayes_base::Float
  * Requires LAPACK geqrf for QR decomposition (without PIVOTING)
  */
 {
+	BAYES_FILTER_TRACE_SPAN("Information_root_scheme::predict");
 	if (!linear_r)
-		update ();		// x is required for f(x);
+		update_x ();	// x is required for f(x);
 
 						// Require Root of correlated predict noise (may be semidefinite)
 	Matrix Gqr (f.G);
@@ -198,6 +234,7 @@ Bayes_base::Float
 		noalias(r) = A.sub_column(q_size,q_size+x_size, q_size+x_size);
 	else
 		noalias(r) = prod(R,f.f(x));	// compute r using f(x)
+	update_required = true;
 
 	return UCrcond(R);	// compute rcond of result
 }
@@ -208,6 +245,7 @@ Bayes_base::Float
 /* Linrz Prediction: computes inverse model using inverse_Fx
  */
 {
+	BAYES_FILTER_TRACE_SPAN("Information_root_scheme::predict");
 						// Require inverse(Fx)
 	DenseColMatrix FxI(f.Fx.size1(), f.Fx.size2());
 	inverse_Fx (FxI, f.Fx);
@@ -221,6 +259,7 @@ Bayes_base::Float
 /* Linear Prediction: computes inverse model using inverse_Fx
  */
 {
+	BAYES_FILTER_TRACE_SPAN("Information_root_scheme::predict");
 						// Require inverse(Fx)
 	DenseColMatrix FxI(f.Fx.size1(), f.Fx.size2());
 	inverse_Fx (FxI, f.Fx);
@@ -240,6 +279,7 @@ Bayes_base::Float Information_root_scheme::observe_innovation (Linrz_correlated_
  * ISSUE correctness of linrz form needs validation
  */
 {
+	BAYES_FILTER_TRACE_SPAN("Information_root_scheme::observe_innovation");
 	const std::size_t x_size = x.size();
 	const std::size_t z_size = s.size();
 						// Size consistency, z to model
@@ -267,6 +307,7 @@ Bayes_base::Float Information_root_scheme::observe_innovation (Linrz_correlated_
 						// Extract the roots, junk in strict lower triangle
 	noalias(R) = UpperTri( A.sub_matrix(0,x_size, 0,x_size) );
 	noalias(r) = A.sub_column(0,x_size, x_size);
+	update_required = true;
 
 	return UCrcond(R);	// compute rcond of result
 }
@@ -284,6 +325,7 @@ Bayes_base::Float Information_root_scheme::observe_innovation (Linrz_uncorrelate
  * ISSUE Efficiency. Product of Zir can be simplified
  */
 {
+	BAYES_FILTER_TRACE_SPAN("Information_root_scheme::observe_innovation");
 	const std::size_t x_size = x.size();
 	const std::size_t z_size = s.size();
 						// Size consistency, z to model
@@ -312,6 +354,7 @@ Bayes_base::Float Information_root_scheme::observe_innovation (Linrz_uncorrelate
 						// Extract the roots, junk in strict lower triangle
 	noalias(R) = UpperTri( A.sub_matrix(0,x_size, 0,x_size) );
 	noalias(r) = A.sub_column(0,x_size, x_size);
+	update_required = true;
 
 	return UCrcond(R);	// compute rcond of result
 }
@@ -44,6 +44,8 @@ public:
 	void init ();
 	void update ();
 	// Covariance form state interface
+	void update_x ();
+	// Recompute only x, X is left unchanged
 
 	Float predict (Linrz_predict_model& f, const FM::ColMatrix& invFx, bool linear_r);
 	/* Generalised form, using precomputed inverse of f.Fx */
@@ -63,6 +65,9 @@ public:
 
 	static void inverse_Fx (FM::DenseColMatrix& invFx, const FM::Matrix& Fx);
 	/* Numerical Inversion of Fx using LU factorisation */
+
+protected:
+	bool update_required;	// Postcondition of update is not met
 };
 
 
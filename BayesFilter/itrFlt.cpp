@@ -12,6 +12,7 @@
 #include "itrFlt.hpp"
 #include "matSup.hpp"
 #include "models.hpp"
+#include "bayesTrace.hpp"
 
 /* Filter namespace */
 namespace Bayesian_filter
@@ -30,8 +31,8 @@ bool Counted_iterated_terminator::term_or_relinearize (const Iterated_covariance
 
 Iterated_covariance_scheme::Iterated_covariance_scheme(std::size_t x_size, std::size_t z_initialsize) :
 		Kalman_state_filter(x_size),
-		S(Empty), SI(Empty),
-		tempX(x_size,x_size),
+		S(Empty),
+			tempX(x_size,x_size),
 		s(Empty), HxT(Empty)
 /* Initialise filter and set the size of things we know about
  */
@@ -59,15 +60,17 @@ void Iterated_covariance_scheme::init ()
 
 void Iterated_covariance_scheme::update ()
 {
+	BAYES_FILTER_TRACE_SPAN("Iterated_covariance_scheme::update");
 	// Nothing to do, implicit in observation
 }
 
 Bayes_base::Float
  Iterated_covariance_scheme::predict (Linrz_predict_model& f)
 {
+	BAYES_FILTER_TRACE_SPAN("Iterated_covariance_scheme::predict");
 	x = f.f(x);			// Extended Kalman state predict is f(x) directly
 						// Predict state covariance
-	noalias(X) = prod_SPD(f.Fx,X, tempX);
+	assign_prod_SPD (X, f.Fx, X, tempX);
 	noalias(X) += prod_SPD(f.G, f.q, tempX);
 
 	return 1;
@@ -81,10 +84,10 @@ void Iterated_covariance_scheme::observe_size (std::size_t z_size)
 	if (z_size != last_z_size) {
 		last_z_size = z_size;
 
-		s.resize(z_size, false);
-		S.resize(z_size,z_size, false);
-		SI.resize(z_size,z_size, false);
-		HxT.resize(x.size(),z_size, false);
+		s_cache.exchange (s, z_size);
+		S_cache.exchange (S, z_size,z_size);
+		factor_size (z_size);
+		HxT_cache.exchange (HxT, x.size(),z_size);
 	}
 }
 
@@ -97,6 +100,7 @@ Bayes_base::Float
  * Uncorrelated noise
  */
 {
+	BAYES_FILTER_TRACE_SPAN("Iterated_covariance_scheme::observe");
 						// ISSUE: Implement simplified uncorrelated noise equations
 	Adapted_Linrz_correlated_observe_model hh(h);
 	return observe (hh, term, z);
@@ -111,26 +115,26 @@ Bayes_base::Float
  * returned rcond is of S (or 1 if no iterations are performed)
  */
 {
+	BAYES_FILTER_TRACE_SPAN("Iterated_covariance_scheme::observe");
 	std::size_t x_size = x.size();
 	std::size_t z_size = z.size();
-	SymMatrix ZI(z_size,z_size);
-	Matrix HxT(x_size,z_size);
+	observe_size (z_size);	// Dynamic sizing
 
 	Vec xpred = x;			// Initialise iteration
 	SymMatrix Xpred = X;
-							// Inverse predicted covariance
-	SymMatrix XpredI(x_size,x_size);
-	Float rcond = UdUinversePD (XpredI, Xpred);
+							// Factorise predicted covariance
+	RowMatrix XpredUD(x_size,x_size);
+	Float rcond = UdUfactor (XpredUD, Xpred);
 	rclimit.check_PD(rcond, "Xpred not PD in observe");
 
-							// Inverse observation covariance
-	rcond = UdUinversePD (ZI, h.Z);
+							// Factorise observation covariance
+	RowMatrix ZUD(z_size,z_size);
+	rcond = UdUfactor (ZUD, h.Z);
 	rclimit.check_PD(rcond, "Z not PD in observe");
 				
 	RowMatrix HxXtemp(h.Hx.size1(),X.size2());
-	RowMatrix temp1(x_size,x_size), temp2(x_size,z_size);
-	SymMatrix temp3(x_size,x_size);
-	Vec tempz(z_size);
+	RowMatrix temp2(x_size,z_size), W(x_size,z_size);
+	Vec tempx(x_size), tempz(z_size);
 
 	do {
 							// Observation model, linearize about new x
@@ -142,20 +146,23 @@ Bayes_base::Float
 		noalias(s) -= zp;
 							// Innovation covariance
 		noalias(S) = prod_SPD(h.Hx, Xpred, HxXtemp) + h.Z;
-							// Inverse innovation covariance
-		rcond = UdUinversePD (SI, S);
+							// Factorise innovation covariance
+		rcond = factor_S (S);
 		rclimit.check_PD(rcond, "S not PD in observe");
 
-							// Iterative observe
-		noalias(temp3) = prod_SPD(HxT,SI, temp2);
-		noalias(temp1) = prod(Xpred,temp3);
-		noalias(X) = Xpred - prod(temp1,Xpred);
+							// Iterative observe, X = Xpred - Xpred*Hx'*inv(S)*Hx*Xpred
+		noalias(temp2) = prod(Xpred,HxT);
+		noalias(W) = temp2;
+		UdUsolve_right (SUD, W);
+		noalias(X) = Xpred - prod(W,trans(temp2));
 
-							// New state iteration
+							// New state iteration, x += X*Hx'*inv(Z)*s - X*inv(Xpred)*(x-xpred)
 		noalias(temp2) = prod(X,HxT);
-		noalias(temp1) = prod(X,XpredI);
-		noalias(tempz) = prod(ZI,s);
-		x += prod(temp2, tempz) - prod(temp1, (x - xpred));
+		noalias(tempz) = s;
+		UdUsolve (ZUD, tempz);
+		noalias(tempx) = x - xpred;
+		UdUsolve (XpredUD, tempx);
+		x += prod(temp2, tempz) - prod(X, tempx);
 	} while (!term.term_or_relinearize(*this));
 	return rcond;
 }
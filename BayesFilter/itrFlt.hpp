@@ -79,7 +79,7 @@ public:
 
 
 
-class Iterated_covariance_scheme : public Linrz_kalman_filter
+class Iterated_covariance_scheme : public Linrz_kalman_filter, public Innovation_factor
 {
 public:
 	Iterated_covariance_scheme (std::size_t x_size, std::size_t z_initialsize = 0);
@@ -107,7 +107,7 @@ public:
 	}
 
 public:						// Exposed Numerical Results
-	FM::SymMatrix S, SI;		// Innovation Covariance and Inverse
+	FM::SymMatrix S;			// Innovation Covariance
 
 protected:			   		// Permanently allocated temps
 	FM::RowMatrix tempX;
@@ -115,6 +115,9 @@ protected:			   		// Permanently allocated temps
 protected:					// allow fast operation if z_size remains constant
 	std::size_t last_z_size;
 	void observe_size (std::size_t z_size);
+	FM::Size_cache<FM::Vec> s_cache;
+	FM::Size_cache<FM::SymMatrix> S_cache;
+	FM::Size_cache<FM::RowMatrix> HxT_cache;
 							// Permanently allocated temps
 	FM::Vec s;
 	FM::Matrix HxT;
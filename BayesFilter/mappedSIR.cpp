@@ -0,0 +1,360 @@
+/*
+ * Bayes++ the Bayesian Filtering Library
+ * Copyright (c) 2002 Michael Stevens
+ * See accompanying Bayes++.htm for terms and conditions of use.
+ *
+ * $Id$
+ */
+
+/*
+ * Out-of-core Sampling Importance Resampling Filter.
+ */
+#include "mappedSIR.hpp"
+#include "bayesTrace.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define BAYES_FILTER_MMAP
+#include <sys/mman.h>
+#include <stdlib.h>
+#include <unistd.h>
+#endif
+
+
+/* Filter namespace */
+namespace Bayesian_filter
+{
+	using namespace Bayesian_filter_matrix;
+
+
+namespace {
+
+class Chunk_stream
+/* Advise the paging of records streamed sequentially a chunk at a time
+ *  at(i) is called for each record in order. Entering a chunk prefetches the next chunk
+ *  and releases the previous chunk. The last chunk is released at destruction
+ */
+{
+public:
+	Chunk_stream (Float* records, std::size_t record_size, std::size_t s_size, std::size_t chunk_size) :
+		records(records), record_size(record_size), s_size(s_size), chunk_size(chunk_size)
+	{
+		boundary = 0;
+	}
+	~Chunk_stream ()
+	{
+		if (boundary != 0)
+			advise (boundary - chunk_size, boundary, false);
+	}
+	void at (std::size_t i)
+	{
+		if (i == boundary) {
+			if (boundary == 0)
+				advise (0, chunk_size, true);
+			else
+				advise (boundary - chunk_size, boundary, false);
+			advise (boundary + chunk_size, boundary + 2*chunk_size, true);
+			boundary += chunk_size;
+		}
+	}
+private:
+	void advise (std::size_t first, std::size_t last, bool need)
+	// Advise paging of whole pages of records first..last
+	{
+#ifdef BAYES_FILTER_MMAP
+		first = std::min (first, s_size);
+		last = std::min (last, s_size);
+		if (first == last)
+			return;
+		static const std::size_t page = std::size_t(sysconf (_SC_PAGESIZE));
+		std::size_t begin = reinterpret_cast<std::size_t>(records + first*record_size);
+		std::size_t end = reinterpret_cast<std::size_t>(records + last*record_size);
+		if (need)
+			begin -= begin % page;		// Include partial pages
+		else {
+			begin += (page - begin % page) % page;	// Exclude partial pages
+			end -= end % page;
+		}
+		if (begin < end)
+			madvise (reinterpret_cast<void*>(begin), end - begin, need ? MADV_WILLNEED : MADV_DONTNEED);
+#else
+		(void)first; (void)last; (void)need;
+#endif
+	}
+	Float* const records;
+	const std::size_t record_size, s_size, chunk_size;
+	std::size_t boundary;		// First record of the next chunk
+};
+
+}//namespace
+
+
+Mapped_SIR_scheme::Mapped_SIR_scheme (const std::string& directory, std::size_t x_size, std::size_t s_size, std::size_t chunk_size, SIR_random& random_helper) :
+		x_size(x_size), s_size(s_size), chunk_size(chunk_size), random(random_helper),
+		record_size(x_size+1),
+		xi(x_size)
+/* Create and map two files each with s_size records
+ *  The files are unlinked immediately so only the mappings refer to them
+ */
+{
+	if (s_size == 0 || chunk_size == 0)
+		error (Logic_exception("Mapped_SIR_scheme zero samples or chunk"));
+	file[0] = file[1] = -1;
+	records[0] = records[1] = 0;
+	bytes = s_size * record_size * sizeof(Float);
+#ifdef BAYES_FILTER_MMAP
+	for (int f = 0; f != 2; ++f) {
+		std::string path = directory + "/bayes_samples.XXXXXX";
+		std::vector<char> name (path.begin(), path.end());
+		name.push_back (0);
+		file[f] = mkstemp (&name[0]);
+		if (file[f] == -1)
+			break;
+		unlink (&name[0]);
+		if (ftruncate (file[f], off_t(bytes)) != 0)
+			break;
+		void* m = mmap (0, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, file[f], 0);
+		if (m == MAP_FAILED)
+			break;
+		records[f] = static_cast<Float*>(m);
+	}
+	if (records[1] == 0) {
+		unmap ();
+		error (Logic_exception("Mapped_SIR_scheme cannot create and map sample files"));
+	}
+#else
+	(void)directory;
+	error (Logic_exception("Mapped_SIR_scheme requires memory mapped files"));
+#endif
+	rougheningK = 1;
+	init_S ();
+}
+
+Mapped_SIR_scheme::~Mapped_SIR_scheme ()
+{
+	unmap ();
+}
+
+void Mapped_SIR_scheme::unmap ()
+{
+#ifdef BAYES_FILTER_MMAP
+	for (int f = 0; f != 2; ++f) {
+		if (records[f] != 0)
+			munmap (records[f], bytes);
+		if (file[f] != -1)
+			close (file[f]);
+		records[f] = 0;
+		file[f] = -1;
+	}
+#endif
+}
+
+
+void Mapped_SIR_scheme::get (std::size_t i, FM::Vec& x) const
+{
+	const Float* r = records[0] + i*record_size;
+	std::copy (r, r + x_size, x.begin());
+}
+
+void Mapped_SIR_scheme::set (std::size_t i, const FM::Vec& x)
+{
+	std::copy (x.begin(), x.end(), records[0] + i*record_size);
+}
+
+void Mapped_SIR_scheme::init_S ()
+/* Initialise sampling
+ *  Post: stochastic_samples := s_size, uniform weights
+ */
+{
+	Chunk_stream cs(records[0], record_size, s_size, chunk_size);
+	for (std::size_t i = 0; i != s_size; ++i) {
+		cs.at (i);
+		records[0][i*record_size + x_size] = 1;
+	}
+	weight_sum = Float(s_size);
+	stochastic_samples = s_size;
+	wir_update = false;
+}
+
+
+void Mapped_SIR_scheme::predict (Functional_predict_model& f)
+/* Predict samples without noise
+ */
+{
+	BAYES_FILTER_TRACE_SPAN("Mapped_SIR_scheme::predict");
+	Chunk_stream cs(records[0], record_size, s_size, chunk_size);
+	for (std::size_t i = 0; i != s_size; ++i) {
+		cs.at (i);
+		Float* r = records[0] + i*record_size;
+		std::copy (r, r + x_size, xi.begin());
+		const FM::Vec& fx = f.fx(xi);
+		std::copy (fx.begin(), fx.end(), r);
+	}
+}
+
+void Mapped_SIR_scheme::predict (Sampled_predict_model& f)
+/* Predict samples with sampled noise model
+ *  Post: stochastic_samples := s_size
+ */
+{
+	BAYES_FILTER_TRACE_SPAN("Mapped_SIR_scheme::predict");
+	Chunk_stream cs(records[0], record_size, s_size, chunk_size);
+	for (std::size_t i = 0; i != s_size; ++i) {
+		cs.at (i);
+		Float* r = records[0] + i*record_size;
+		std::copy (r, r + x_size, xi.begin());
+		const FM::Vec& fw = f.fw(xi);
+		std::copy (fw.begin(), fw.end(), r);
+	}
+	stochastic_samples = s_size;
+}
+
+
+void Mapped_SIR_scheme::observe (Likelihood_observe_model& h, const FM::Vec& z)
+/* Observation fusion using Likelihood at z
+ *  Post: weights fused (multiplicative) with likelihood, weight_sum their sum
+ */
+{
+	BAYES_FILTER_TRACE_SPAN("Mapped_SIR_scheme::observe");
+	{	BAYES_FILTER_TRACE_SPAN("Likelihood_observe_model::Lz");
+		h.Lz (z);
+	}
+	Float sum = 0;
+	Chunk_stream cs(records[0], record_size, s_size, chunk_size);
+	for (std::size_t i = 0; i != s_size; ++i) {
+		cs.at (i);
+		Float* r = records[0] + i*record_size;
+		std::copy (r, r + x_size, xi.begin());
+		r[x_size] *= h.L(xi);
+		sum += r[x_size];
+	}
+	weight_sum = sum;
+	wir_update = true;
+}
+
+
+Mapped_SIR_scheme::Float
+ Mapped_SIR_scheme::update_resample ()
+/* Systematic resampling gathered into the second file, and roughening
+ * Algorithm:
+ *  As Systematic_resampler. The cumulative weights are summed in the same order as weight_sum
+ *  so the grid spans exactly the total weight
+ * Exceptions:
+ *  Numeric_exception for negative, zero or non finite weights
+ *    unchanged: samples, stochastic_samples
+ * Return
+ *  lcond, smallest normalised weight, 1 if no resampling was required
+ */
+{
+	BAYES_FILTER_TRACE_SPAN("Mapped_SIR_scheme::update_resample");
+	if (!wir_update)
+		return 1;
+	if (weight_sum != weight_sum || weight_sum > std::numeric_limits<Float>::max())
+		error (Numeric_exception("total likelihood numerical error"));
+	if (weight_sum <= 0)
+		error (Numeric_exception("total likelihood zero"));
+
+	const Float wstep = weight_sum / Float(s_size);
+	DenseVec ur(1);
+	random.uniform_01 (ur);
+	Float s = ur[0] * wstep;
+
+	Vec xmin(x_size), xmax(x_size);
+	std::fill (xmin.begin(), xmin.end(), std::numeric_limits<Float>::max());
+	std::fill (xmax.begin(), xmax.end(), -std::numeric_limits<Float>::max());
+	Float wmin = std::numeric_limits<Float>::max();
+	Float wcum = 0;
+	std::size_t out = 0, unique = 0;
+	const Float* last = 0;
+	{
+		Chunk_stream in(records[0], record_size, s_size, chunk_size);
+		Chunk_stream to(records[1], record_size, s_size, chunk_size);
+		for (std::size_t i = 0; i != s_size; ++i) {
+			in.at (i);
+			const Float* r = records[0] + i*record_size;
+			const Float w = r[x_size];
+			if (w < 0)
+				error (Numeric_exception("negative weight"));
+			wmin = std::min (wmin, w);
+			wcum += w;
+			if (s < wcum && out != s_size) {
+				++unique;
+				for (std::size_t j = 0; j != x_size; ++j) {
+					xmin[j] = std::min (xmin[j], r[j]);
+					xmax[j] = std::max (xmax[j], r[j]);
+				}
+				do {		// Gather copies of ancestor i
+					to.at (out);
+					Float* t = records[1] + out*record_size;
+					std::copy (r, r + x_size, t);
+					t[x_size] = 1;
+					++out;
+					s += wstep;
+				} while (s < wcum && out != s_size);
+				last = r;
+			}
+		}
+							// Rounding may leave the final grid points beyond wcum
+		assert (last != 0);
+		for (; out != s_size; ++out) {
+			to.at (out);
+			Float* t = records[1] + out*record_size;
+			std::copy (last, last + x_size, t);
+			t[x_size] = 1;
+		}
+	}
+
+	std::swap (records[0], records[1]);
+	std::swap (file[0], file[1]);
+	stochastic_samples = unique;
+	weight_sum = Float(s_size);
+	wir_update = false;
+
+	if (rougheningK != 0)
+		roughen (xmin, xmax);
+	return wmin / wcum;
+}
+
+void Mapped_SIR_scheme::roughen (const FM::Vec& xmin, const FM::Vec& xmax)
+/* Roughening as SIR_scheme::roughen_minmax with the min and max of the samples
+ */
+{
+	const Float SigmaScale = rougheningK * std::pow (Float(s_size), -1/Float(x_size));
+	Vec rootq(x_size);
+	noalias(rootq) = xmax - xmin;
+	rootq *= SigmaScale;
+	DenseVec n(x_size);
+	Chunk_stream cs(records[0], record_size, s_size, chunk_size);
+	for (std::size_t i = 0; i != s_size; ++i) {
+		cs.at (i);
+		random.normal (n);
+		Float* r = records[0] + i*record_size;
+		for (std::size_t j = 0; j != x_size; ++j)
+			r[j] += n[j] * rootq[j];
+	}
+}
+
+
+void Mapped_SIR_scheme::mean (FM::Vec& x) const
+/* Weighted mean of the samples
+ */
+{
+	Float wsum = 0;
+	x.clear();
+	Chunk_stream cs(records[0], record_size, s_size, chunk_size);
+	for (std::size_t i = 0; i != s_size; ++i) {
+		cs.at (i);
+		const Float* r = records[0] + i*record_size;
+		for (std::size_t j = 0; j != x_size; ++j)
+			x[j] += r[x_size] * r[j];
+		wsum += r[x_size];
+	}
+	x /= wsum;
+}
+
+
+}//namespace
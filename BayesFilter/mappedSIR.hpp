@@ -0,0 +1,94 @@
+#ifndef _BAYES_FILTER_MAPPED_SIR
+#define _BAYES_FILTER_MAPPED_SIR
+
+/*
+ * Bayes++ the Bayesian Filtering Library
+ * Copyright (c) 2002 Michael Stevens
+ * See accompanying Bayes++.htm for terms and conditions of use.
+ *
+ * $Id$
+ */
+
+/*
+ * Out-of-core Sampling Importance Resampling Filter Scheme
+ *
+ * For very large numbers of samples the samples are stored in memory mapped files rather then in S.
+ * Each sample is a record of its state followed by its likelihood weight. The number of samples is
+ * then bounded by disk rather then RAM, the operating system pages records in and out as required.
+ * All operations stream sequentially through the records a chunk at a time: the next chunk is
+ * prefetched and the resident pages of the previous chunk are released.
+ *
+ * Resampling is that of Systematic_resampler in a single sequential pass. The ancestors of systematic
+ * resampling are in order, so resampling gathers the records of the ancestors from one file and writes
+ * them sequentially into a second file which then becomes the samples. No per sample vector is kept in RAM.
+ * Roughening is as SIR_scheme::roughen_minmax, the min and max are found during resampling.
+ *
+ * The files are created in a directory and unlinked as soon as they are mapped, so the storage is
+ * released when the scheme is destroyed, or the process terminates.
+ * Memory mapping is only available on POSIX systems, elsewhere construction throws Logic_exception.
+ */
+#include "SIRFlt.hpp"
+#include <string>
+
+/* Filter namespace */
+namespace Bayesian_filter
+{
+
+class Mapped_SIR_scheme : public Bayes_base
+{
+public:
+	Mapped_SIR_scheme (const std::string& directory, std::size_t x_size, std::size_t s_size, std::size_t chunk_size, SIR_random& random_helper);
+	/* Create files for s_size samples in directory
+	 *  chunk_size is the number of samples in each chunk of the streaming operations
+	 *  Throws Logic_exception if the files cannot be created and mapped
+	 */
+	~Mapped_SIR_scheme ();
+
+	void get (std::size_t i, FM::Vec& x) const;
+	void set (std::size_t i, const FM::Vec& x);
+	// Random access to the state of sample i, for initialisation and inspection
+	void init_S ();
+	// Initialise sampling, Pre: states of all samples set
+
+	void predict (Functional_predict_model& f);
+	// Predict samples without noise
+	void predict (Sampled_predict_model& f);
+	// Predict samples with noise model
+
+	void observe (Likelihood_observe_model& h, const FM::Vec& z);
+	// Weight samples using likelihood model h and z
+
+	Float update_resample ();
+	/* Update: systematic resampling using weights and then roughen
+	 *  Return: lcond, smallest normalised weight, 1 if no resampling was required
+	 */
+
+	void mean (FM::Vec& x) const;
+	// Weighted mean of the samples
+
+	std::size_t stochastic_samples;	// Number of unique samples after resampling
+	Float rougheningK;				// Current roughening value (0 implies no roughening)
+
+	const std::size_t x_size, s_size;
+	const std::size_t chunk_size;
+	SIR_random& random;			// Reference random number generator helper
+
+private:
+	Mapped_SIR_scheme (const Mapped_SIR_scheme&);
+	Mapped_SIR_scheme& operator= (const Mapped_SIR_scheme&);
+
+	void unmap ();
+	void roughen (const FM::Vec& xmin, const FM::Vec& xmax);
+
+	const std::size_t record_size;	// Values in each sample record, state then weight
+	std::size_t bytes;				// Size of each file
+	int file[2];
+	Float* records[2];				// Current samples are records[0]
+	Float weight_sum;				// Sum of weights of the current samples
+	bool wir_update;				// Weights have been updated requiring a resampling on update
+	mutable FM::Vec xi;
+};
+
+
+}//namespace
+#endif
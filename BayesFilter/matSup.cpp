@@ -17,6 +17,19 @@
 #ifndef NDEBUG
 #include <boost/numeric/ublas/io.hpp>
 #endif
+#ifdef BAYES_FILTER_LAPACK
+#include "uLAPACK.hpp"
+#endif
+#ifdef BAYES_FILTER_ALIGNED
+#include "uEigen.hpp"
+#endif
+
+#ifndef BAYES_FILTER_LAPACK_DISPATCH_SIZE
+#define BAYES_FILTER_LAPACK_DISPATCH_SIZE 64
+#endif
+#ifndef BAYES_FILTER_ALIGNED_DISPATCH_SIZE
+#define BAYES_FILTER_ALIGNED_DISPATCH_SIZE 16
+#endif
 
 namespace {
 
@@ -97,6 +110,33 @@ bool isSymmetric (const Matrix &M)
 }
 
 
+bool isSelection (const Matrix& H, std::vector<std::size_t>& index)
+/* Check if H is a selection matrix
+ * Return:
+ *  true iff each row of H has a single non zero element which is 1
+ *  index[i] is then the column of the unit element in row i
+ */
+{
+	const std::size_t size1 = H.size1(), size2 = H.size2();
+	index.resize (size1);
+	for (std::size_t r = 0; r < size1; ++r) {
+		bool unit = false;
+		for (std::size_t c = 0; c < size2; ++c) {
+			const Matrix::value_type e = H(r,c);
+			if (e == 0)
+				continue;
+			if (e != 1 || unit)
+				return false;
+			unit = true;
+			index[r] = c;
+		}
+		if (!unit)
+			return false;
+	}
+	return true;
+}
+
+
 void forceSymmetric (Matrix &M, bool bUpperToLower)
 /* Force Matrix Symmetry
  *	Normally Copies lower triangle to upper or
@@ -133,4 +173,154 @@ void forceSymmetric (Matrix &M, bool bUpperToLower)
 
 
 
+/*
+ * Dense BLAS/LAPACK dispatch
+ */
+
+std::size_t lapack_dispatch_size = BAYES_FILTER_LAPACK_DISPATCH_SIZE;
+
+/*
+ * Vectorised dispatch
+ */
+
+std::size_t aligned_dispatch_size = BAYES_FILTER_ALIGNED_DISPATCH_SIZE;
+
+
+namespace {
+
+void prod_SPD_update (SymMatrix& P, const RowMatrix& X, const SymMatrix& S, RowMatrix& XStemp, bool minus)
+/* P = X*S*X' or P -= X*S*X', XStemp = X*S
+ *  BLAS: Row major matrices are seen as their transpose and upper triangles as lower triangles
+ *  XStemp by symm, then the symmetric 0.5*(X*XStemp' + XStemp*X') by syr2k which only assigns
+ *  the upper triangle of P
+ *  Eigen: XStemp by a symmetric product, then only the upper triangle of X*XStemp'
+ */
+{
+#if defined(BAYES_FILTER_LAPACK) || defined(BAYES_FILTER_ALIGNED)
+	const std::size_t m = X.size1(), k = X.size2();
+#endif
+#ifdef BAYES_FILTER_LAPACK
+	if (std::max(m,k) >= lapack_dispatch_size && m > 0 && k > 0)
+	{
+		using LAPACK::rawLAPACK::symm;
+		using LAPACK::rawLAPACK::syr2k;
+		const int im = int(m), ik = int(k);
+		symm ('L', 'L', ik, im, 1, S.asRowMatrix().data().begin(), ik, X.data().begin(), ik, 0, XStemp.data().begin(), ik);
+		syr2k ('L', 'T', im, ik, Float(minus ? -0.5 : 0.5), X.data().begin(), ik, XStemp.data().begin(), ik, Float(minus ? 1 : 0), P.asRowMatrix().data().begin(), im);
+		return;
+	}
+#endif
+#ifdef BAYES_FILTER_ALIGNED
+	if (std::max(m,k) >= aligned_dispatch_size && m > 0 && k > 0)
+	{
+		EIGEN::map_t XS = EIGEN::view(XStemp), PP = EIGEN::view(P.asRowMatrix());
+		EIGEN::const_map_t XX = EIGEN::view(X);
+		XS.noalias() = XX * EIGEN::view(S.asRowMatrix()).selfadjointView<Eigen::Upper>();
+		if (minus)
+			PP.triangularView<Eigen::Upper>() -= XS * XX.transpose();
+		else
+			PP.triangularView<Eigen::Upper>() = XS * XX.transpose();
+		return;
+	}
+#endif
+	if (minus)
+		noalias(P) -= prod_SPD(X, S, XStemp);
+	else
+		noalias(P) = prod_SPD(X, S, XStemp);
+}
+
+}//namespace
+
+
+void assign_prod_SPD (SymMatrix& P, const RowMatrix& X, const SymMatrix& S, RowMatrix& XStemp)
+/* Symmetric Positive (Semi) Definite product: P = X*S*X', XStemp = X*S
+ *  P may be the same matrix as S
+ */
+{
+	prod_SPD_update (P, X, S, XStemp, false);
+}
+
+void minus_assign_prod_SPD (SymMatrix& P, const RowMatrix& X, const SymMatrix& S, RowMatrix& XStemp)
+/* Symmetric Positive (Semi) Definite product: P -= X*S*X', XStemp = X*S
+ */
+{
+	prod_SPD_update (P, X, S, XStemp, true);
+}
+
+void assign_sample_covariance (SymMatrix& P, const ColMatrix& S, const Vec& mean)
+/* Sample covariance of the columns of S about mean
+ *  P = Sum_i [(S[i]-mean)*(S[i]-mean)'] / S.size2()
+ *  BLAS: Column major deviations from the mean are used directly by syrk
+ */
+{
+	const std::size_t nSamples = S.size2();
+#ifdef BAYES_FILTER_LAPACK
+	const std::size_t n = S.size1();
+	if (std::max(n,nSamples) >= lapack_dispatch_size && n > 0 && nSamples > 0)
+	{
+		ColMatrix D(n,nSamples);
+		for (std::size_t i = 0; i != nSamples; ++i) {
+			ColMatrix::Column Di(D,i);
+			noalias(Di) = ColMatrix::const_Column(S,i) - mean;
+		}
+		LAPACK::rawLAPACK::syrk ('L', 'N', int(n), int(nSamples), Float(1)/Float(nSamples), D.data().begin(), int(n), 0, P.asRowMatrix().data().begin(), int(n));
+		return;
+	}
+#endif
+	P.clear();
+	for (std::size_t i = 0; i != nSamples; ++i) {
+		ColMatrix::const_Column Si(S,i);
+		P.plus_assign (outer_prod(Si-mean, Si-mean));
+	}
+	P /= Float(nSamples);
+}
+
+void assign_prod (SymMatrix& P, const RowMatrix& A, const RowMatrix& B)
+/* Product known to be symmetric: P = A*B
+ *  Such as H*X*H' from H and X*H'
+ */
+{
+#ifdef BAYES_FILTER_ALIGNED
+	const std::size_t m = A.size1(), k = A.size2();
+	if (std::max(m,k) >= aligned_dispatch_size && m > 0 && k > 0)
+	{
+		EIGEN::view(P.asRowMatrix()).triangularView<Eigen::Upper>() = EIGEN::view(A) * EIGEN::view(B);
+		return;
+	}
+#endif
+	noalias(P) = prod(A, B);
+}
+
+void assign_prod (RowMatrix& P, const RowMatrix& A, const RowMatrix& B)
+/* Dense product: P = A*B
+ */
+{
+#ifdef BAYES_FILTER_ALIGNED
+	const std::size_t m = A.size1(), k = A.size2(), n = B.size2();
+	if (std::max(std::max(m,k),n) >= aligned_dispatch_size && m > 0 && k > 0 && n > 0)
+	{
+		EIGEN::view(P).noalias() = EIGEN::view(A) * EIGEN::view(B);
+		return;
+	}
+#endif
+	noalias(P) = prod(A, B);
+}
+
+void assign_prod_trans (RowMatrix& P, const SymMatrix& S, const RowMatrix& B)
+/* Dense product with a symmetric matrix: P = S*B'
+ *  Such as X*H', only the upper triangle of S is referenced
+ */
+{
+#ifdef BAYES_FILTER_ALIGNED
+	const std::size_t m = S.size1(), n = B.size1();
+	if (std::max(m,n) >= aligned_dispatch_size && m > 0 && n > 0)
+	{
+		EIGEN::view(P).noalias() = EIGEN::view(S.asRowMatrix()).selfadjointView<Eigen::Upper>() * EIGEN::view(B).transpose();
+		return;
+	}
+#endif
+	noalias(P) = prod(S, trans(B));
+}
+
+
 }//namespace
@@ -38,6 +38,13 @@ bool isPSD (const SymMatrix &M);
 bool isSymmetric (const Matrix &M);
 void forceSymmetric (Matrix &M, bool bUpperToLower = false);
 
+/*
+ * Selection matrices
+ *  A selection H has a single unit element in each row so H*x selects elements of x
+ *  Products with a selection can be computed by gathering elements rather then by multiplication
+ */
+bool isSelection (const Matrix& H, std::vector<std::size_t>& index);
+
 /*
  * UdU' and LdL' and UU' Cholesky Factorisation and function
  * Very important to manipulate PD and PSD matrices
@@ -56,9 +63,13 @@ SymMatrix::value_type UdUdet (const SymMatrix& UD);
 // In-place factorisations
 RowMatrix::value_type UdUfactor_variant1 (RowMatrix& M, std::size_t n);
 RowMatrix::value_type UdUfactor_variant2 (RowMatrix& M, std::size_t n);
+#ifdef BAYES_FILTER_LAPACK
+RowMatrix::value_type UdUfactor (RowMatrix& M, std::size_t n);
+#else
 inline RowMatrix::value_type UdUfactor (RowMatrix& M, std::size_t n)
 {	return UdUfactor_variant2(M,n);
 }
+#endif
 LTriMatrix::value_type LdLfactor (LTriMatrix& M, std::size_t n);
 UTriMatrix::value_type UCfactor (UTriMatrix& M, std::size_t n);
 
@@ -66,6 +77,7 @@ UTriMatrix::value_type UCfactor (UTriMatrix& M, std::size_t n);
 RowMatrix::value_type UdUfactor (RowMatrix& UD, const SymMatrix& M);
 LTriMatrix::value_type LdLfactor (LTriMatrix& LD, const SymMatrix& M);
 UTriMatrix::value_type UCfactor (UTriMatrix& UC, const SymMatrix& M);
+UTriMatrix::value_type UCtriangularise (UTriMatrix& UC, RowMatrix& A);
 
 // Factor manipulations
 bool UdUinverse (RowMatrix& UD);
@@ -88,6 +100,58 @@ SymMatrix::value_type UdUinversePD (SymMatrix& M, SymMatrix::value_type& detM);
 SymMatrix::value_type UdUinversePD (SymMatrix& MI, const SymMatrix& M);
 SymMatrix::value_type UdUinversePD (SymMatrix& MI, SymMatrix::value_type& detM, const SymMatrix& M);
 
+/*
+ * Functions using an existing UdU' factor (UD format) of a Positive Definite matrix M
+ *  Factor-and-solve is preferable to forming inv(M) explicitly.
+ *  Precond: UD is the factor of a PD M, that is UdUfactor returned rcond > 0
+ */
+void UdUsolve (const RowMatrix& UD, Vec& x);
+void UdUsolve_right (const RowMatrix& UD, RowMatrix& B);
+RowMatrix::value_type UdUmahalanobis (const RowMatrix& UD, Vec& v);
+RowMatrix::value_type UdUlogdet (const RowMatrix& UD);
+void UdUrecompose_inverse (SymMatrix& MI, const RowMatrix& UD);
+
+/*
+ * Innovations of an observation with additive noise, Z or diag(Zv) when uncorrelated
+ *  UdUinnovation: S = Hx*X*Hx' + Z and its UdU' factor SUD, returning the rcond of S
+ *  UdUloglikelihood: -0.5*(d2 + log(det(S))) of an innovation s with d2 = UdUmahalanobis(SUD,s)
+ */
+RowMatrix::value_type UdUinnovation (RowMatrix& SUD, SymMatrix& S, const RowMatrix& Hx, const SymMatrix& X, const Vec& Zv);
+RowMatrix::value_type UdUinnovation (RowMatrix& SUD, SymMatrix& S, const RowMatrix& Hx, const SymMatrix& X, const SymMatrix& Z);
+RowMatrix::value_type UdUloglikelihood (const RowMatrix& SUD, RowMatrix::value_type d2);
+
+/*
+ * Dense BLAS/LAPACK dispatch
+ *  When the library is built with BAYES_FILTER_LAPACK; UdUfactor, UdUinversePD, UdUsolve_right
+ *  and the products below use LAPACK and BLAS for operations with a dimension of at least
+ *  lapack_dispatch_size. Otherwise the uBLAS algorithms are used.
+ *  The LAPACK Cholesky factor is converted to the unique UdU' factor, so the factor, rcond and
+ *  its semantics are consistent with the uBLAS algorithms.
+ */
+#if defined(BAYES_FILTER_LAPACK) && defined(BAYES_FILTER_GAPPY)
+#error BAYES_FILTER_LAPACK requires dense matrix storage
+#endif
+extern std::size_t lapack_dispatch_size;
+
+/*
+ * Vectorised dispatch
+ *  When the library is built with BAYES_FILTER_ALIGNED; UdUfactor_variant2, UdUinverse, UdUrecompose_transpose,
+ *  UdUsolve_right and the products below use vectorising Eigen kernels on the aligned storage for
+ *  operations with a dimension of at least aligned_dispatch_size. The kernels compute the same
+ *  algorithms as uBLAS, results differ only by rounding. BLAS/LAPACK dispatch takes precedence.
+ */
+extern std::size_t aligned_dispatch_size;
+
+// Symmetric products, only the upper triangle of P is assigned
+void assign_prod_SPD (SymMatrix& P, const RowMatrix& X, const SymMatrix& S, RowMatrix& XStemp);
+void minus_assign_prod_SPD (SymMatrix& P, const RowMatrix& X, const SymMatrix& S, RowMatrix& XStemp);
+void assign_sample_covariance (SymMatrix& P, const ColMatrix& S, const Vec& mean);
+void assign_prod (SymMatrix& P, const RowMatrix& A, const RowMatrix& B);
+
+// Dense products, P must not be an operand
+void assign_prod (RowMatrix& P, const RowMatrix& A, const RowMatrix& B);
+void assign_prod_trans (RowMatrix& P, const SymMatrix& S, const RowMatrix& B);
+
 
 }//namespace
 
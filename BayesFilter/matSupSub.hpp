@@ -23,6 +23,15 @@
  *
  * Gappy matrix support: The macros BAYES_FILTER_(SPARSE/COMPRESSED/COORDINATE) control experimental gappy matrix support
  * When enabled the default storage types are replaced with their sparse equivalents
+ *
+ * Aligned storage: The macro BAYES_FILTER_ALIGNED replaces the dense storage with storage aligned
+ * to BAYES_FILTER_ALIGNMENT bytes (default 64), the CMake option of the same name defines it
+ * The library then computes the hot kernels of matSup, the UdU' factorisation, inversion and solution,
+ * and the symmetric and dense products, with vectorising Eigen kernels which view the aligned storage
+ * without copying (see uEigen.hpp and aligned_dispatch_size). Other expressions remain uBLAS.
+ * Rows and columns within a matrix are not padded and so are not aligned.
+ * The types and their interface are unchanged, but the storage type is part of the ABI so the library
+ * and its users must be compiled with the same setting
  */
 
 #include <boost/version.hpp>
@@ -37,12 +46,23 @@
 #include <boost/numeric/ublas/symmetric.hpp>
 #include <boost/numeric/ublas/triangular.hpp>
 #include <boost/numeric/ublas/banded.hpp>
+#include <vector>
 #if defined(BAYES_FILTER_MAPPED) || defined(BAYES_FILTER_COMPRESSED) || defined(BAYES_FILTER_COORDINATE)
 #include <map>
 #include <boost/numeric/ublas/vector_sparse.hpp>
 #include <boost/numeric/ublas/matrix_sparse.hpp>
 #define BAYES_FILTER_GAPPY
 #endif
+#if defined(BAYES_FILTER_ALIGNED)
+#if defined(BAYES_FILTER_GAPPY)
+#error BAYES_FILTER_ALIGNED requires dense matrix storage
+#endif
+#include <cstddef>
+#include <new>
+#ifndef BAYES_FILTER_ALIGNMENT
+#define BAYES_FILTER_ALIGNMENT 64
+#endif
+#endif
 
 
 
@@ -64,12 +84,67 @@ typedef double Float;
  */
 namespace detail {
 							// Dense types
+#ifndef BAYES_FILTER_ALIGNED
 typedef ublas::vector<Float> BaseDenseVector;
 typedef ublas::matrix<Float, ublas::row_major> BaseDenseRowMatrix;
 typedef ublas::matrix<Float, ublas::column_major> BaseDenseColMatrix;
 typedef ublas::triangular_matrix<Float, ublas::upper, ublas::row_major> BaseDenseUpperTriMatrix;
 typedef ublas::triangular_matrix<Float, ublas::lower, ublas::row_major> BaseDenseLowerTriMatrix;
 typedef ublas::banded_matrix<Float> BaseDenseDiagMatrix;
+#else
+							// OR Aligned dense types
+template <class T, std::size_t Alignment>
+class Aligned_allocator
+/* Allocator of storage aligned to Alignment bytes
+ *  Allocates with the aligned operator new, so the allocations can be replaced and counted as any other
+ */
+{
+public:
+	typedef T value_type;
+	typedef T* pointer;
+	typedef const T* const_pointer;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef std::size_t size_type;
+	typedef std::ptrdiff_t difference_type;
+	template <class U> struct rebind
+	{	typedef Aligned_allocator<U, Alignment> other;
+	};
+
+	Aligned_allocator ()
+	{}
+	template <class U> Aligned_allocator (const Aligned_allocator<U, Alignment>&)
+	{}
+	pointer allocate (size_type n)
+	{	return static_cast<pointer>(::operator new (n * sizeof(T), std::align_val_t(Alignment)));
+	}
+	void deallocate (pointer p, size_type)
+	{	::operator delete (p, std::align_val_t(Alignment));
+	}
+	size_type max_size () const
+	{	return size_type(-1) / sizeof(T);
+	}
+	void construct (pointer p, const T& v)
+	{	new (p) T(v);
+	}
+	void destroy (pointer p)
+	{	p->~T();
+	}
+	bool operator== (const Aligned_allocator&) const
+	{	return true;
+	}
+	bool operator!= (const Aligned_allocator&) const
+	{	return false;
+	}
+};
+typedef ublas::unbounded_array<Float, Aligned_allocator<Float, BAYES_FILTER_ALIGNMENT> > AlignedArray;
+typedef ublas::vector<Float, AlignedArray> BaseDenseVector;
+typedef ublas::matrix<Float, ublas::row_major, AlignedArray> BaseDenseRowMatrix;
+typedef ublas::matrix<Float, ublas::column_major, AlignedArray> BaseDenseColMatrix;
+typedef ublas::triangular_matrix<Float, ublas::upper, ublas::row_major, AlignedArray> BaseDenseUpperTriMatrix;
+typedef ublas::triangular_matrix<Float, ublas::lower, ublas::row_major, AlignedArray> BaseDenseLowerTriMatrix;
+typedef ublas::banded_matrix<Float, ublas::row_major, AlignedArray> BaseDenseDiagMatrix;
+#endif
 							// Mapped types
 #if defined(BAYES_FILTER_MAPPED)
 typedef ublas::mapped_vector<Float, std::map<std::size_t,Float> > BaseSparseVector;
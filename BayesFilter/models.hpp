@@ -17,6 +17,12 @@
  *  Adapted: Adapt one model type into another
  */
 #include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+#include <iosfwd>
+#include <map>
+#include <mutex>
+#include <vector>
 
 /* Filter namespace */
 namespace Bayesian_filter
@@ -65,6 +71,47 @@ public:
 };
 
 
+class Multi_step_linear_predict_model : public Linear_predict_model
+/* k steps of a time invariant linear predict model composed into a single predict
+ *  Fx = F^k, G*q*G' = Sum_{i=0..k-1} F^i*Gs*qs*Gs'*F^i'
+ *  The step is composed by repeated doubling so k steps require O(log k) products.
+ *  Composed models are cached for each k. An idle filter can catch up k steps with one predict.
+ *  The cache holds at most max_cached models, it is emptied when full so an unbounded variety of k
+ *  does not grow storage. The doubled steps are kept, they number at most the bits of k.
+ *  G is the UdU' factor of the accumulated noise so q_size is x_size (UD_scheme requires q_maxsize >= x_size)
+ */
+{
+public:
+	Multi_step_linear_predict_model (const Linear_predict_model& step);
+	// Precondition: step is time invariant, it is copied
+
+	void steps (std::size_t k);
+	// Set Fx,G,q to compose k >= 1 steps
+
+	std::size_t max_cached;
+	// Maximum number of composed models cached, default 64. The model of the latest k is always cached
+	void clear_cache ();
+	// Empty the cache of composed models
+
+private:
+	struct Composed
+	{
+		Composed (std::size_t x_size);
+		FM::Matrix F;		// State transition of the composed steps
+		FM::SymMatrix Q;	// Noise accumulated over the composed steps
+	};
+	void compose (Composed& a, const Composed& b);
+	std::vector<Composed> doubled;	// doubled[i] composes 2^i steps
+	struct Factored
+	{
+		Factored (std::size_t x_size);
+		FM::Matrix Fx, G;
+		FM::Vec q;
+	};
+	std::map<std::size_t, Factored> cache;	// Composed models for each k
+};
+
+
 class Simple_linrz_correlated_observe_model : public Linrz_correlated_observe_model
 // Linrz observe model initialised from function and model matrices
 {
@@ -248,14 +295,14 @@ private:
 	struct Likelihood_correlated
 	{
 		Likelihood_correlated(std::size_t z_size) :
-			zInnov(z_size), Z_inv(z_size,z_size)
+			zInnov(z_size), ZUD(z_size,z_size)
 		{	zset = false;
 		}
 		mutable FM::Vec zInnov;	// Normalised innovation, temporary for L(x)
-		FM::SymMatrix Z_inv;	// Inverse Noise Covariance
+		FM::RowMatrix ZUD;		// UdU' factor of Noise Covariance
 		Float logdetZ;			// log(det(Z)
 		bool zset;	
-		static Float scaled_vector_square(const FM::Vec& v, const FM::SymMatrix& V);
+		static Float scaled_vector_square(FM::Vec& v, const FM::RowMatrix& VUD);
 		Float L(const Correlated_additive_observe_model& model, const FM::Vec& z, const FM::Vec& zp) const;
 		// Definition of likelihood for additive noise model given zz
 		void Lz(const Correlated_additive_observe_model& model);
@@ -288,6 +335,65 @@ private:
 };
 
 
+/*
+ * Precomputed Models: replace model evaluation with a table lookup
+ */
+
+class Likelihood_field_observe_model : public Likelihood_observe_model
+/* Range likelihood from a static anchor precomputed on a grid
+ *  L(x) = exp(-0.5*((z-r)^2/Zv + log(Zv))), r = |p-a|
+ *  p = (x[ix], x[iy]) is the position in the tracking plane, a the anchor which may lie a height above the plane
+ *  The likelihood is tabulated in single precision on a grid of positions and observed ranges.
+ *  Lz interpolates the table at the observed range into a position slab, so L is a bilinear lookup
+ *  in a table small enough to stay in cache. Positions or ranges outside the grid use the analytic form.
+ * Tables are shared in memory between models with identical anchor, noise and grid, and may be saved and loaded.
+ * Sharing is thread safe, tables no longer used by any model are released.
+ * The grid range cell size should be small compared to sqrt(Zv).
+ */
+{
+public:
+	struct Grid
+	{
+		Float x0, y0, r0;		// Origin of position and range axes
+		Float dxy, dr;			// Cell size of position and range axes
+		std::size_t nx, ny, nr;	// Number of grid points on each axis, all >= 2
+	};
+
+	Likelihood_field_observe_model (std::size_t ix, std::size_t iy, Float ax, Float ay, Float ah, Float Zv, const Grid& grid);
+	// Anchor at ax,ay and height ah above the plane, range noise variance Zv
+
+	virtual Float L(const FM::Vec& x) const;
+	virtual void Lz (const FM::Vec& zz);
+
+	void Ls (const FM::ColMatrix& S, FM::Vec& l) const;
+	// Likelihood of all the samples in S, l(i) = L(column(S,i)), for use with observe_likelihood
+	Float L_analytic (Float px, Float py) const;
+	// Likelihood without lookup
+
+	void save (std::ostream& os);
+	// Write table to os
+	bool load (std::istream& is);
+	// Read table from is. Return false, and leave the model unchanged, if it was not saved with identical parameters
+
+private:
+	struct Field;
+	void field_required ();
+	Float lookup (Float fx, Float fy) const;
+
+	const std::size_t ix, iy;
+	std::vector<Float> param;		// Anchor, noise and grid, identifies the Field
+	const Float ax, ay, ah2, Zv, logZv;
+	const Grid grid;
+	boost::shared_ptr<const Field> field;	// Table, empty until required
+
+	Float zz;					// Observed range set by Lz
+	bool zset, zgrid;			// zz is set and lies on the grid
+	std::vector<float> slab;	// Likelihood at each grid position for zz, y*nx + x
+	static std::map<std::vector<Float>, boost::weak_ptr<const Field> > fields;	// Tables in memory
+	static std::mutex fields_lock;	// Guards fields
+};
+
+
 }// namespace
 
 #endif
@@ -0,0 +1,183 @@
+/*
+ * Bayes++ the Bayesian Filtering Library
+ * Copyright (c) 2002 Michael Stevens
+ * See accompanying Bayes++.htm for terms and conditions of use.
+ *
+ * $Id$
+ */
+
+/*
+ * Monte Carlo simulation runner.
+ */
+#include "monteCarlo.hpp"
+#include "matSup.hpp"
+#include <boost/scoped_ptr.hpp>
+#include <atomic>
+#include <exception>
+#include <thread>
+
+
+/* Filter namespace */
+namespace Bayesian_filter
+{
+	using namespace Bayesian_filter_matrix;
+
+
+void Welford_accumulator::merge (const Welford_accumulator& a)
+{
+	if (a.n == 0)
+		return;
+	const std::size_t nn = n + a.n;
+	const Float d = a.mean - mean;
+	mean += d * Float(a.n) / Float(nn);
+	M2 += a.M2 + d * d * Float(n) * Float(a.n) / Float(nn);
+	n = nn;
+}
+
+
+Monte_carlo_random::Monte_carlo_random (unsigned seed, std::uint64_t stream)
+{
+	std::seed_seq seq {std::uint32_t(seed), std::uint32_t(stream), std::uint32_t(stream >> 32)};
+	rng.seed (seq);
+}
+
+void Monte_carlo_random::normal (FM::DenseVec& v)
+{
+	for (DenseVec::iterator vi = v.begin(); vi != v.end(); ++vi)
+		*vi = dist_normal(rng);
+}
+
+void Monte_carlo_random::uniform_01 (FM::DenseVec& v)
+{
+	for (DenseVec::iterator vi = v.begin(); vi != v.end(); ++vi)
+		*vi = dist_uniform(rng);
+}
+
+
+void Monte_carlo_runner::Step_statistics::merge (const Step_statistics& a)
+{
+	for (std::size_t i = 0; i != error.size(); ++i) {
+		error[i].merge (a.error[i]);
+		error_sq[i].merge (a.error_sq[i]);
+	}
+	nees.merge (a.nees);
+}
+
+
+Monte_carlo_runner::Monte_carlo_runner (std::size_t x_size, std::size_t steps, unsigned seed) :
+		statistics(steps, Step_statistics(x_size)),
+		x_size(x_size), steps(steps), seed(seed)
+{
+	trials = 0;
+	diverged = 0;
+}
+
+
+namespace {
+
+struct Worker
+/* Statistics of the trials run by one thread
+ */
+{
+	Worker (std::size_t x_size, std::size_t steps) :
+		statistics(steps, Monte_carlo_runner::Step_statistics(x_size)),
+		error(steps, Vec(x_size)), nees(steps)
+	{
+		trials = diverged = 0;
+	}
+	std::vector<Monte_carlo_runner::Step_statistics> statistics;
+	std::size_t trials, diverged;
+	std::vector<Vec> error;			// Error of each step of the current trial
+	std::vector<Float> nees;
+	std::exception_ptr failed;
+};
+
+}//namespace
+
+void Monte_carlo_runner::run (const Factory& factory, std::size_t trials, std::size_t threads)
+/* Each thread takes the next trial until all trials are taken
+ *  A trial is aggregated by its thread only once complete, so a diverged trial is discarded
+ */
+{
+	if (threads == 0)
+		threads = std::thread::hardware_concurrency();
+	if (threads == 0)
+		threads = 1;
+	const std::size_t first = Monte_carlo_runner::trials + diverged;
+	std::atomic<std::size_t> next(0);
+	std::atomic<bool> abort(false);
+	std::vector<Worker> workers(threads, Worker(x_size, steps));
+
+	const std::size_t n_steps = steps;
+	const unsigned run_seed = seed;
+	const auto work = [&factory, trials, first, n_steps, run_seed, &next, &abort] (Worker& w) {
+		RowMatrix UD(Empty);
+		Vec e(Empty);
+		for (std::size_t t = next++; t < trials && !abort; t = next++) {
+			try {
+				boost::scoped_ptr<Monte_carlo_trial> trial(factory());
+				Monte_carlo_random random(run_seed, first + t);
+				trial->init (random);
+				for (std::size_t k = 0; k != n_steps; ++k) {
+					trial->truth (random);
+					trial->sensor (random);
+					Kalman_state_filter& f = trial->scheme();
+					f.update ();
+					noalias(w.error[k]) = f.x - trial->x;
+					UD.resize (f.X.size1(), f.X.size2(), false);
+					Float rcond = UdUfactor (UD, f.X);
+					f.rclimit.check_PD(rcond, "X not PD in Monte_carlo_runner");
+					e.resize (f.x.size(), false);
+					noalias(e) = w.error[k];
+					w.nees[k] = UdUmahalanobis (UD, e);
+				}
+			}
+			catch (Numeric_exception&) {
+				++w.diverged;
+				continue;
+			}
+			catch (...) {
+				w.failed = std::current_exception();
+				abort = true;
+				return;
+			}
+							// Aggregate the complete trial
+			for (std::size_t k = 0; k != n_steps; ++k) {
+				Step_statistics& s = w.statistics[k];
+				for (std::size_t i = 0; i != w.error[k].size(); ++i) {
+					const Float e = w.error[k][i];
+					s.error[i].add (e);
+					s.error_sq[i].add (e*e);
+				}
+				s.nees.add (w.nees[k]);
+			}
+			++w.trials;
+		}
+	};
+
+	std::vector<std::thread> pool;
+	pool.reserve (threads - 1);
+	for (std::size_t p = 1; p != threads; ++p) {
+		Worker& w = workers[p];
+		pool.push_back (std::thread( [&work, &w] () {
+			work (w);
+		}));
+	}
+	work (workers[0]);
+	for (std::vector<std::thread>::iterator pi = pool.begin(); pi != pool.end(); ++pi)
+		pi->join();
+
+	for (std::vector<Worker>::iterator wi = workers.begin(); wi != workers.end(); ++wi) {
+		if (wi->failed)
+			std::rethrow_exception (wi->failed);
+	}
+	for (std::vector<Worker>::iterator wi = workers.begin(); wi != workers.end(); ++wi) {
+		for (std::size_t k = 0; k != steps; ++k)
+			statistics[k].merge (wi->statistics[k]);
+		Monte_carlo_runner::trials += wi->trials;
+		diverged += wi->diverged;
+	}
+}
+
+
+}//namespace
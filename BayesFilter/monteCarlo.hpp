@@ -0,0 +1,159 @@
+#ifndef _BAYES_FILTER_MONTE_CARLO
+#define _BAYES_FILTER_MONTE_CARLO
+
+/*
+ * Bayes++ the Bayesian Filtering Library
+ * Copyright (c) 2002 Michael Stevens
+ * See accompanying Bayes++.htm for terms and conditions of use.
+ *
+ * $Id$
+ */
+
+/*
+ * Monte Carlo simulation runner
+ *
+ * Runs independent trials of a simulation scenario concurrently on a pool of threads. Each trial is
+ * created by a factory and owns its truth model, sensor models and scheme, so trials share nothing.
+ * Each trial draws from its own random stream, seeded from the runner seed and the trial number, so
+ * a trial is reproducible irrespective of the thread it runs on.
+ *
+ * The estimation error and NEES (normalised estimation error squared) of each step are aggregated
+ * online with Welford accumulators, no trajectories are stored. Each thread aggregates its trials
+ * and the threads are merged when all trials are complete, so the threads only contend for the
+ * next trial number. Merging in a different order only changes the aggregates by rounding.
+ * A trial which throws Numeric_exception has diverged. Its steps are not aggregated and it is counted.
+ */
+#include "SIRFlt.hpp"
+#include <boost/function.hpp>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+/* Filter namespace */
+namespace Bayesian_filter
+{
+
+class Welford_accumulator
+/* Online mean and variance
+ *  Reference: "Note on a Method for Calculating Corrected Sums of Squares and Products"
+ *   BP Welford Technometrics Vol.4 No.3 1962
+ *  merge combines accumulators with the pairwise update of Chan, Golub and LeVeque
+ */
+{
+public:
+	typedef Bayes_base::Float Float;
+	Welford_accumulator () : n(0), mean(0), M2(0)
+	{}
+	void add (Float v)
+	{
+		++n;
+		const Float d = v - mean;
+		mean += d / Float(n);
+		M2 += d * (v - mean);
+	}
+	void merge (const Welford_accumulator& a);
+	Float variance () const
+	// Sample variance, 0 for less then 2 values
+	{
+		return n > 1 ? M2 / Float(n-1) : 0;
+	}
+
+	std::size_t n;
+	Float mean;
+	Float M2;		// Sum of squared differences from mean
+};
+
+
+class Monte_carlo_random : public SIR_random
+/* Random stream of a trial
+ *  A Mersenne twister seeded from a seed and a stream number
+ */
+{
+public:
+	typedef Bayes_base::Float Float;
+	Monte_carlo_random (unsigned seed, std::uint64_t stream);
+	void normal (FM::DenseVec& v);
+	void uniform_01 (FM::DenseVec& v);
+	Float normal ()
+	{	return dist_normal(rng);
+	}
+	Float uniform_01 ()
+	{	return dist_uniform(rng);
+	}
+private:
+	std::mt19937_64 rng;
+	std::normal_distribution<Float> dist_normal;
+	std::uniform_real_distribution<Float> dist_uniform;
+};
+
+
+class Monte_carlo_trial
+/* A trial of a scenario: truth and sensor models and a scheme
+ *  A trial is used by a single thread
+ */
+{
+public:
+	Monte_carlo_trial (std::size_t x_size) : x(x_size)
+	{}
+	virtual ~Monte_carlo_trial ()
+	{}
+	virtual void init (Monte_carlo_random& random) = 0;
+	// Initialise the truth x and the scheme
+	virtual void truth (Monte_carlo_random& random) = 0;
+	// Truth model: advance x one step
+	virtual void sensor (Monte_carlo_random& random) = 0;
+	// Sensor model: observe x and predict and observe with the scheme
+	virtual Kalman_state_filter& scheme () = 0;
+	// The scheme, it is updated after each sensor step
+
+	FM::Vec x;		// Truth
+};
+
+
+class Monte_carlo_runner : public Bayes_base
+{
+public:
+	typedef boost::function0<Monte_carlo_trial*> Factory;
+	// Trial factory, must be safe to call concurrently
+
+	Monte_carlo_runner (std::size_t x_size, std::size_t steps, unsigned seed = 0);
+
+	void run (const Factory& factory, std::size_t trials, std::size_t threads = 0);
+	/* Run trials and aggregate them with the statistics of previous runs
+	 *  Trials are numbered continuing from previous runs so each run draws new random streams
+	 *  threads: number of threads in the pool, 0 for the hardware concurrency
+	 * Exceptions:
+	 *  any exception other then Numeric_exception of a trial is rethrown once all threads are complete
+	 *    unchanged: statistics
+	 */
+
+	struct Step_statistics
+	{
+		Step_statistics (std::size_t x_size) : error(x_size), error_sq(x_size)
+		{}
+		void merge (const Step_statistics& a);
+		std::vector<Welford_accumulator> error;		// Estimate - truth of each state
+		std::vector<Welford_accumulator> error_sq;	// Squared error of each state
+		Welford_accumulator nees;
+	};
+	std::vector<Step_statistics> statistics;	// Statistics of each step
+
+	Float rmse (std::size_t step, std::size_t i) const
+	// Root mean square error of state i at step
+	{	return std::sqrt (statistics[step].error_sq[i].mean);
+	}
+	Float nees (std::size_t step) const
+	// Mean NEES at step, x_size for a consistent scheme
+	{	return statistics[step].nees.mean;
+	}
+
+	const std::size_t x_size, steps;
+	const unsigned seed;
+	std::size_t trials;		// Trials aggregated
+	std::size_t diverged;	// Trials which diverged
+};
+
+
+}//namespace
+#endif
@@ -0,0 +1,412 @@
+/*
+ * Bayes++ the Bayesian Filtering Library
+ * Copyright (c) 2002 Michael Stevens
+ * See accompanying Bayes++.htm for terms and conditions of use.
+ *
+ * $Id$
+ */
+
+/*
+ * Gaussian Mixture Probability Hypothesis Density Filter.
+ */
+#include "phdFlt.hpp"
+#include "matSup.hpp"
+#include "bayesTrace.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+
+/* Filter namespace */
+namespace Bayesian_filter
+{
+	using namespace Bayesian_filter_matrix;
+
+
+GM_PHD_scheme::GM_PHD_scheme (std::size_t x_size, std::size_t max_components) :
+		w(0), m(x_size,0), P(0,x_size),
+		max_components(max_components)
+/* Initialise filter and set the size of things we know about
+ */
+{
+	GM_PHD_scheme::x_size = x_size;
+	ps = Float(0.99);
+	pd = Float(0.9);
+	clutter_density = 0;
+	prune_threshold = Float(1e-5);
+	merge_threshold = 4;
+	for (std::size_t i = 0; i != x_size && i != 2; ++i)
+		index.push_back (i);
+}
+
+void GM_PHD_scheme::init ()
+{
+	resize (0);
+}
+
+void GM_PHD_scheme::resize (std::size_t n)
+{
+	w.resize (n, true);
+	m.resize (x_size, n, true);
+	P.resize (n*x_size, x_size, true);
+}
+
+SymMatrix GM_PHD_scheme::X (std::size_t j) const
+{
+	SymMatrix Xj(x_size,x_size);
+	Xj = P.sub_matrix(j*x_size,(j+1)*x_size, 0,x_size);
+	return Xj;
+}
+
+void GM_PHD_scheme::birth (Float weight, const FM::Vec& x, const FM::SymMatrix& X)
+{
+	const std::size_t j = size();
+	resize (j+1);
+	w[j] = weight;
+	column(m,j) = x;
+	P.sub_matrix(j*x_size,(j+1)*x_size, 0,x_size) = X;
+}
+
+
+void GM_PHD_scheme::predict (Linear_predict_model& f)
+/* Linear predict of all components
+ *  Means by one product, covariances by one product of the stacked covariances and one per component
+ *  Post: w,m,P
+ */
+{
+	BAYES_FILTER_TRACE_SPAN("GM_PHD_scheme::predict");
+	const std::size_t J = size();
+	const SymMatrix Q(prod_SPD(f.G, f.q));
+
+	ColMatrix mp(x_size, J);
+	noalias(mp) = prod(f.Fx, m);
+	m = mp;
+								// X*Fx' of all components
+	RowMatrix PFT(J*x_size, x_size);
+	noalias(PFT) = prod(P, trans(f.Fx));
+	for (std::size_t j = 0; j != J; ++j) {
+		P.sub_matrix(j*x_size,(j+1)*x_size, 0,x_size) = prod(f.Fx, PFT.sub_matrix(j*x_size,(j+1)*x_size, 0,x_size)) + Q;
+	}
+	w *= ps;
+}
+
+
+Bayes_base::Float GM_PHD_scheme::observe (Linear_uncorrelated_observe_model& h, const std::vector<FM::Vec>& zs)
+/* Update with the measurements zs of a scan
+ *  Each component forks into a missed detection and a detection of each z
+ *  Predicted observations and X*Hx' by one product over all components, innovations covariances are
+ *  factorised once for each component
+ *  Post: w,m,P with size()*(zs.size()+1) components
+ *  Return: minimum rcond of innovation covariances
+ */
+{
+	BAYES_FILTER_TRACE_SPAN("GM_PHD_scheme::observe");
+	const std::size_t J = size(), nz = zs.size(), z_size = h.Zv.size();
+	const std::size_t Jn = J * (nz + 1);
+	DenseVec wn(Jn);
+	ColMatrix mn(x_size, Jn);
+	RowMatrix Pn(Jn*x_size, x_size);
+
+	ColMatrix zp(z_size, J);
+	noalias(zp) = prod(h.Hx, m);
+	RowMatrix PHT(J*x_size, z_size);
+	noalias(PHT) = prod(P, trans(h.Hx));
+
+	const Float log_2pi = std::log(Float(2) * std::acos(Float(-1)));
+	RowMatrix SUD(z_size,z_size);
+	SymMatrix SS(z_size,z_size);
+	RowMatrix W(x_size, z_size), PHTj(x_size, z_size), Pj(x_size,x_size);
+	Vec zpj(z_size), s(z_size), sv(z_size);
+	Float rcond_min = 1;
+	std::vector<Float> sum_q(nz, Float(0));
+
+	for (std::size_t j = 0; j != J; ++j) {
+		noalias(PHTj) = PHT.sub_matrix(j*x_size,(j+1)*x_size, 0,z_size);
+		noalias(Pj) = P.sub_matrix(j*x_size,(j+1)*x_size, 0,x_size);
+								// Missed detection
+		wn[j] = (1 - pd) * w[j];
+		column(mn,j) = column(m,j);
+		Pn.sub_matrix(j*x_size,(j+1)*x_size, 0,x_size) = Pj;
+
+								// Innovation covariance and gain
+		noalias(SS) = prod(h.Hx, PHTj);
+		for (std::size_t i = 0; i != z_size; ++i)
+			SS(i,i) += h.Zv[i];
+		Float rcond = UdUfactor (SUD, SS);
+		h.rclimit.check_PD(rcond, "S not PD in observe");
+		rcond_min = std::min(rcond_min, rcond);
+		noalias(W) = PHTj;
+		UdUsolve_right (SUD, W);
+		const Float logdet = UdUlogdet(SUD) + Float(z_size) * log_2pi;
+
+		const std::size_t jz = J + j*nz;	// Detections of component j
+		if (nz != 0) {
+			Pn.sub_matrix(jz*x_size,(jz+1)*x_size, 0,x_size) = Pj - prod(W, trans(PHTj));
+			for (std::size_t k = 1; k < nz; ++k)
+				Pn.sub_matrix((jz+k)*x_size,(jz+k+1)*x_size, 0,x_size) = Pn.sub_matrix(jz*x_size,(jz+1)*x_size, 0,x_size);
+		}
+
+		zpj = column(zp,j);
+		for (std::size_t k = 0; k != nz; ++k) {
+			s = zs[k];
+			h.normalise (s, zpj);
+			noalias(s) -= zpj;
+			sv = s;
+			const Float d2 = UdUmahalanobis (SUD, sv);
+			wn[jz+k] = pd * w[j] * std::exp(Float(-0.5) * (d2 + logdet));
+			sum_q[k] += wn[jz+k];
+			ColMatrix::Column mnk(mn,jz+k);
+			noalias(mnk) = column(m,j);
+			noalias(mnk) += prod(W, s);
+		}
+	}
+								// Normalise detections of each z
+	for (std::size_t k = 0; k != nz; ++k) {
+		const Float norm = clutter_density + sum_q[k];
+		if (norm > 0) {		// Otherwise z is explained by no component and its weights are zero
+			for (std::size_t j = 0; j != J; ++j)
+				wn[J + j*nz + k] /= norm;
+		}
+	}
+
+	w.swap (wn);
+	m.swap (mn);
+	P.swap (Pn);
+	return rcond_min;
+}
+
+
+Bayes_base::Float GM_PHD_scheme::number () const
+{
+	Float n = 0;
+	for (std::size_t j = 0; j != size(); ++j)
+		n += w[j];
+	return n;
+}
+
+void GM_PHD_scheme::estimates (std::vector<FM::Vec>& xs, Float threshold) const
+{
+	xs.clear();
+	for (std::size_t j = 0; j != size(); ++j) {
+		if (w[j] > threshold) {
+			const std::size_t copies = std::max(std::size_t(1), std::size_t(w[j] + Float(0.5)));
+			for (std::size_t c = 0; c != copies; ++c)
+				xs.push_back (column(m,j));
+		}
+	}
+}
+
+
+void GM_PHD_scheme::reduce ()
+/* Prune components with small weights, merge close components and
+ * keep at most max_components with the largest weights
+ */
+{
+	const std::size_t J = size();
+	std::size_t keep = 0;
+	for (std::size_t j = 0; j != J; ++j) {
+		if (w[j] > prune_threshold) {
+			if (keep != j) {
+				w[keep] = w[j];
+				column(m,keep) = column(m,j);
+				P.sub_matrix(keep*x_size,(keep+1)*x_size, 0,x_size) = P.sub_matrix(j*x_size,(j+1)*x_size, 0,x_size);
+			}
+			++keep;
+		}
+	}
+	resize (keep);
+	merge ();
+}
+
+
+namespace {
+	typedef std::vector<long> Cell;
+	struct Cell_hash
+	{
+		std::size_t operator() (const Cell& c) const
+		{
+			std::size_t h = 0;
+			for (Cell::const_iterator ci = c.begin(); ci != c.end(); ++ci)
+				h = h * 1000003u ^ std::size_t(*ci);
+			return h;
+		}
+	};
+	typedef std::unordered_map<Cell, std::vector<std::size_t>, Cell_hash> Grid;
+
+	struct More_weight
+	{
+		More_weight (const DenseVec& w) : w(w)
+		{}
+		bool operator() (std::size_t a, std::size_t b) const
+		{	return w[a] > w[b];
+		}
+		const DenseVec& w;
+	};
+	struct Is_merged
+	{
+		Is_merged (const std::vector<bool>& merged) : merged(merged)
+		{}
+		bool operator() (std::size_t j) const
+		{	return merged[j];
+		}
+		const std::vector<bool>& merged;
+	};
+}//namespace
+
+void GM_PHD_scheme::merge ()
+/* Merge components following [1]
+ *  The leading (largest weight) component i is merged with the components j for which
+ *  (mi-mj)' inv(Xj) (mi-mj) <= merge_threshold, using the covariance of each candidate j.
+ *  Within this bound mi is within sqrt(merge_threshold*Xj(k,k)) of mj for each state element k.
+ *  Each component is entered in the cells of a grid over the index elements which this box overlaps,
+ *  the grid has a cell size of the median of the bounds. The candidates of component i are then those
+ *  in the cell containing mi. Components overlapping many cells are instead candidates of all components.
+ */
+{
+	const std::size_t J = size(), ni = index.size();
+	if (J == 0)
+		return;
+	const std::size_t max_cells = 64;	// Cells of a component before it is a candidate of all components
+								// Factorise each component covariance
+	RowMatrix UDs(J*x_size, x_size);
+	{
+		RowMatrix UD(x_size,x_size);
+		SymMatrix Pj(x_size,x_size);
+		for (std::size_t j = 0; j != J; ++j) {
+			Pj = P.sub_matrix(j*x_size,(j+1)*x_size, 0,x_size);
+			Float rcond = UdUfactor (UD, Pj);
+			rclimit.check_PD(rcond, "Component X not PD in merge");
+			UDs.sub_matrix(j*x_size,(j+1)*x_size, 0,x_size) = UD;
+		}
+	}
+								// Grid cell size
+	std::vector<Float> cell(ni);
+	{
+		std::vector<Float> bound(J);
+		for (std::size_t k = 0; k != ni; ++k) {
+			const std::size_t e = index[k];
+			for (std::size_t j = 0; j != J; ++j)
+				bound[j] = std::sqrt(merge_threshold * P(j*x_size+e, e));
+			std::nth_element (bound.begin(), bound.begin() + J/2, bound.end());
+			cell[k] = std::max(bound[J/2], std::numeric_limits<Float>::min());
+		}
+	}
+	Grid grid;
+	std::vector<std::size_t> broad;
+	Cell c(ni), lo(ni), hi(ni);
+	for (std::size_t j = 0; j != J; ++j) {
+		std::size_t cells = 1;
+		for (std::size_t k = 0; k != ni; ++k) {
+			const std::size_t e = index[k];
+			const Float b = std::sqrt(merge_threshold * P(j*x_size+e, e));
+			lo[k] = long(std::floor((m(e,j) - b) / cell[k]));
+			hi[k] = long(std::floor((m(e,j) + b) / cell[k]));
+			cells *= std::size_t(hi[k] - lo[k] + 1);
+		}
+		if (cells > max_cells) {
+			broad.push_back (j);
+			continue;
+		}
+		c = lo;
+		for (std::size_t n = 0; n != cells; ++n) {
+			grid[c].push_back (j);
+			for (std::size_t k = 0; k != ni; ++k) {		// Next cell
+				if (++c[k] <= hi[k])
+					break;
+				c[k] = lo[k];
+			}
+		}
+	}
+
+	std::vector<std::size_t> order(J);
+	for (std::size_t j = 0; j != J; ++j)
+		order[j] = j;
+	std::sort (order.begin(), order.end(), More_weight(w));
+
+	std::vector<bool> merged(J, false);
+	std::vector<std::size_t> candidates, group;
+	RowMatrix UD(x_size,x_size);
+	RowMatrix Pg(x_size,x_size);
+	Vec d(x_size), dv(x_size), mg(x_size);
+
+	DenseVec wr(J);
+	ColMatrix mr(x_size, J);
+	RowMatrix Pr(J*x_size, x_size);
+	std::size_t nr = 0;
+
+	for (std::size_t oi = 0; oi != J; ++oi) {
+		const std::size_t i = order[oi];
+		if (merged[i])
+			continue;
+								// Candidates in the cell of component i
+		for (std::size_t k = 0; k != ni; ++k)
+			c[k] = long(std::floor(m(index[k],i) / cell[k]));
+		candidates.clear();
+		candidates.push_back (i);
+		Grid::iterator gi = grid.find(c);
+		if (gi != grid.end()) {
+			std::vector<std::size_t>& ci = gi->second;
+			ci.erase (std::remove_if(ci.begin(), ci.end(), Is_merged(merged)), ci.end());
+			candidates.insert (candidates.end(), ci.begin(), ci.end());
+		}
+		candidates.insert (candidates.end(), broad.begin(), broad.end());
+
+								// Merge group within the Mahalanobis distance of each candidate
+		group.clear();
+		Float wg = 0;
+		for (std::vector<std::size_t>::const_iterator ji = candidates.begin(); ji != candidates.end(); ++ji) {
+			const std::size_t j = *ji;
+			if (merged[j])
+				continue;
+			bool in = (j == i);
+			if (!in) {
+				noalias(d) = column(m,j) - column(m,i);
+				dv = d;
+				noalias(UD) = UDs.sub_matrix(j*x_size,(j+1)*x_size, 0,x_size);
+				in = UdUmahalanobis (UD, dv) <= merge_threshold;
+			}
+			if (in) {
+				merged[j] = true;
+				group.push_back (j);
+				wg += w[j];
+			}
+		}
+
+		wr[nr] = wg;
+		mg.clear();
+		for (std::size_t g = 0; g != group.size(); ++g)
+			noalias(mg) += (w[group[g]] / wg) * column(m,group[g]);
+		Pg.clear();
+		for (std::size_t g = 0; g != group.size(); ++g) {
+			const std::size_t j = group[g];
+			noalias(d) = column(m,j) - mg;
+			noalias(Pg) += (w[j] / wg) * (P.sub_matrix(j*x_size,(j+1)*x_size, 0,x_size) + outer_prod(d, d));
+		}
+		column(mr,nr) = mg;
+		Pr.sub_matrix(nr*x_size,(nr+1)*x_size, 0,x_size) = Pg;
+		++nr;
+	}
+	w.swap (wr);
+	m.swap (mr);
+	P.swap (Pr);
+	resize (nr);
+								// Keep the largest weights
+	if (nr > max_components) {
+		order.resize (nr);
+		for (std::size_t j = 0; j != nr; ++j)
+			order[j] = j;
+		std::nth_element (order.begin(), order.begin() + max_components, order.end(), More_weight(w));
+		std::sort (order.begin(), order.begin() + max_components);
+		for (std::size_t j = 0; j != max_components; ++j) {
+			const std::size_t k = order[j];		// k >= j as order is sorted
+			w[j] = w[k];
+			column(m,j) = column(m,k);
+			P.sub_matrix(j*x_size,(j+1)*x_size, 0,x_size) = P.sub_matrix(k*x_size,(k+1)*x_size, 0,x_size);
+		}
+		resize (max_components);
+	}
+}
+
+
+}//namespace
@@ -0,0 +1,93 @@
+#ifndef _BAYES_FILTER_PHD
+#define _BAYES_FILTER_PHD
+
+/*
+ * Bayes++ the Bayesian Filtering Library
+ * Copyright (c) 2002 Michael Stevens
+ * See accompanying Bayes++.htm for terms and conditions of use.
+ *
+ * $Id$
+ */
+
+/*
+ * Gaussian Mixture Probability Hypothesis Density Filter Scheme.
+ *  A multi-target filter for an unknown and varying number of targets in clutter
+ *
+ * The PHD (intensity) of the targets is represented by a weighted mixture of Gaussian components.
+ * The sum of the weights is the expected number of targets. Targets are not associated with
+ * measurements: each component is updated with every measurement and with a missed detection.
+ *
+ * Components are stored contiguously: means as the columns of one matrix and covariances
+ * stacked in another, so the linear predict and observe are batched matrix products over all components.
+ * Reduction merges each leading component with the components it lies within a Mahalanobis distance of,
+ * measured with the covariance of each of those components as [1]. Candidates are found with a uniform grid
+ * over selected state elements (typically position), so the cost is linear in the number of components
+ * rather than that of a pairwise scan.
+ *
+ * The filter is operated by performing a
+ *  predict, birth, observe, reduce
+ * cycle
+ *
+ * Reference
+ *  [1] "The Gaussian mixture probability hypothesis density filter"
+ *   BN Vo, WK Ma IEEE Transactions on Signal Processing Vol.54 No.11 2006
+ */
+#include "bayesFlt.hpp"
+#include <vector>
+
+/* Filter namespace */
+namespace Bayesian_filter
+{
+
+class GM_PHD_scheme : public Bayes_base
+{
+public:
+	FM::DenseVec w;		// Component weights
+	FM::ColMatrix m;	// Component means, column j is component j
+	FM::RowMatrix P;	// Component covariances, rows j*x_size to (j+1)*x_size are component j
+
+	GM_PHD_scheme (std::size_t x_size, std::size_t max_components);
+
+	void init ();
+	// No components
+	std::size_t size () const
+	{	return w.size();
+	}
+	FM::SymMatrix X (std::size_t j) const;
+	// Covariance of component j
+
+	void birth (Float weight, const FM::Vec& x, const FM::SymMatrix& X);
+	// Add a component representing target birth
+	void predict (Linear_predict_model& f);
+	Float observe (Linear_uncorrelated_observe_model& h, const std::vector<FM::Vec>& zs);
+	void reduce ();
+	// Prune and merge components
+
+	Float number () const;
+	// Expected number of targets
+	void estimates (std::vector<FM::Vec>& xs, Float threshold = 0.5) const;
+	// Means of components with weight above threshold, repeated by their rounded weight
+
+	Float ps;					// Probability of target survival
+	Float pd;					// Probability of target detection
+	Float clutter_density;		// Clutter measurements per unit volume of measurement space, 0 for no clutter
+	Float prune_threshold;		// Components with smaller weights are removed
+	Float merge_threshold;		// Mahalanobis distance within which components are merged
+	const std::size_t max_components;
+	std::vector<std::size_t> index;	// State elements of the merge grid, initially the first two
+
+	Numerical_rcond rclimit;
+	// Minimum allowable reciprocal condition number for PD Matrix factorisations
+
+protected:
+	void resize (std::size_t n);
+	// Resize component storage, preserving the components
+	void merge ();
+
+private:
+	std::size_t x_size;
+};
+
+
+}//namespace
+#endif
@@ -114,6 +114,10 @@ public:
 	{}	// Normal sized constructor
 	FMVec(const FMVec& c) : VecBase(static_cast<const VecBase&>(c))
 	{}	// Copy constructor
+	FMVec(FMVec&& c) noexcept : VecBase()
+	{	// Move constructor, takes the storage of c leaving it empty
+		VecBase::swap(c);
+	}
 	template <class E>
 	explicit FMVec(const ublas::vector_expression<E>& e) : VecBase(e)
 	{}	// vector_expression copy constructor
@@ -132,6 +136,14 @@ public:
 		VecBase::assign(r);
 		return *this;
 	}
+	FMVec& operator= (FMVec&& r)
+	{	// Vector move assignment; independent. Precond: size conformance, as copy assignment
+		if (VecBase::size() == r.size())
+			VecBase::swap(r);	// Storage is exchanged with r
+		else
+			VecBase::assign(r);	// Non conformant, fails as copy assignment
+		return *this;
+	}
 
 	// Sub-range selection operators
 	const ublas::vector_range<const VecBase> sub_range(std::size_t b, std::size_t e) const
@@ -163,6 +175,10 @@ public:
 	{}	// Normal sized constructor
 	FMMatrix(const FMMatrix& c) : MatrixBase(static_cast<const MatrixBase&>(c))
 	{}	// Copy constructor
+	FMMatrix(FMMatrix&& c) noexcept : MatrixBase()
+	{	// Move constructor, takes the storage of c leaving it empty
+		MatrixBase::swap(c);
+	}
 	template <class E>
 	explicit FMMatrix(const ublas::matrix_expression<E>& e) : MatrixBase(e)
 	{}	// matrix_expression copy constructor
@@ -178,6 +194,14 @@ public:
 		MatrixBase::assign (r);
 		return *this;
 	}
+	FMMatrix& operator= (FMMatrix&& r)
+	{	// Matrix move assignment; independent. Precond: size conformance, as copy assignment
+		if (MatrixBase::size1() == r.size1() && MatrixBase::size2() == r.size2())
+			MatrixBase::swap (r);	// Storage is exchanged with r
+		else
+			MatrixBase::assign (r);	// Non conformant, fails as copy assignment
+		return *this;
+	}
 
 	// Row,Column vector proxies
 	typedef ublas::matrix_row<FMMatrix> Row;
@@ -277,6 +301,10 @@ public:
 	{}	// Normal sized constructor
 	explicit SymMatrixWrapper (const SymMatrixWrapper& r) : matrix_type(reinterpret_cast<const MatrixBase&>(r)), symadaptor_type(matrix_type::member)
 	{}	// Explicit copy construction referencing the copy reinterpreted as a MatrixBase
+	SymMatrixWrapper (SymMatrixWrapper&& r) noexcept : matrix_type(), symadaptor_type(matrix_type::member)
+	{	// Move construction, the adaptor references our own member which takes the storage of r
+		swap(r);
+	}
 	template <class E>
 	explicit SymMatrixWrapper (const ublas::matrix_expression<E>& e) : matrix_type(e), symadaptor_type(matrix_type::member)
 	{}	// Explicit matrix_expression conversion constructor
@@ -287,6 +315,14 @@ public:
 		symadaptor_type::operator=(r);
 		return *this;
 	}
+	SymMatrixWrapper& operator=(SymMatrixWrapper&& r)
+	{	// Move assignment; independent. Precond: size conformance, as copy assignment
+		if (matrix_type::member.size1() == r.matrix_type::member.size1() && matrix_type::member.size2() == r.matrix_type::member.size2())
+			swap(r);	// Storage is exchanged with r
+		else
+			symadaptor_type::operator=(r);	// Non conformant, fails as copy assignment
+		return *this;
+	}
 
 	// Conversions straight to a FMMatrix, equivalent to a RowMatrix types
 	const FMMatrix<MatrixBase>& asRowMatrix() const
@@ -306,6 +342,10 @@ public:
 	{
 		matrix_type::member.resize(nsize1, nsize2, preserve);
 	}
+	void swap(SymMatrixWrapper& r)
+	{	// Exchange storage, hides symmetric_adaptor::swap which exchanges elements
+		matrix_type::member.swap(r.matrix_type::member);
+	}
 };
 
 }//namespace detail
@@ -349,6 +389,64 @@ typedef FMMatrix<detail::SymMatrixWrapper<detail::BaseSparseRowMatrix> > SparseS
 #endif
 
 
+/*
+ * Size cache: retains the storage of a few previous sizes of a Vec or Matrix
+ *  exchange sizes m by swapping storage with a retained one of the required size. The storage of the
+ *  previous size is retained in its place, so alternating between a few sizes does not reallocate.
+ *  m is only resized (reallocated) when no retained storage has the required size.
+ *  Elements are not preserved by exchange, as resize(..., false)
+ *  Each slot holds storage while idle, so the default of two slots covers the common case of
+ *  alternating between two or three observation sizes without holding many idle copies.
+ */
+template <class M, std::size_t Slots = 2>
+class Size_cache
+{
+public:
+	Size_cache () : slot(Slots, M(Empty)), used(0), oldest(0)
+	{}
+	void exchange (M& m, std::size_t size)
+	{	// Vec sizing
+		if (m.size() == size)
+			return;
+		for (std::size_t i = 0; i < used; ++i) {
+			if (slot[i].size() == size) {
+				slot[i].swap (m);
+				return;
+			}
+		}
+		if (m.size() != 0)
+			retain (m);
+		m.resize (size, false);
+	}
+	void exchange (M& m, std::size_t size1, std::size_t size2)
+	{	// Matrix sizing
+		if (m.size1() == size1 && m.size2() == size2)
+			return;
+		for (std::size_t i = 0; i < used; ++i) {
+			if (slot[i].size1() == size1 && slot[i].size2() == size2) {
+				slot[i].swap (m);
+				return;
+			}
+		}
+		if (m.size1() != 0 && m.size2() != 0)
+			retain (m);
+		m.resize (size1,size2, false);
+	}
+private:
+	void retain (M& m)
+	{	// Retain storage of m in a free slot or in place of the oldest, m is left with the displaced storage
+		if (used < Slots)
+			slot[used++].swap (m);
+		else {
+			slot[oldest].swap (m);
+			oldest = (oldest+1) % Slots;
+		}
+	}
+	std::vector<M> slot;
+	std::size_t used, oldest;
+};
+
+
 /*
  * Matrix Adaptors, simply hide the uBLAS details
  */
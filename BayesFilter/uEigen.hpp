@@ -0,0 +1,73 @@
+/*
+ * Bayes++ the Bayesian Filtering Library
+ * Copyright (c) 2002 Michael Stevens
+ * See accompanying Bayes++.htm for terms and conditions of use.
+ *
+ * $Id$
+ */
+
+/*
+ * uBLAS to Eigen Interface
+ *  Eigen views of the aligned dense storage for the vectorised kernels of matSup (see BAYES_FILTER_ALIGNED)
+ *  The views share the storage of the uBLAS matrices, nothing is copied
+ */
+
+#include <Eigen/Core>
+#include <cstddef>
+
+/* Filter Matrix Namespace */
+namespace Bayesian_filter_matrix
+{
+namespace EIGEN {
+
+/* Support types */
+typedef Eigen::Matrix<Float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> matrix_t;
+typedef Eigen::Matrix<Float, Eigen::Dynamic, 1> vector_t;
+
+						// Storage starts on a BAYES_FILTER_ALIGNMENT boundary, rows within it are not aligned
+const int storage_alignment = BAYES_FILTER_ALIGNMENT >= EIGEN_MAX_ALIGN_BYTES ? Eigen::AlignedMax : Eigen::Unaligned;
+typedef Eigen::Map<matrix_t, storage_alignment> map_t;
+typedef Eigen::Map<const matrix_t, storage_alignment> const_map_t;
+typedef Eigen::Map<vector_t, storage_alignment> vector_map_t;
+
+
+/* Views */
+
+inline map_t view (RowMatrix& M)
+{
+	return map_t(M.data().begin(), M.size1(), M.size2());
+}
+
+inline const_map_t view (const RowMatrix& M)
+{
+	return const_map_t(M.data().begin(), M.size1(), M.size2());
+}
+
+inline vector_map_t view (Vec& v)
+{
+	return vector_map_t(v.data().begin(), v.size());
+}
+
+
+/* Workspace */
+
+inline Eigen::Map<vector_t> workspace (std::size_t n)
+/* Thread local workspace of at least n elements
+ *  Grows but is never released, so repeated kernels of similar size do not allocate
+ *  Valid until the next call to workspace in the same thread
+ */
+{
+	thread_local vector_t work;
+	if (std::size_t(work.size()) < n)
+		work.resize (n);
+	return Eigen::Map<vector_t>(work.data(), n);
+}
+
+inline Eigen::Map<matrix_t> workspace (std::size_t r, std::size_t c)
+// Thread local workspace viewed as an r by c matrix
+{
+	return Eigen::Map<matrix_t>(workspace(r*c).data(), r, c);
+}
+
+}// namespace EIGEN
+}// namespace
@@ -9,6 +9,7 @@
 /*
  * uBLAS to LAPACK Interface
  *  Very basic we only functions for information_root_filter supported
+ *  and the BLAS/LAPACK dispatch of matSup (see BAYES_FILTER_LAPACK)
  */
 
 /* Filter Matrix Namespace */
@@ -75,6 +76,135 @@ namespace rawLAPACK {
 			int ipivot[],
 			int& info);
 
+	void dpotrf_(
+			const char& uplo,
+			const int& n,
+			double da[],
+			const int& lda,
+			int& info);
+	void spotrf_(
+			const char& uplo,
+			const int& n,
+			float da[],
+			const int& lda,
+			int& info);
+
+	void dpotri_(
+			const char& uplo,
+			const int& n,
+			double da[],
+			const int& lda,
+			int& info);
+	void spotri_(
+			const char& uplo,
+			const int& n,
+			float da[],
+			const int& lda,
+			int& info);
+
+	// BLAS level 3
+	void dsymm_(
+			const char& side,
+			const char& uplo,
+			const int& m,
+			const int& n,
+			const double& alpha,
+			const double da[],
+			const int& lda,
+			const double db[],
+			const int& ldb,
+			const double& beta,
+			double dc[],
+			const int& ldc);
+	void ssymm_(
+			const char& side,
+			const char& uplo,
+			const int& m,
+			const int& n,
+			const float& alpha,
+			const float da[],
+			const int& lda,
+			const float db[],
+			const int& ldb,
+			const float& beta,
+			float dc[],
+			const int& ldc);
+
+	void dsyrk_(
+			const char& uplo,
+			const char& trans,
+			const int& n,
+			const int& k,
+			const double& alpha,
+			const double da[],
+			const int& lda,
+			const double& beta,
+			double dc[],
+			const int& ldc);
+	void ssyrk_(
+			const char& uplo,
+			const char& trans,
+			const int& n,
+			const int& k,
+			const float& alpha,
+			const float da[],
+			const int& lda,
+			const float& beta,
+			float dc[],
+			const int& ldc);
+
+	void dsyr2k_(
+			const char& uplo,
+			const char& trans,
+			const int& n,
+			const int& k,
+			const double& alpha,
+			const double da[],
+			const int& lda,
+			const double db[],
+			const int& ldb,
+			const double& beta,
+			double dc[],
+			const int& ldc);
+	void ssyr2k_(
+			const char& uplo,
+			const char& trans,
+			const int& n,
+			const int& k,
+			const float& alpha,
+			const float da[],
+			const int& lda,
+			const float db[],
+			const int& ldb,
+			const float& beta,
+			float dc[],
+			const int& ldc);
+
+	void dtrsm_(
+			const char& side,
+			const char& uplo,
+			const char& transa,
+			const char& diag,
+			const int& m,
+			const int& n,
+			const double& alpha,
+			const double da[],
+			const int& lda,
+			double db[],
+			const int& ldb);
+	void strsm_(
+			const char& side,
+			const char& uplo,
+			const char& transa,
+			const char& diag,
+			const int& m,
+			const int& n,
+			const float& alpha,
+			const float da[],
+			const int& lda,
+			float db[],
+			const int& ldb);
+
 	}// extern "C"
 
 	// Type overloads for C++
@@ -102,6 +232,54 @@ namespace rawLAPACK {
 	{
 		sgetrf_(m,n,da,lda,ipivot,info);
 	}
+	inline void potrf( const char& uplo, const int& n, double da[], const int& lda, int& info)
+	{
+		dpotrf_(uplo,n,da,lda,info);
+	}
+	inline void potrf( const char& uplo, const int& n, float da[], const int& lda, int& info)
+	{
+		spotrf_(uplo,n,da,lda,info);
+	}
+	inline void potri( const char& uplo, const int& n, double da[], const int& lda, int& info)
+	{
+		dpotri_(uplo,n,da,lda,info);
+	}
+	inline void potri( const char& uplo, const int& n, float da[], const int& lda, int& info)
+	{
+		spotri_(uplo,n,da,lda,info);
+	}
+	inline void symm( const char& side, const char& uplo, const int& m, const int& n, const double& alpha, const double da[], const int& lda, const double db[], const int& ldb, const double& beta, double dc[], const int& ldc)
+	{
+		dsymm_(side,uplo,m,n,alpha,da,lda,db,ldb,beta,dc,ldc);
+	}
+	inline void symm( const char& side, const char& uplo, const int& m, const int& n, const float& alpha, const float da[], const int& lda, const float db[], const int& ldb, const float& beta, float dc[], const int& ldc)
+	{
+		ssymm_(side,uplo,m,n,alpha,da,lda,db,ldb,beta,dc,ldc);
+	}
+	inline void syrk( const char& uplo, const char& trans, const int& n, const int& k, const double& alpha, const double da[], const int& lda, const double& beta, double dc[], const int& ldc)
+	{
+		dsyrk_(uplo,trans,n,k,alpha,da,lda,beta,dc,ldc);
+	}
+	inline void syrk( const char& uplo, const char& trans, const int& n, const int& k, const float& alpha, const float da[], const int& lda, const float& beta, float dc[], const int& ldc)
+	{
+		ssyrk_(uplo,trans,n,k,alpha,da,lda,beta,dc,ldc);
+	}
+	inline void syr2k( const char& uplo, const char& trans, const int& n, const int& k, const double& alpha, const double da[], const int& lda, const double db[], const int& ldb, const double& beta, double dc[], const int& ldc)
+	{
+		dsyr2k_(uplo,trans,n,k,alpha,da,lda,db,ldb,beta,dc,ldc);
+	}
+	inline void syr2k( const char& uplo, const char& trans, const int& n, const int& k, const float& alpha, const float da[], const int& lda, const float db[], const int& ldb, const float& beta, float dc[], const int& ldc)
+	{
+		ssyr2k_(uplo,trans,n,k,alpha,da,lda,db,ldb,beta,dc,ldc);
+	}
+	inline void trsm( const char& side, const char& uplo, const char& transa, const char& diag, const int& m, const int& n, const double& alpha, const double da[], const int& lda, double db[], const int& ldb)
+	{
+		dtrsm_(side,uplo,transa,diag,m,n,alpha,da,lda,db,ldb);
+	}
+	inline void trsm( const char& side, const char& uplo, const char& transa, const char& diag, const int& m, const int& n, const float& alpha, const float da[], const int& lda, float db[], const int& ldb)
+	{
+		strsm_(side,uplo,transa,diag,m,n,alpha,da,lda,db,ldb);
+	}
 }// namespace rawLAPACK
 
 
@@ -120,7 +298,7 @@ typedef Bayesian_filter_matrix::DenseColMatrix matrix_t;
 //    info    (OUT - int)
 //   0   : function completed normally
 //   < 0 : The ith argument, where i = abs(return value) had an illegal value.
-int geqrf (matrix_t& a, vector_t& tau)
+inline int geqrf (matrix_t& a, vector_t& tau)
 {
 	int              _m = int(a.size1());
 	int              _n = int(a.size2());
@@ -148,7 +326,7 @@ int geqrf (matrix_t& a, vector_t& tau)
 //   0   :  successful exit
 //   < 0 :  If INFO = -i, then the i-th argument had an illegal value.
 //   > 0 :  If INFO = i, then U(i,i) is exactly zero. The  factorization has been completed, but the factor U is exactly singular, and division by zero will occur if it is used to solve a system of equations.
-int getrf (matrix_t& a, pivot_t& ipivot)
+inline int getrf (matrix_t& a, pivot_t& ipivot)
 {
 	matrix_t::value_type* _a = a.data().begin();
 	int _m = int(a.size1());
@@ -173,7 +351,7 @@ int getrf (matrix_t& a, pivot_t& ipivot)
 //   0   : function completed normally
 //   < 0 : The ith argument, where i = abs(return value) had an illegal value.
 //   > 0 : if INFO =  i,  U(i,i)  is  exactly  zero;  the  matrix is singular and its inverse could not be computed.
-int getrs (char transa, matrix_t& a,
+inline int getrs (char transa, matrix_t& a,
 	    pivot_t& ipivot, matrix_t& b)
 {
 	matrix_t::value_type* _a = a.data().begin();
@@ -198,5 +376,41 @@ int getrs (char transa, matrix_t& a,
 	return _info;
 } 
 
+// Cholesky factorization of a symmetric positive definite matrix A.
+//    uplo    (IN - char) 'U' upper triangle of A is stored and factored as A = U'*U, 'L' lower triangle as A = L*L'
+//    a       (IN/OUT - matrix(N,N)) On entry, the symmetric matrix A, only the uplo triangle is referenced. On exit, the factor U or L in the same triangle.
+//    info    (OUT - int)
+//   0   : successful exit
+//   < 0 : If INFO = -i, then the i-th argument had an illegal value.
+//   > 0 : If INFO = i, the leading minor of order i is not positive definite, and the factorization could not be completed.
+inline int potrf (char uplo, matrix_t& a)
+{
+	int _n = int(a.size1());
+	int _lda = _n;
+	int _info;
+
+	rawLAPACK::potrf (uplo, _n, a.data().begin(), _lda, _info);
+
+	return _info;
+}
+
+// Inverse of a symmetric positive definite matrix A using the Cholesky factorization computed by POTRF.
+//    uplo    (IN - char) as used in POTRF
+//    a       (IN/OUT - matrix(N,N)) On entry, the triangular factor U or L. On exit, the uplo triangle of inv(A).
+//    info    (OUT - int)
+//   0   : successful exit
+//   < 0 : If INFO = -i, then the i-th argument had an illegal value.
+//   > 0 : If INFO = i, the (i,i) element of the factor is zero, and the inverse could not be computed.
+inline int potri (char uplo, matrix_t& a)
+{
+	int _n = int(a.size1());
+	int _lda = _n;
+	int _info;
+
+	rawLAPACK::potri (uplo, _n, a.data().begin(), _lda, _info);
+
+	return _info;
+}
+
 }//namespace LAPACK
 }//namespace Bayesian_filter_matrix
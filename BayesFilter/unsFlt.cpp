@@ -12,6 +12,7 @@
 #include "unsFlt.hpp"
 #include "matSup.hpp"
 #include "models.hpp"
+#include "bayesTrace.hpp"
 #include <cmath>
 
 
@@ -24,8 +25,9 @@ namespace Bayesian_filter
 Unscented_scheme::Unscented_scheme (std::size_t x_size, std::size_t z_initialsize) :
 		Kalman_state_filter(x_size), Functional_filter(),
 		XX(x_size, 2*x_size+1),
-		s(Empty), S(Empty), SI(Empty),
-		fXX(x_size, 2*x_size+1)
+		s(Empty), S(Empty),
+			fXX(x_size, 2*x_size+1), Sigma(x_size,x_size), XXi(x_size),
+		zXX(Empty), zp(Empty), zXXi(Empty), W(Empty), WStemp(Empty)
 /* Initialise filter and set the size of things we know about
  */
 {
@@ -51,15 +53,13 @@ void Unscented_scheme::unscented (FM::ColMatrix& XX, const FM::Vec& x, const FM:
  * Fails if scale is negative
  */
 {
-	UTriMatrix Sigma(x_size,x_size);
-
 						// Get a upper Cholesky factorisation
 	Float rcond = UCfactor(Sigma, X);
 	rclimit.check_PSD(rcond, "X not PSD");
 	Sigma *= std::sqrt(scale);
 
 						// Generate XX with the same sample Mean and Covariance as before
-	column(XX,0) = x;
+	noalias(column(XX,0)) = x;
 
 	for (std::size_t c = 0; c < x_size; ++c) {
 		UTriMatrix::Column SigmaCol = column(Sigma,c);
@@ -131,6 +131,7 @@ void Unscented_scheme::update ()
  *  Post: x,X
  */
 {
+	BAYES_FILTER_TRACE_SPAN("Unscented_scheme::update");
 }
 
 void Unscented_scheme::update_XX (Float kappa)
@@ -198,6 +199,7 @@ void Unscented_scheme::predict (Functional_predict_model& f)
  * ISSUE: A simple specialisation is possible, rather then this adapted implementation
  */
 {
+	BAYES_FILTER_TRACE_SPAN("Unscented_scheme::predict");
 	Adapted_zero_model adaptedmodel(f);
 	predict (adaptedmodel);
 }
@@ -208,6 +210,7 @@ void Unscented_scheme::predict (Additive_predict_model& f)
  *  Computes noise covariance Q = GqG'
  */
 {
+	BAYES_FILTER_TRACE_SPAN("Unscented_scheme::predict");
 	Adapted_model adaptedmodel(f);
 	predict (adaptedmodel);
 }
@@ -220,6 +223,7 @@ void Unscented_scheme::predict (Unscented_predict_model& f)
  * Implementation uses specific model for fast Unscented computation
  */
 {
+	BAYES_FILTER_TRACE_SPAN("Unscented_scheme::predict");
 	const std::size_t XX_size = XX.size2();
 
 						// Create Unscented distribution
@@ -246,13 +250,17 @@ void Unscented_scheme::observe_size (std::size_t z_size)
 	if (z_size != last_z_size) {
 		last_z_size = z_size;
 
-		s.resize(z_size, false);
-		S.resize(z_size,z_size, false);
-		SI.resize(z_size,z_size, false);
+		s_cache.exchange (s, z_size);
+		S_cache.exchange (S, z_size,z_size);
+		factor_size (z_size);
+		zXX_cache.exchange (zXX, z_size,XX_size);
+		zp_cache.exchange (zp, z_size);
+		zXXi_cache.exchange (zXXi, z_size);
+		W_cache.exchange (W, x_size,z_size);
+		WStemp_cache.exchange (WStemp, x_size,z_size);
 	}
 }
 
-
 Bayes_base::Float Unscented_scheme::observe (Uncorrelated_additive_observe_model& h, const FM::Vec& z)
 /* Observation fusion
  *  Pre : x,X
@@ -262,6 +270,7 @@ Bayes_base::Float Unscented_scheme::observe (Uncorrelated_additive_observe_model
  * ISSUE: Simplified implementation using uncorrelated noise equations
  */
 {
+	BAYES_FILTER_TRACE_SPAN("Unscented_scheme::observe");
 	Adapted_Correlated_additive_observe_model hh(h);
 	return observe (hh, z);
 }
@@ -273,13 +282,7 @@ Bayes_base::Float Unscented_scheme::observe (Correlated_additive_observe_model&
  *  Post: x,X is PSD
  */
 {
-	std::size_t z_size = z.size();
-	ColMatrix zXX (z_size, 2*x_size+1);
-	Vec zp(z_size);
-	SymMatrix Xzz(z_size,z_size);
-	Matrix Xxz(x_size,z_size);
-	Matrix W(x_size,z_size);
-
+	BAYES_FILTER_TRACE_SPAN("Unscented_scheme::observe");
 	observe_size (z.size());	// Dynamic sizing
 
 						// Create Unscented distribution
@@ -289,14 +292,16 @@ Bayes_base::Float Unscented_scheme::observe (Correlated_additive_observe_model&
 
 						// Predict points of XX using supplied observation model
 	{
-		Vec zXXi(z_size), zXX0(z_size);
-		zXX0 = h.h( column(XX,0) );
-		column(zXX,0) = zXX0;
+		Vec& zXX0 = zp;		// zp is free until the mean is computed
+		noalias(XXi) = column(XX,0);
+		noalias(zXX0) = h.h(XXi);
+		noalias(column(zXX,0)) = zXX0;
 		for (std::size_t i = 1; i < XX.size2(); ++i) {
-			zXXi = h.h( column(XX,i) );
+			noalias(XXi) = column(XX,i);
+			noalias(zXXi) = h.h(XXi);
 						// Normalise relative to zXX0
 			h.normalise (zXXi, zXX0);
-			column(zXX,i) = zXXi;
+			noalias(column(zXX,i)) = zXXi;
 		}
 	}
 
@@ -307,7 +312,7 @@ Bayes_base::Float Unscented_scheme::observe (Correlated_additive_observe_model&
 	}
 	zp /= x_kappa;
 
-						// Covariance of observation predict: Xzz
+						// Covariance of observation predict: Xzz, accumulated in S
 							// Subtract mean from each point in zXX
 	for (std::size_t i = 0; i < XX_size; ++i) {
 		column(zXX,i).minus_assign (zp);
@@ -315,36 +320,35 @@ Bayes_base::Float Unscented_scheme::observe (Correlated_additive_observe_model&
 							// Center point, premult here by 2 for efficiency
 	{
 		ColMatrix::Column zXX0 = column(zXX,0);
-		noalias(Xzz) = FM::outer_prod(zXX0, zXX0);
-		Xzz *= 2*kappa;
+		noalias(S) = FM::outer_prod(zXX0, zXX0);
+		S *= 2*kappa;
 	}
 							// Remaining Unscented points
 	for (std::size_t i = 1; i < zXX.size2(); ++i) {
 		ColMatrix::Column zXXi = column(zXX,i);
-		noalias(Xzz) += FM::outer_prod(zXXi, zXXi);
+		noalias(S) += FM::outer_prod(zXXi, zXXi);
 	}
-	Xzz /= 2*x_kappa;
+	S /= 2*x_kappa;
 
-						// Correlation of state with observation: Xxz
+						// Correlation of state with observation: Xxz, accumulated in W
 							// Center point, premult here by 2 for efficiency
 	{
-		noalias(Xxz) = FM::outer_prod(column(XX,0) - x, column(zXX,0));
-		Xxz *= 2*kappa;
+		noalias(W) = FM::outer_prod(column(XX,0) - x, column(zXX,0));
+		W *= 2*kappa;
 	}
 							// Remaining Unscented points
 	for (std::size_t i = 1; i < zXX.size2(); ++i) {
-		noalias(Xxz) += FM::outer_prod(column(XX,i) - x, column(zXX,i));
+		noalias(W) += FM::outer_prod(column(XX,i) - x, column(zXX,i));
 	}
-	Xxz /= 2* (Float(x_size) + kappa);
+	W /= 2* (Float(x_size) + kappa);
 
 						// Innovation covariance
-	S = Xzz;
 	noalias(S) += h.Z;
-						// Inverse innovation covariance
-	Float rcond = UdUinversePD (SI, S);
+						// Factorise innovation covariance
+	Float rcond = factor_S (S);
 	rclimit.check_PD(rcond, "S not PD in observe");
-						// Kalman gain
-	noalias(W) = prod(Xxz,SI);
+						// Kalman gain, Xxz*inv(S) by solution with the factor of S
+	UdUsolve_right (SUD, W);
 
 						// Normalised innovation
 	h.normalise(s = z, zp);
@@ -352,8 +356,7 @@ Bayes_base::Float Unscented_scheme::observe (Correlated_additive_observe_model&
 
 						// Filter update
 	noalias(x) += prod(W,s);
-	RowMatrix WStemp(W.size1(), S.size2());
-	noalias(X) -= prod_SPD(W,S, WStemp);
+	minus_assign_prod_SPD (X, W, S, WStemp);
 
 	return rcond;
 }
@@ -66,7 +66,7 @@ private:
 };
 
 
-class Unscented_scheme : public Linrz_kalman_filter, public Functional_filter
+class Unscented_scheme : public Linrz_kalman_filter, public Functional_filter, public Innovation_factor
 {
 private:
 	std::size_t q_max;			// Maximum size allocated for noise model, constructed before XX
@@ -108,7 +108,7 @@ public:
 
 public:						// Exposed Numerical Results
 	FM::Vec s;					// Innovation
-	FM::SymMatrix S, SI;		// Innovation Covariance and Inverse
+	FM::SymMatrix S;			// Innovation Covariance
 
 protected:
 	virtual Float predict_Kappa (std::size_t size) const;
@@ -120,6 +120,8 @@ protected:
 protected:					// allow fast operation if z_size remains constant
 	std::size_t last_z_size;
 	void observe_size (std::size_t z_size);
+	FM::Size_cache<FM::Vec> s_cache;
+	FM::Size_cache<FM::SymMatrix> S_cache;
 
 private:
 	void unscented (FM::ColMatrix& XX, const FM::Vec& x, const FM::SymMatrix& X, Float scale);
@@ -129,6 +131,16 @@ private:
 
 protected:			   		// Permanently allocated temps
 	FM::ColMatrix fXX;
+	FM::UTriMatrix Sigma;		// Scaled Cholesky factor of X for the Unscented points
+	FM::Vec XXi;				// An Unscented point
+	FM::ColMatrix zXX;			// Observation of each Unscented point, sized by observe_size
+	FM::Vec zp, zXXi;
+	FM::Matrix W;				// Correlation of state with observation and then Kalman gain
+	FM::RowMatrix WStemp;
+	FM::Size_cache<FM::ColMatrix> zXX_cache;
+	FM::Size_cache<FM::Vec> zp_cache, zXXi_cache;
+	FM::Size_cache<FM::Matrix> W_cache;
+	FM::Size_cache<FM::RowMatrix> WStemp_cache;
 };
 
 
@@ -0,0 +1,128 @@
+/*
+ * Bayes++ the Bayesian Filtering Library
+ * Copyright (c) 2002 Michael Stevens
+ * See accompanying Bayes++.htm for terms and conditions of use.
+ *
+ * $Id$
+ */
+
+/*
+ * Benchmark of the vectorised kernels of BAYES_FILTER_ALIGNED against uBLAS
+ *  Each kernel is timed with aligned_dispatch_size set so every operation is dispatched to the
+ *  vectorised kernels, and again so none are. A Covariance_scheme observe is timed in the same way.
+ *  The time of each operation and the speedup are reported for a range of dimensions.
+ *  Without BAYES_FILTER_ALIGNED both times are of uBLAS.
+ */
+
+#include "BayesFilter/covFlt.hpp"
+#include "BayesFilter/matSup.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+
+using namespace Bayesian_filter;
+using namespace Bayesian_filter_matrix;
+
+namespace
+{
+	std::mt19937 rng (3);
+
+	void random (RowMatrix& M)
+	{
+		std::normal_distribution<Float> normal;
+		for (std::size_t r = 0; r != M.size1(); ++r)
+			for (std::size_t c = 0; c != M.size2(); ++c)
+				M(r,c) = normal(rng);
+	}
+
+	SymMatrix random_PD (std::size_t n)
+	{
+		RowMatrix A(n,n);
+		random (A);
+		SymMatrix P(n,n);
+		P = prod(A, trans(A));
+		for (std::size_t i = 0; i != n; ++i)
+			P(i,i) += Float(n);
+		return P;
+	}
+
+	template <class Op>
+	double seconds (Op op, bool vectorised, std::size_t repeats)
+	// Time of one op, the best of several batches
+	{
+		aligned_dispatch_size = vectorised ? 1 : std::numeric_limits<std::size_t>::max();
+		op ();
+		double best = std::numeric_limits<double>::max();
+		for (int batch = 0; batch != 7; ++batch) {
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			for (std::size_t i = 0; i != repeats; ++i)
+				op ();
+			best = std::min (best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / double(repeats));
+		}
+		return best;
+	}
+
+	template <class Op>
+	void report (const char* name, std::size_t n, Op op)
+	{
+		const std::size_t repeats = 4000000 / (n*n*n) + 10;
+		const double u = seconds (op, false, repeats);
+		const double v = seconds (op, true, repeats);
+		std::cout << std::setw(24) << name << std::setw(5) << n
+			<< std::setw(14) << u * 1e6 << std::setw(14) << v * 1e6 << std::setw(10) << u / v << std::endl;
+	}
+
+	class Observe : public Linear_uncorrelated_observe_model
+	{
+	public:
+		Observe (std::size_t x_size, std::size_t z_size) : Linear_uncorrelated_observe_model(x_size, z_size)
+		{
+			random (Hx);
+			for (std::size_t i = 0; i != z_size; ++i)
+				Zv[i] = 1;
+		}
+	};
+}//namespace
+
+
+int main ()
+{
+#ifdef BAYES_FILTER_ALIGNED
+	std::cout << "Vectorised kernels compared with uBLAS" << std::endl;
+#else
+	std::cout << "Without BAYES_FILTER_ALIGNED, uBLAS compared with uBLAS" << std::endl;
+#endif
+	std::cout << std::setw(24) << "operation" << std::setw(5) << "n"
+		<< std::setw(14) << "uBLAS us" << std::setw(14) << "vector us" << std::setw(10) << "speedup" << std::endl;
+
+	const std::size_t sizes[] = {4, 8, 16, 32, 64, 128};
+	for (std::size_t n : sizes)
+	{
+		const SymMatrix P = random_PD (n);
+		RowMatrix M(n,n), X(n,n), XStemp(n,n), B(n,n), UD(P), C(n,n);
+		random (X);
+		random (B);
+		SymMatrix PI(n,n), XSX(n,n);
+		UdUfactor (UD, n);
+
+		report ("UdUfactor", n, [&] { M = P.asRowMatrix(); UdUfactor_variant2 (M, n); });
+		report ("UdUinverse", n, [&] { M = UD; UdUinverse (M); });
+		report ("UdUrecompose_transpose", n, [&] { M = UD; UdUrecompose_transpose (M); });
+		report ("UdUinversePD", n, [&] { UdUinversePD (PI, P); });
+		report ("UdUsolve_right", n, [&] { C = B; UdUsolve_right (UD, C); });
+		report ("assign_prod_SPD", n, [&] { assign_prod_SPD (XSX, X, P, XStemp); });
+		report ("assign_prod", n, [&] { assign_prod (C, X, B); });
+
+		const std::size_t z_size = n/2;
+		Covariance_scheme f(n, z_size);
+		Observe h(n, z_size);
+		Vec x(n), z(z_size);
+		x.clear();
+		z.clear();
+		report ("Covariance observe", n, [&] { f.init_kalman (x, P); f.observe (h, z); });
+	}
+	return 0;
+}
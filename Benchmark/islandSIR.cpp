@@ -0,0 +1,111 @@
+/*
+ * Bayes++ the Bayesian Filtering Library
+ * Copyright (c) 2002 Michael Stevens
+ * See accompanying Bayes++.htm for terms and conditions of use.
+ *
+ * $Id$
+ */
+
+/*
+ * Benchmark of the scaling of Island_SIR_scheme resampling with the number of islands
+ *  The resampling update of a large sample set is timed for an increasing number of islands,
+ *  sequentially and concurrently with a random helper for each island. A single SIR_scheme is
+ *  the reference. The elapsed time of each update and the speedup over the reference are reported,
+ *  with the weighted mean to check the islands represent the same distribution.
+ */
+
+#include "BayesFilter/SIRFlt.hpp"
+#include "BayesFilter/monteCarlo.hpp"
+#include <boost/scoped_ptr.hpp>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+
+namespace
+{
+	using namespace Bayesian_filter;
+	using namespace Bayesian_filter_matrix;
+
+	const std::size_t NX = 2;
+	const std::size_t samples = 1000000;
+	const std::size_t updates = 10;
+
+	void init (Sample_filter& f, Monte_carlo_random& random)
+	{
+		for (std::size_t i = 0; i != f.S.size2(); ++i) {
+			f.S(0,i) = random.normal();
+			f.S(1,i) = random.normal();
+		}
+	}
+
+	void likelihood (const Sample_filter& f, FM::Vec& lw)
+	// Gaussian likelihood of the first state at 0.5
+	{
+		for (std::size_t i = 0; i != f.S.size2(); ++i) {
+			const Float d = f.S(0,i) - 0.5;
+			lw[i] = std::exp(-d*d);
+		}
+	}
+
+	template <class Scheme>
+	double time_updates (Scheme& f)
+	// Elapsed seconds of each resampling update
+	{
+		Vec lw(f.S.size2());
+		double elapsed = 0;
+		for (std::size_t u = 0; u != updates; ++u) {
+			likelihood (f, lw);
+			f.observe_likelihood (lw);
+			const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			f.update_resample (Systematic_resampler());
+			elapsed += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		}
+		return elapsed / updates;
+	}
+}//namespace
+
+
+int main ()
+{
+	Monte_carlo_random random(0, 0);
+	double reference;
+	{
+		SIR_scheme f(NX, samples, random);
+		init (f, random);
+		f.init_S ();
+		reference = time_updates (f);
+		Float mean = 0;
+		for (std::size_t i = 0; i != samples; ++i)
+			mean += f.S(0,i) / samples;
+		std::cout << "SIR_scheme  samples " << samples << "  update s " << reference << "  mean " << mean << std::endl;
+	}
+
+	std::cout << "islands  concurrent  update s  speedup  mean" << std::endl;
+	const std::size_t island_counts[] = {1, 2, 4, 8, 16};
+	for (std::size_t ii = 0; ii != sizeof(island_counts)/sizeof(island_counts[0]); ++ii) {
+		const std::size_t K = island_counts[ii];
+		std::vector<boost::shared_ptr<Monte_carlo_random> > helpers;
+		std::vector<SIR_random*> island_random;
+		for (std::size_t k = 0; k != K; ++k) {
+			helpers.push_back (boost::shared_ptr<Monte_carlo_random>(new Monte_carlo_random(0, k+1)));
+			island_random.push_back (helpers.back().get());
+		}
+		for (int concurrent = 0; concurrent != 2; ++concurrent) {
+			Island_SIR_scheme f(NX, samples, K, random);
+			if (concurrent)
+				f.parallel (island_random);
+			init (f, random);
+			f.init_S ();
+			const double t = time_updates (f);
+			Float mean = 0, wsum = 0;
+			for (std::size_t i = 0; i != samples; ++i) {
+				mean += f.weights()[i] * f.S(0,i);
+				wsum += f.weights()[i];
+			}
+			std::cout << std::left << std::setw(9) << K << std::setw(12) << (concurrent ? "yes" : "no")
+				<< std::setw(10) << t << std::setw(9) << reference / t << mean / wsum << std::endl;
+		}
+	}
+	return 0;
+}
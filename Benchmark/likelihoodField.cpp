@@ -0,0 +1,73 @@
+/*
+ * Bayes++ the Bayesian Filtering Library
+ * Copyright (c) 2002 Michael Stevens
+ * See accompanying Bayes++.htm for terms and conditions of use.
+ *
+ * $Id$
+ */
+
+/*
+ * Benchmark of Likelihood_field_observe_model against analytic evaluation
+ *  The likelihood of a range observation is evaluated for all the samples of a SIR filter, by
+ *  table lookup with Ls and by the analytic form. The time of each observation and the largest
+ *  difference between them are reported. Lz, which interpolates the table at the range, is included.
+ */
+
+#include "BayesFilter/monteCarlo.hpp"
+#include "BayesFilter/models.hpp"
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+using namespace Bayesian_filter;
+using namespace Bayesian_filter_matrix;
+
+
+int main ()
+{
+	const std::size_t samples = 1000000;
+	const std::size_t observations = 20;
+	const Likelihood_field_observe_model::Grid grid = {-10, -10, 0, 0.05, 0.02, 401, 401, 800};
+	Likelihood_field_observe_model h(0, 1, 1.0, 2.0, 1.5, 0.04, grid);
+
+	Monte_carlo_random random(0, 0);
+	ColMatrix S(2, samples);
+	for (std::size_t i = 0; i != samples; ++i) {
+		S(0,i) = 9 * (2*random.uniform_01() - 1);
+		S(1,i) = 9 * (2*random.uniform_01() - 1);
+	}
+	Vec z(1), l(samples);
+	z[0] = 5.3;
+	h.Lz (z);				// Compute the table before timing
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (std::size_t o = 0; o != observations; ++o) {
+		z[0] = 4 + 3 * Float(o) / observations;
+		h.Lz (z);
+		h.Ls (S, l);
+	}
+	const double table = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	Float err = 0, lmax = 0;
+	start = std::chrono::steady_clock::now();
+	for (std::size_t o = 0; o != observations; ++o) {
+		z[0] = 4 + 3 * Float(o) / observations;
+		h.Lz (z);
+		for (std::size_t i = 0; i != samples; ++i)
+			l[i] = h.L_analytic (S(0,i), S(1,i));
+	}
+	const double analytic = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	Vec lt(samples);
+	h.Ls (S, lt);
+	for (std::size_t i = 0; i != samples; ++i) {
+		err = std::max(err, std::abs(lt[i] - l[i]));
+		lmax = std::max(lmax, l[i]);
+	}
+
+	std::cout << "samples " << samples << std::endl;
+	std::cout << "table    s " << table / observations << std::endl;
+	std::cout << "analytic s " << analytic / observations << std::endl;
+	std::cout << "speedup    " << analytic / table << std::endl;
+	std::cout << "max error  " << err << " of max L " << lmax << std::endl;
+	return 0;
+}
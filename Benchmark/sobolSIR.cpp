@@ -0,0 +1,152 @@
+/*
+ * Bayes++ the Bayesian Filtering Library
+ * Copyright (c) 2002 Michael Stevens
+ * See accompanying Bayes++.htm for terms and conditions of use.
+ *
+ * $Id$
+ */
+
+/*
+ * Benchmark of the accuracy per CPU second of SIR random helpers
+ *  A Position Velocity SIR filter with a Position observation is run for many Monte Carlo trials with
+ *  pseudo-random (Mersenne twister) and randomised quasi-Monte Carlo (Sobol_SIR_random) helpers,
+ *  for a range of sample sizes. The position RMSE and the CPU time are reported.
+ *  The product RMSE^2 * CPU seconds is the cost of a given accuracy, smaller is better.
+ *  The scheme and the predict model each have their own helper, as required by Sobol_SIR_random.
+ */
+
+#include "BayesFilter/SIRFlt.hpp"
+#include "BayesFilter/models.hpp"
+#include "BayesFilter/monteCarlo.hpp"
+#include <boost/scoped_ptr.hpp>
+#include <atomic>
+#include <cmath>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+
+namespace
+{
+	using namespace Bayesian_filter;
+	using namespace Bayesian_filter_matrix;
+
+	const std::size_t NX = 2;		// Position, Velocity
+	const Float dt = 0.1;
+	const Float V_NOISE = 0.2;		// Velocity noise std. dev. per step
+	const Float OBS_NOISE = 0.5;	// Position observation noise std. dev.
+	const Float i_P_NOISE = 1.;
+	const Float i_V_NOISE = 0.5;
+	const std::size_t steps = 40;
+
+	class PVpredict : public Sampled_LiInAd_predict_model
+	{
+	public:
+		PVpredict (SIR_random& random) : Sampled_LiInAd_predict_model(NX, 1, random)
+		{
+			Fx(0,0) = 1.; Fx(0,1) = dt;
+			Fx(1,0) = 0.; Fx(1,1) = 1.;
+			q[0] = V_NOISE*V_NOISE;
+			G(0,0) = dt/2; G(1,0) = 1.;
+		}
+	};
+
+	class PVobserve : public General_LiUnAd_observe_model
+	{
+		mutable Vec z_pred;
+	public:
+		PVobserve () : General_LiUnAd_observe_model(NX,1), z_pred(1)
+		{
+			Hx(0,0) = 1.; Hx(0,1) = 0.;
+			Zv[0] = OBS_NOISE*OBS_NOISE;
+		}
+		const Vec& h (const Vec& x) const
+		{
+			z_pred[0] = x[0];
+			return z_pred;
+		}
+	};
+
+	SIR_random* make_random (bool sobol, unsigned trial, unsigned consumer)
+	{
+		if (sobol)
+			return new Sobol_SIR_random(trial, consumer);
+		return new Monte_carlo_random(trial, std::uint64_t(consumer) << 32);
+	}
+
+	class PV_trial : public Monte_carlo_trial
+	{
+	public:
+		PV_trial (bool sobol, std::size_t samples, unsigned trial) :
+			Monte_carlo_trial(NX),
+			scheme_random(make_random(sobol, trial, 1)), predict_random(make_random(sobol, trial, 2)),
+			predict(*predict_random), filter(NX, samples, *scheme_random), z(1)
+		{}
+		void init (Monte_carlo_random& random)
+		{
+			x[0] = i_P_NOISE * random.normal();
+			x[1] = i_V_NOISE * random.normal();
+			Vec x_init(NX); x_init.clear();
+			SymMatrix X_init(NX,NX); X_init.clear();
+			X_init(0,0) = i_P_NOISE*i_P_NOISE;
+			X_init(1,1) = i_V_NOISE*i_V_NOISE;
+			filter.init_kalman (x_init, X_init);
+		}
+		void truth (Monte_carlo_random& random)
+		{
+			const Float w = V_NOISE * random.normal();
+			x[0] += dt * x[1] + dt/2 * w;
+			x[1] += w;
+		}
+		void sensor (Monte_carlo_random& random)
+		{
+			filter.predict (predict);
+			z[0] = x[0] + OBS_NOISE * random.normal();
+			filter.observe (observe, z);
+		}
+		Kalman_state_filter& scheme ()
+		{
+			return filter;
+		}
+	private:
+		boost::scoped_ptr<SIR_random> scheme_random, predict_random;
+		PVpredict predict;
+		PVobserve observe;
+		SIR_kalman_scheme filter;
+		Vec z;
+	};
+
+	struct Factory
+	{
+		Factory (bool sobol, std::size_t samples) : sobol(sobol), samples(samples), next(new std::atomic<unsigned>(0))
+		{}
+		Monte_carlo_trial* operator() () const
+		{
+			return new PV_trial(sobol, samples, (*next)++);
+		}
+		bool sobol;
+		std::size_t samples;
+		boost::shared_ptr<std::atomic<unsigned> > next;	// Trial number, shared by copies
+	};
+}//namespace
+
+
+int main ()
+{
+	const std::size_t trials = 200;
+	std::cout << "helper      samples  RMSE      CPU s    RMSE^2*CPU" << std::endl;
+	const std::size_t sample_sizes[] = {100, 400, 1600};
+	for (std::size_t si = 0; si != sizeof(sample_sizes)/sizeof(sample_sizes[0]); ++si) {
+		for (int sobol = 0; sobol != 2; ++sobol) {
+			Monte_carlo_runner runner(NX, steps, 1);
+			const std::clock_t start = std::clock();
+			runner.run (Factory(sobol != 0, sample_sizes[si]), trials);
+			const double cpu = double(std::clock() - start) / CLOCKS_PER_SEC;
+			Float mse = 0;
+			for (std::size_t k = 0; k != steps; ++k)
+				mse += runner.statistics[k].error_sq[0].mean / steps;
+			std::cout << std::left << std::setw(12) << (sobol ? "Sobol" : "Mersenne") << std::setw(9) << sample_sizes[si]
+				<< std::setw(10) << std::sqrt(mse) << std::setw(9) << cpu << mse * cpu << std::endl;
+		}
+	}
+	return 0;
+}
@@ -47,8 +47,15 @@ void mexFunction(
 		Run_Filter::check_def(f);
 
 		// Update and get state
-		f->update();
-		plhs[0] = Array(f->x);
+		Bayesian_filter::SIR_kalman_scheme* sf = dynamic_cast<Bayesian_filter::SIR_kalman_scheme*>(filter);
+		if (sf) {	// Only the sample mean is required
+			sf->update_resample();
+			plhs[0] = Array(sf->sample_x());
+		}
+		else {
+			f->update();
+			plhs[0] = Array(f->x);
+		}
 	}
 	catch (std::exception& se)
 	{
@@ -16,6 +16,7 @@
 #include "BayesFilter/SIRFlt.hpp"
 		// Types required for SLAM classes
 #include <map>
+#include <utility>
 		// Bayes++ SLAM
 #include "SLAM.hpp"
 #include "fastSLAM.hpp"
@@ -67,11 +68,10 @@ void Fast_SLAM::observe_new( unsigned feature, const Feature_observe_inverse& fo
 	{
 		sz.sub_range(0,nL) = FM::column (L.S, pi);
 		sz[nL] = z[0];
-		FM::Vec t = fom.h(sz);
-		fmap[pi].x = t[0];
+		fmap[pi].x = fom.h(sz)[0];
 		fmap[pi].X = fom.Zv[0];
 	}
-	M.insert (std::make_pair(feature, fmap));
+	M.insert (std::make_pair(feature, std::move(fmap)));
 }
 
 void Fast_SLAM::observe_new( unsigned feature, const FM::Float& t, const FM::Float& T )
@@ -86,7 +86,7 @@ void Fast_SLAM::observe_new( unsigned feature, const FM::Float& t, const FM::Flo
 	m1.x = t;			// Initial particle conditional map is sample
 	m1.X = T;		    // Independent
 	std::fill(fmap.begin(),fmap.end(), m1);
-	M.insert (std::make_pair(feature, fmap));
+	M.insert (std::make_pair(feature, std::move(fmap)));
 }
 
 void Fast_SLAM::observe( unsigned feature, const Feature_observe& fom, const FM::Vec& z )
@@ -182,7 +182,7 @@ Fast_SLAM::Float
 					++fmri;
 				}
 			}
-			fm = fmr;				// Copy in resamples feature map
+			fm.swap (fmr);			// Exchange with resampled feature map, fmr is entirely overwritten for the next feature
 		}
 
 		L.roughen ();				// Roughen location
@@ -358,9 +358,8 @@ void Fast_SLAM_Kstatistics::statistics_compressed( BF::Kalman_state_filter& ksta
 								// Get Location statistics
 	if (nL > kstat.x.size())
 		error (BF::Logic_exception("kstat to small to hold filter location statistics"));
-	L.update_statistics();
-	FM::noalias(kstat.x.sub_range(0,nL)) = L.x;
-	FM::noalias(kstat.X.sub_matrix(0,nL, 0,nL)) = L.X;
+	FM::noalias(kstat.X.sub_matrix(0,nL, 0,nL)) = L.sample_X();	// Statistics computed if required
+	FM::noalias(kstat.x.sub_range(0,nL)) = L.sample_x();
 
 								// Iterated over feature statistics (that there is space for in kstat)
 	std::size_t fs = nL;						// Feature subscript
@@ -393,9 +392,8 @@ void Fast_SLAM_Kstatistics::statistics_sparse( BF::Kalman_state_filter& kstat )
 								// Get Location statistics
 	if (nL > kstat.x.size())
 		error (BF::Logic_exception("kstat to small to hold filter location statistics"));
-	L.update_statistics();
-	FM::noalias(kstat.x.sub_range(0,nL)) = L.x;
-	FM::noalias(kstat.X.sub_matrix(0,nL, 0,nL)) = L.X;
+	FM::noalias(kstat.X.sub_matrix(0,nL, 0,nL)) = L.sample_X();	// Statistics computed if required
+	FM::noalias(kstat.x.sub_range(0,nL)) = L.sample_x();
 
 								// Iterated over feature statistics (that there is space for in kstat)
 	for (AllFeature::const_iterator fi = M.begin(); fi != M.end(); ++fi)
@@ -57,23 +57,23 @@ void Kalman_SLAM::init_kalman (const FM::Vec& x, const FM::SymMatrix& X)
 		// generate full filter
 	full = fgenerator.generate(nL);
 		// initialise location states
-	full->x.sub_range(0,nL) = x;
-	full->X.sub_matrix(0,nL,0,nL) = X;
+	FM::noalias(full->x.sub_range(0,nL)) = x;
+	FM::noalias(full->X.sub_matrix(0,nL,0,nL)) = X;
 	full->init();
 }
 
 void Kalman_SLAM::predict( BF::Linrz_predict_model& lpred )
 {
-		// extract location part of full
-	loc->x = full->x.sub_range(0,nL);
-	loc->X = full->X.sub_matrix(0,nL,0,nL);
+		// extract location part of full, without temporaries as loc and full are distinct
+	FM::noalias(loc->x) = full->x.sub_range(0,nL);
+	FM::noalias(loc->X) = full->X.sub_matrix(0,nL,0,nL);
 		// predict location, independent of map
 	loc->init();
 	loc->predict (lpred);
 	loc->update();
 		// return location to full
-	full->x.sub_range(0,nL) = loc->x;
-	full->X.sub_matrix(0,nL,0,nL) = loc->X;
+	FM::noalias(full->x.sub_range(0,nL)) = loc->x;
+	FM::noalias(full->X.sub_matrix(0,nL,0,nL)) = loc->X;
 	full->init();
 }
 
@@ -88,7 +88,7 @@ void Kalman_SLAM::observe( unsigned feature, const Feature_observe& fom, const F
 	// Create a augmented sparse observe model for full states
 	BF::Linear_uncorrelated_observe_model fullm(full->x.size(), 1);
 	fullm.Hx.clear();
-	fullm.Hx.sub_matrix(0,nL, 0,nL) = fom.Hx.sub_matrix(0,nL, 0,nL);
+	FM::noalias(fullm.Hx.sub_matrix(0,nL, 0,nL)) = fom.Hx.sub_matrix(0,nL, 0,nL);
 	fullm.Hx(0,nL+feature) = fom.Hx(0,nL);
 	fullm.Zv = fom.Zv;
 	full->observe(fullm, z);
@@ -114,8 +114,8 @@ void Kalman_SLAM::observe_new( unsigned feature, const Feature_observe_inverse&
 	}
 		// build augmented location and observation
 	FM::Vec sz(nL+z.size());
-	sz.sub_range(0,nL) = full->x.sub_range(0,nL);
-	sz.sub_range(nL,nL+z.size() )= z;
+	FM::noalias(sz.sub_range(0,nL)) = full->x.sub_range(0,nL);
+	FM::noalias(sz.sub_range(nL,nL+z.size())) = z;
 
 	// TODO use named references rather then explict Ha Hb
 	FM::Matrix Ha (fom.Hx.sub_matrix(0,1, 0,nL) );
@@ -127,6 +127,7 @@ void Kalman_SLAM::observe_new( unsigned feature, const Feature_observe_inverse&
         // X+ = [0 Ha] X [0 Ha]' + Hb Z Hb'
         // - zero existing feature covariance
 	zero( full->X.sub_matrix(0,full->X.size1(), nL+feature,nL+feature+1) );
+		// not noalias: through the symmetry of X the source includes the feature row being assigned
 	full->X.sub_matrix(nL+feature,nL+feature+1,0,nL+nM) = FM::prod(Ha,full->X.sub_matrix(0,nL, 0,nL+nM) );
 		// feature state and variance
 	full->x[nL+feature] = fom.h(sz)[0];
@@ -0,0 +1,54 @@
+/*
+ * Bayes++ the Bayesian Filtering Library
+ * Copyright (c) 2002 Michael Stevens
+ * See accompanying Bayes++.htm for terms and conditions of use.
+ *
+ * $Id$
+ */
+
+/*
+ * Allocation counting
+ *  Replaces the global operator new and delete, including the aligned forms used by BAYES_FILTER_ALIGNED
+ *  storage, counting each allocation.
+ *  Defined apart from the tests so the replacements are not inlined where new and delete are paired.
+ */
+
+#include <cstdlib>
+#include <new>
+
+long allocations = 0;
+
+void* operator new (std::size_t n)
+{
+	++allocations;
+	void* p = std::malloc(n ? n : 1);
+	if (p == 0)
+		throw std::bad_alloc();
+	return p;
+}
+void operator delete (void* p) noexcept
+{
+	std::free(p);
+}
+void operator delete (void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+void* operator new (std::size_t n, std::align_val_t al)
+{
+	++allocations;
+	const std::size_t a = std::size_t(al);
+	void* p = std::aligned_alloc(a, n ? (n + a - 1) / a * a : a);		// Size must be a multiple of the alignment
+	if (p == 0)
+		throw std::bad_alloc();
+	return p;
+}
+void operator delete (void* p, std::align_val_t) noexcept
+{
+	std::free(p);
+}
+void operator delete (void* p, std::size_t, std::align_val_t) noexcept
+{
+	std::free(p);
+}
@@ -0,0 +1,286 @@
+/*
+ * Bayes++ the Bayesian Filtering Library
+ * Copyright (c) 2002 Michael Stevens
+ * See accompanying Bayes++.htm for terms and conditions of use.
+ *
+ * $Id$
+ */
+
+/*
+ * Test aligned storage
+ *  With BAYES_FILTER_ALIGNED the storage of each dense type must start on a BAYES_FILTER_ALIGNMENT boundary,
+ *  after construction, resize and copy. A filter is run to check the aligned types work with a scheme.
+ *  Each vectorised kernel is computed with aligned_dispatch_size set so every operation is dispatched,
+ *  and again so none are, and the results compared.
+ *  Without BAYES_FILTER_ALIGNED the filter is run and uBLAS is compared with uBLAS.
+ */
+
+#include "BayesFilter/covFlt.hpp"
+#include "BayesFilter/matSup.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <random>
+
+using namespace Bayesian_filter;
+using namespace Bayesian_filter_matrix;
+
+namespace
+{
+	int failures = 0;
+
+	void check (bool ok, const char* what)
+	{
+		if (!ok) {
+			std::cout << "FAILED: " << what << std::endl;
+			++failures;
+		}
+	}
+
+#ifdef BAYES_FILTER_ALIGNED
+	bool aligned (const Float* p)
+	{
+		return reinterpret_cast<std::uintptr_t>(p) % BAYES_FILTER_ALIGNMENT == 0;
+	}
+
+	void alignment ()
+	{
+		for (std::size_t n = 1; n != 10; ++n) {
+			Vec v(n);
+			check (aligned(&v[0]), "Vec");
+			RowMatrix r(n,n+1);
+			check (aligned(&r(0,0)), "RowMatrix");
+			ColMatrix c(n+1,n);
+			check (aligned(&c(0,0)), "ColMatrix");
+			SymMatrix s(n,n);
+			check (aligned(&s(0,0)), "SymMatrix");
+			UTriMatrix u(n,n);
+			check (aligned(&u(0,0)), "UTriMatrix");
+			r.resize (n+3,n+2, false);
+			check (aligned(&r(0,0)), "RowMatrix resize");
+			Vec w(v);
+			check (aligned(&w[0]), "Vec copy");
+		}
+		std::cout << "Aligned to " << BAYES_FILTER_ALIGNMENT << " bytes" << std::endl;
+	}
+#endif
+
+	class Predict : public Linear_predict_model
+	{
+	public:
+		Predict () : Linear_predict_model(2, 1)
+		{
+			Fx(0,0) = 1; Fx(0,1) = 1;
+			Fx(1,0) = 0; Fx(1,1) = 1;
+			G(0,0) = 0.5; G(1,0) = 1;
+			q[0] = 0.01;
+		}
+	};
+
+	class Observe : public Linear_uncorrelated_observe_model
+	{
+	public:
+		Observe () : Linear_uncorrelated_observe_model(2, 1)
+		{
+			Hx(0,0) = 1; Hx(0,1) = 0;
+			Zv[0] = 1;
+		}
+	};
+
+	void filter ()
+	/* Constant velocity target observed without noise: the estimate converges to the truth
+	 */
+	{
+		Covariance_scheme f(2, 1);
+		f.x.clear();
+		f.X.clear();
+		f.X(0,0) = f.X(1,1) = 100;
+		f.init ();
+		Predict predict;
+		Observe observe;
+		Vec z(1);
+		for (int k = 1; k != 50; ++k) {
+			f.predict (predict);
+			z[0] = 2. * k;
+			f.observe (observe, z);
+		}
+		f.update ();
+		std::cout << "Velocity estimate " << f.x[1] << std::endl;
+		check (std::abs(f.x[1] - 2) < 0.05, "filter velocity");
+	}
+
+	const std::size_t N = 13;
+	const Float tolerance = 1e-10;
+
+	std::mt19937 rng (7);
+
+	void random (RowMatrix& M)
+	{
+		std::normal_distribution<Float> normal;
+		for (std::size_t r = 0; r != M.size1(); ++r)
+			for (std::size_t c = 0; c != M.size2(); ++c)
+				M(r,c) = normal(rng);
+	}
+
+	SymMatrix random_PD (std::size_t n)
+	// Random Positive Definite matrix
+	{
+		RowMatrix A(n,n);
+		random (A);
+		SymMatrix P(n,n);
+		P = prod(A, trans(A));
+		return P;
+	}
+
+	Float difference (const RowMatrix& A, const RowMatrix& B)
+	// Largest difference relative to the elements of B
+	{
+		Float d = 0;
+		for (std::size_t r = 0; r != A.size1(); ++r)
+			for (std::size_t c = 0; c != A.size2(); ++c)
+				d = std::max (d, std::fabs(A(r,c) - B(r,c)) / (std::fabs(B(r,c)) + 1));
+		return d;
+	}
+
+	Float difference (const SymMatrix& A, const SymMatrix& B)
+	// Largest difference of the upper triangles relative to the elements of B
+	{
+		Float d = 0;
+		for (std::size_t r = 0; r != A.size1(); ++r)
+			for (std::size_t c = r; c != A.size2(); ++c)
+				d = std::max (d, std::fabs(A(r,c) - B(r,c)) / (std::fabs(B(r,c)) + 1));
+		return d;
+	}
+
+	void dispatch (bool vectorised)
+	{
+		aligned_dispatch_size = vectorised ? 1 : std::numeric_limits<std::size_t>::max();
+	}
+
+	void factor ()
+	/* UdUfactor_variant2, the factor and rcond agree. Semi-definite and negative rcond are as uBLAS
+	 */
+	{
+		const SymMatrix P = random_PD (N);
+		RowMatrix V(P), U(P);
+		dispatch (true);
+		const Float vrcond = UdUfactor_variant2 (V, N);
+		dispatch (false);
+		const Float urcond = UdUfactor_variant2 (U, N);
+		const Float d = difference (V, U);
+		std::cout << "UdUfactor difference " << d << " rcond " << vrcond << ' ' << urcond << std::endl;
+		check (d < tolerance, "UdUfactor factor");
+		check (std::fabs(vrcond - urcond) <= tolerance * urcond, "UdUfactor rcond");
+
+		SymMatrix Z = random_PD (N);
+		for (std::size_t i = 0; i != N; ++i)
+			Z(N/2,i) = 0;
+		RowMatrix S(Z), Neg(-P);
+		dispatch (true);
+		check (UdUfactor_variant2 (S, N) == 0, "UdUfactor semi-definite rcond");
+		check (UdUfactor_variant2 (Neg, N) < 0, "UdUfactor negative rcond");
+	}
+
+	void inverse ()
+	/* UdUinversePD, by UdUinverse and UdUrecompose_transpose. The inverse and determinant agree
+	 */
+	{
+		const SymMatrix P = random_PD (N);
+		SymMatrix V(N,N), U(N,N);
+		Float vdet, udet;
+		dispatch (true);
+		const Float vrcond = UdUinversePD (V, vdet, P);
+		dispatch (false);
+		const Float urcond = UdUinversePD (U, udet, P);
+		const Float d = difference (V.asRowMatrix(), U.asRowMatrix());		// Both triangles are recomposed
+		std::cout << "UdUinversePD difference " << d << std::endl;
+		check (d < tolerance, "UdUinversePD inverse");
+		check (std::fabs(vrcond - urcond) <= tolerance * urcond, "UdUinversePD rcond");
+		check (std::fabs(vdet - udet) <= tolerance * udet, "UdUinversePD determinant");
+	}
+
+	void solve ()
+	/* UdUsolve_right
+	 */
+	{
+		RowMatrix UD(random_PD (N));
+		UdUfactor (UD, N);
+		RowMatrix B(3,N);
+		random (B);
+		RowMatrix V(B), U(B);
+		dispatch (true);
+		UdUsolve_right (UD, V);
+		dispatch (false);
+		UdUsolve_right (UD, U);
+		const Float d = difference (V, U);
+		std::cout << "UdUsolve_right difference " << d << std::endl;
+		check (d < tolerance, "UdUsolve_right");
+	}
+
+	void products ()
+	/* assign_prod_SPD, minus_assign_prod_SPD, assign_prod and assign_prod_trans
+	 */
+	{
+		const SymMatrix S = random_PD (N);
+		RowMatrix X(N-3,N), XStemp(N-3,N);
+		random (X);
+		SymMatrix V(N-3,N-3), U(N-3,N-3);
+		dispatch (true);
+		assign_prod_SPD (V, X, S, XStemp);
+		dispatch (false);
+		assign_prod_SPD (U, X, S, XStemp);
+		Float d = difference (V, U);
+		std::cout << "assign_prod_SPD difference " << d << std::endl;
+		check (d < tolerance, "assign_prod_SPD");
+
+		V = U;
+		V *= 3; U *= 3;
+		dispatch (true);
+		minus_assign_prod_SPD (V, X, S, XStemp);
+		dispatch (false);
+		minus_assign_prod_SPD (U, X, S, XStemp);
+		d = difference (V, U);
+		std::cout << "minus_assign_prod_SPD difference " << d << std::endl;
+		check (d < tolerance, "minus_assign_prod_SPD");
+
+		RowMatrix SXT_V(N,N-3), SXT_U(N,N-3);
+		dispatch (true);
+		assign_prod_trans (SXT_V, S, X);
+		assign_prod (V, X, SXT_V);
+		dispatch (false);
+		assign_prod_trans (SXT_U, S, X);
+		assign_prod (U, X, SXT_U);
+		d = std::max (difference (SXT_V, SXT_U), difference (V, U));
+		std::cout << "assign_prod_trans and symmetric assign_prod difference " << d << std::endl;
+		check (d < tolerance, "assign_prod_trans and symmetric assign_prod");
+
+		RowMatrix A(N-3,N+2), B(N+2,N-1), PV(N-3,N-1), PU(N-3,N-1);
+		random (A);
+		random (B);
+		dispatch (true);
+		assign_prod (PV, A, B);
+		dispatch (false);
+		assign_prod (PU, A, B);
+		d = difference (PV, PU);
+		std::cout << "assign_prod difference " << d << std::endl;
+		check (d < tolerance, "assign_prod");
+	}
+}//namespace
+
+
+int main ()
+{
+#ifdef BAYES_FILTER_ALIGNED
+	alignment ();
+#else
+	std::cout << "BAYES_FILTER_ALIGNED not defined" << std::endl;
+#endif
+	filter ();
+	factor ();
+	inverse ();
+	solve ();
+	products ();
+	return failures == 0 ? 0 : 1;
+}
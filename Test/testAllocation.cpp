@@ -0,0 +1,219 @@
+/*
+ * Bayes++ the Bayesian Filtering Library
+ * Copyright (c) 2002 Michael Stevens
+ * See accompanying Bayes++.htm for terms and conditions of use.
+ *
+ * $Id$
+ */
+
+/*
+ * Test storage reuse
+ *  Counts the allocations made by Size_cache and by moving and assigning matrices, and checks the
+ *  observation sized storage of the schemes is reused, rather then reallocated, when observations
+ *  alternate between sizes.
+ *  Storage is compared by address so the test is independent of uBLAS debug checks.
+ */
+
+#include "BayesFilter/allFilters.hpp"
+#include <iostream>
+
+extern long allocations;		// Counted by allocationCount.cpp
+
+
+using namespace Bayesian_filter;
+using namespace Bayesian_filter_matrix;
+
+namespace
+{
+	int failures = 0;
+
+	void check (bool ok, const char* what)
+	{
+		if (!ok) {
+			std::cout << "FAILED: " << what << std::endl;
+			++failures;
+		}
+	}
+
+	const std::size_t NX = 4;
+
+	class Predict : public Linear_predict_model
+	{
+	public:
+		Predict () : Linear_predict_model(NX, NX)
+		{
+			Fx.clear(); G.clear();
+			for (std::size_t i = 0; i != NX; ++i) {
+				Fx(i,i) = 1; G(i,i) = 1; q[i] = 1;
+			}
+		}
+	};
+
+	class Observe : public Linear_correlated_observe_model
+	{
+	public:
+		Observe (std::size_t z_size) : Linear_correlated_observe_model(NX, z_size)
+		{
+			Hx.clear(); Z.clear();
+			for (std::size_t i = 0; i != z_size; ++i) {
+				Hx(i,i) = 1; Z(i,i) = 1;
+			}
+		}
+	};
+
+	template <class Scheme>
+	class Storage : public Scheme
+	// Expose the address of observation sized storage
+	{
+	public:
+		Storage () : Kalman_state_filter(NX), Scheme(NX)
+		{}
+		std::vector<const void*> storage () const;
+	};
+
+	template <>
+	std::vector<const void*> Storage<Covariance_scheme>::storage () const
+	{
+		const void* p[] = {&S(0,0), &SUD(0,0), &W(0,0), &tempXZ(0,0)};
+		return std::vector<const void*>(p, p + sizeof(p)/sizeof(p[0]));
+	}
+	template <>
+	std::vector<const void*> Storage<Unscented_scheme>::storage () const
+	{
+		const void* p[] = {&S(0,0), &SUD(0,0), &s[0], &zXX(0,0), &zp[0], &W(0,0), &WStemp(0,0)};
+		return std::vector<const void*>(p, p + sizeof(p)/sizeof(p[0]));
+	}
+	template <>
+	std::vector<const void*> Storage<CI_scheme>::storage () const
+	{
+		const void* p[] = {&S(0,0), &SUD(0,0), &ZUD(0,0), &tempXZ(0,0)};
+		return std::vector<const void*>(p, p + sizeof(p)/sizeof(p[0]));
+	}
+
+	template <class Scheme>
+	void alternating_observe (const char* name)
+	/* Storage for each observation size is reused once each size has been observed
+	 */
+	{
+		Storage<Scheme> f;
+		f.x.clear(); f.X.clear();
+		for (std::size_t i = 0; i != NX; ++i)
+			f.X(i,i) = 1;
+		f.init();
+		Predict predict;
+		Observe h1(1), h2(2);
+		Vec z1(1), z2(2);
+		z1.clear(); z2.clear();
+
+		f.predict (predict); f.observe (h1, z1);
+		f.predict (predict); f.observe (h2, z2);
+		const std::vector<const void*> first1 = (f.observe (h1, z1), f.storage());
+		const std::vector<const void*> first2 = (f.observe (h2, z2), f.storage());
+		bool reused = true;
+		for (int k = 0; k != 4; ++k) {
+			f.predict (predict);
+			f.observe (h1, z1);
+			reused = reused && f.storage() == first1;
+			f.observe (h2, z2);
+			reused = reused && f.storage() == first2;
+		}
+		f.update();
+		std::cout << name << " observation storage reused: " << reused << std::endl;
+		check (reused, name);
+	}
+
+	void size_cache ()
+	/* Size_cache only allocates for sizes which are not retained
+	 */
+	{
+		Size_cache<Matrix> cache;
+		Matrix m(3,3);
+		cache.exchange (m, 5,5);
+		cache.exchange (m, 3,3);
+		const long before = allocations;
+		for (int k = 0; k != 10; ++k) {
+			cache.exchange (m, 5,5);
+			cache.exchange (m, 3,3);
+		}
+		std::cout << "Size_cache alternating allocations: " << allocations - before << std::endl;
+		check (allocations == before, "Size_cache alternating sizes allocates");
+		cache.exchange (m, 7,7);
+		check (m.size1() == 7 && m.size2() == 7, "Size_cache new size");
+	}
+
+	Matrix identity (std::size_t n)
+	{
+		Matrix m(n,n);
+		m.clear();
+		for (std::size_t i = 0; i != n; ++i)
+			m(i,i) = 1;
+		return m;
+	}
+
+	void move_assign ()
+	/* Moving conformant vectors and matrices exchanges storage without allocation
+	 *  Conformant copy assignment reuses the storage of the target
+	 */
+	{
+		std::vector<Vec> vs;
+		vs.reserve (4);
+		Vec v(NX);
+		v.clear();
+		long before = allocations;
+		for (int k = 0; k != 4; ++k) {
+			Vec t(NX);
+			t.clear();
+			const Float* tp = &t[0];
+			const long made = allocations;
+			vs.push_back (std::move(t));
+			check (allocations == made && &vs.back()[0] == tp, "Vec move into vector allocates");
+		}
+		std::cout << "Vec construct and move into vector allocations: " << allocations - before << std::endl;
+
+		Matrix m(NX,NX), n(NX,NX);
+		m.clear(); n.clear();
+		const Float* mp = &m(0,0);
+		const Float* np = &n(0,0);
+		before = allocations;
+		m = std::move(n);
+		check (allocations == before, "Matrix move assignment allocates");
+		check (&m(0,0) == np && &n(0,0) == mp, "Matrix move assignment exchanges storage");
+
+		before = allocations;
+		m = identity (NX);
+		std::cout << "Matrix move assignment of temporary allocations: " << allocations - before << std::endl;
+		check (allocations - before == 1, "Matrix move assignment of temporary allocates");
+		check (m(0,0) == 1 && m(0,1) == 0, "Matrix move assignment value");
+
+		SymMatrix X(NX,NX), Y(NX,NX);
+		X.clear(); Y.clear();
+		Y(0,1) = 2;
+		const Float* yp = &Y(0,0);
+		before = allocations;
+		X = std::move(Y);
+		check (allocations == before, "SymMatrix move assignment allocates");
+		check (&X(0,0) == yp && X(1,0) == 2, "SymMatrix move assignment exchanges storage");
+
+	#ifdef NDEBUG		// uBLAS debug checks assign through temporaries
+		const Float* xp = &X(0,0);
+		before = allocations;
+		X = Y;
+		m = n;
+		v = vs[0];
+		std::cout << "Conformant copy assignment allocations: " << allocations - before << std::endl;
+		check (allocations == before, "conformant copy assignment allocates");
+		check (&X(0,0) == xp, "conformant copy assignment reuses storage");
+	#endif
+	}
+}//namespace
+
+
+int main ()
+{
+	size_cache ();
+	move_assign ();
+	alternating_observe<Covariance_scheme> ("Covariance_scheme");
+	alternating_observe<Unscented_scheme> ("Unscented_scheme");
+	alternating_observe<CI_scheme> ("CI_scheme");
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,165 @@
+/*
+ * Bayes++ the Bayesian Filtering Library
+ * Copyright (c) 2002 Michael Stevens
+ * See accompanying Bayes++.htm for terms and conditions of use.
+ *
+ * $Id$
+ */
+
+/*
+ * Test forward mode automatic differentiation
+ *  The Jacobians of the Autodiff_linrz models of a nonlinear function are compared with the analytic
+ *  Jacobian. The function has more states than the Dual size so columns are computed in several passes.
+ *  detect_sparsity must find the states the function structurally depends on, including a dependence
+ *  multiplied by zero, and leave the other columns zero.
+ *  The test is built without NDEBUG so the uBLAS expressions of the header only models are checked.
+ */
+
+#include "BayesFilter/bayesFlt.hpp"
+#include "BayesFilter/autoDiff.hpp"
+#include <cmath>
+#include <iostream>
+
+using namespace Bayesian_filter;
+using namespace Bayesian_filter_matrix;
+
+namespace
+{
+	int failures = 0;
+
+	void check (bool ok, const char* what)
+	{
+		if (!ok) {
+			std::cout << "FAILED: " << what << std::endl;
+			++failures;
+		}
+	}
+
+	const Float tolerance = 1e-14;
+
+	const std::size_t NX = 11;
+	const std::size_t NZ = 4;
+	const std::size_t depends[] = {0, 1, 2, 4, 5, 7, 10};		// States the function depends on
+
+	struct Function
+	{
+		template <class V>
+		void operator() (V& fx, const V& x) const
+		{	using std::sqrt; using std::atan2; using std::sin; using std::cos; using std::exp; using std::log;
+			fx[0] = sqrt(x[0]*x[0] + x[1]*x[1]);
+			fx[1] = atan2(x[1], x[0]);
+			fx[2] = x[5] * sin(x[2]) + exp(x[7]) / x[10];
+			fx[3] = Float(0) * x[4] + log(x[10]) * cos(x[7]);
+		}
+	};
+
+	void analytic (Matrix& J, const Vec& x)
+	{
+		const Float rr = x[0]*x[0] + x[1]*x[1], r = std::sqrt(rr);
+		J.clear();
+		J(0,0) = x[0] / r;
+		J(0,1) = x[1] / r;
+		J(1,0) = -x[1] / rr;
+		J(1,1) = x[0] / rr;
+		J(2,2) = x[5] * std::cos(x[2]);
+		J(2,5) = std::sin(x[2]);
+		J(2,7) = std::exp(x[7]) / x[10];
+		J(2,10) = -std::exp(x[7]) / (x[10]*x[10]);
+		J(3,4) = 0;
+		J(3,7) = -std::log(x[10]) * std::sin(x[7]);
+		J(3,10) = std::cos(x[7]) / x[10];
+	}
+
+	Float difference (const Matrix& A, const Matrix& B)
+	{
+		Float d = 0;
+		for (std::size_t r = 0; r != A.size1(); ++r)
+			for (std::size_t c = 0; c != A.size2(); ++c)
+				d = std::max (d, std::fabs(A(r,c) - B(r,c)) / (std::fabs(B(r,c)) + 1));
+		return d;
+	}
+
+	Vec point ()
+	{
+		Vec x(NX);
+		for (std::size_t i = 0; i != NX; ++i)
+			x[i] = 0.3 + 0.1 * Float(i);
+		return x;
+	}
+
+	template <class Model>
+	void observe (Model& h, const char* name)
+	/* Jacobian in chunks, then after sparsity detection
+	 */
+	{
+		std::cout << name << std::endl;
+		const Vec x = point();
+		Matrix J(NZ, NX);
+		analytic (J, x);
+
+		h.Hx(3,3) = 1;			// Must be cleared by linearise
+		h.linearise (x);
+		std::cout << "Jacobian difference " << difference (h.Hx, J) << " columns " << h.ad.active_size() << std::endl;
+		check (difference (h.Hx, J) < tolerance, "Jacobian");
+		check (h.ad.active_size() == NX, "all columns before detect_sparsity");
+
+		Vec fx(NZ);
+		Function() (fx, x);
+		check (norm_inf (h.h(x) - fx) < tolerance, "value at point of linearisation");
+		Vec x2(x);
+		x2[2] += 1;
+		Function() (fx, x2);
+		check (norm_inf (h.h(x2) - fx) < tolerance, "value elsewhere");
+
+		h.ad.detect_sparsity (x);
+		const std::size_t n_depends = sizeof(depends) / sizeof(depends[0]);
+		check (h.ad.active_size() == n_depends, "detect_sparsity columns");
+		h.Hx(3,3) = 1;
+		h.linearise (x);
+		std::cout << "Sparse Jacobian difference " << difference (h.Hx, J) << " columns " << h.ad.active_size() << std::endl;
+		check (difference (h.Hx, J) < tolerance, "sparse Jacobian");
+		Function() (fx, x);
+		check (norm_inf (h.h(x) - fx) < tolerance, "sparse value at point of linearisation");
+	}
+
+	struct Rotate
+	// Predict by a rotation of the first two states by the third
+	{
+		template <class V>
+		void operator() (V& fx, const V& x) const
+		{	using std::sin; using std::cos;
+			fx[0] = cos(x[2]) * x[0] - sin(x[2]) * x[1];
+			fx[1] = sin(x[2]) * x[0] + cos(x[2]) * x[1];
+			fx[2] = x[2];
+		}
+	};
+
+	void predict ()
+	/* Jacobian of a predict model with a Dual size of 2 so 2 passes are required
+	 */
+	{
+		Autodiff_linrz_predict_model<Rotate,2> f(3, 1);
+		Vec x(3);
+		x[0] = 2; x[1] = -1; x[2] = 0.7;
+		f.linearise (x);
+		const Float c = std::cos(x[2]), s = std::sin(x[2]);
+		Matrix J(3,3);
+		J(0,0) = c; J(0,1) = -s; J(0,2) = -s*x[0] - c*x[1];
+		J(1,0) = s; J(1,1) = c;  J(1,2) = c*x[0] - s*x[1];
+		J(2,0) = 0; J(2,1) = 0;  J(2,2) = 1;
+		std::cout << "Predict Jacobian difference " << difference (f.Fx, J) << std::endl;
+		check (difference (f.Fx, J) < tolerance, "predict Jacobian");
+		check (std::fabs(f.f(x)[0] - (c*x[0] - s*x[1])) < tolerance, "predict value");
+	}
+}//namespace
+
+
+int main ()
+{
+	Autodiff_linrz_uncorrelated_observe_model<Function,4> uncorrelated(NX, NZ);
+	observe (uncorrelated, "Uncorrelated observe, 3 passes of 4 columns");
+	Autodiff_linrz_correlated_observe_model<Function,NX> correlated(NX, NZ);
+	observe (correlated, "Correlated observe, 1 pass of 11 columns");
+	predict ();
+	return failures == 0 ? 0 : 1;
+}
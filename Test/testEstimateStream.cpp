@@ -0,0 +1,228 @@
+/*
+ * Bayes++ the Bayesian Filtering Library
+ * Copyright (c) 2002 Michael Stevens
+ * See accompanying Bayes++.htm for terms and conditions of use.
+ *
+ * $Id$
+ */
+
+/*
+ * Test Estimate_encoder and Estimate_decoder
+ *  The estimates of several tracking filters are encoded and decoded for many batches, with every Form
+ *  and Precision. Decoded estimates must be within the precision of the encoding: float rounding for
+ *  Single, half a step for Quantised x and X, and accumulated quantisation errors are not allowed.
+ *  A truncated record must leave the decoder able to decode the complete batch, and x,X of the wrong
+ *  size must be rejected without consuming the record.
+ */
+
+#include "BayesFilter/covFlt.hpp"
+#include "BayesFilter/estimateStream.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+
+using namespace Bayesian_filter;
+using namespace Bayesian_filter_matrix;
+
+namespace
+{
+	int failures = 0;
+
+	void check (bool ok, const char* what)
+	{
+		if (!ok) {
+			std::cout << "FAILED: " << what << std::endl;
+			++failures;
+		}
+	}
+
+	const std::size_t NX = 3;
+	const std::size_t tags = 4;
+	const int batches = 60;
+	const Float x_step = 1e-4, X_step = 1e-6;
+
+	class Predict : public Linear_predict_model
+	// Position, velocity and acceleration
+	{
+	public:
+		Predict () : Linear_predict_model(NX, 1)
+		{
+			const Float dt = 0.1;
+			Fx.clear();
+			Fx(0,0) = 1; Fx(0,1) = dt; Fx(0,2) = dt*dt/2;
+			Fx(1,1) = 1; Fx(1,2) = dt;
+			Fx(2,2) = 1;
+			G(0,0) = dt*dt/2; G(1,0) = dt; G(2,0) = 1;
+			q[0] = 0.1;
+		}
+	};
+
+	class Observe : public Linear_uncorrelated_observe_model
+	{
+	public:
+		Observe () : Linear_uncorrelated_observe_model(NX, 1)
+		{
+			Hx.clear();
+			Hx(0,0) = 1;
+			Zv[0] = 0.01;
+		}
+	};
+
+	Float difference (const SymMatrix& A, const SymMatrix& B)
+	{
+		Float d = 0;
+		for (std::size_t r = 0; r != A.size1(); ++r)
+			for (std::size_t c = r; c != A.size2(); ++c)
+				d = std::max (d, std::fabs(A(r,c) - B(r,c)));
+		return d;
+	}
+
+	class Trackers
+	/* Filters of several tags, each an estimate to be encoded
+	 */
+	{
+	public:
+		Trackers () : rng(7), z(1)
+		{
+			Vec x(NX);
+			SymMatrix X(NX,NX);
+			X.clear();
+			for (std::size_t i = 0; i != NX; ++i)
+				X(i,i) = 1;
+			for (std::size_t t = 0; t != tags; ++t) {
+				filters.push_back (Covariance_scheme(NX, 1));
+				x.clear();
+				x[0] = Float(t);
+				filters.back().init_kalman (x, X);
+			}
+		}
+		void step ()
+		{
+			std::normal_distribution<Float> normal;
+			for (std::size_t t = 0; t != tags; ++t) {
+				filters[t].predict (predict);
+				z[0] = filters[t].x[0] + 0.1 * normal(rng);
+				filters[t].observe (observe, z);
+				filters[t].update ();
+			}
+		}
+		std::vector<Covariance_scheme> filters;
+	private:
+		Predict predict;
+		Observe observe;
+		std::mt19937 rng;
+		Vec z;
+	};
+
+	void round_trip (Estimate_encoder::Form form, Estimate_encoder::Precision precision, const char* name)
+	/* Decoded estimates are within the precision of the encoding for every batch
+	 */
+	{
+		Trackers trackers;
+		Estimate_encoder encoder(NX, form, precision, x_step, X_step);
+		encoder.key_interval = 10;
+		Estimate_decoder decoder;
+		Vec x(NX);
+		SymMatrix X(NX,NX);
+		Float x_error = 0, X_error = 0, x_scale = 0, X_scale = 0;
+		std::size_t decoded = 0;
+		for (int k = 0; k != batches; ++k) {
+			trackers.step ();
+			encoder.begin ();
+			for (std::size_t t = 0; t != tags; ++t)
+				encoder.add (std::uint32_t(t), trackers.filters[t]);
+			const std::vector<unsigned char>& batch = encoder.end();
+			decoder.begin (&batch[0], batch.size());
+			check (decoder.size() == tags && decoder.x_size == NX && decoder.form == form && decoder.precision == precision, "header");
+			std::uint32_t tag;
+			while (decoder.next (tag, x, X)) {
+				const Covariance_scheme& f = trackers.filters[tag];
+				x_error = std::max (x_error, Float(norm_inf (x - f.x)));
+				X_error = std::max (X_error, difference (X, f.X));
+				x_scale = std::max (x_scale, Float(norm_inf (f.x)));
+				X_scale = std::max (X_scale, Float(norm_inf (f.X)));
+				++decoded;
+			}
+		}
+		std::cout << name << " x error " << x_error << " X error " << X_error << std::endl;
+		check (decoded == tags * batches, "all records decoded");
+		if (precision == Estimate_encoder::Single) {
+			const Float epsilon = std::numeric_limits<float>::epsilon();
+			check (x_error < epsilon * x_scale * 2, "single x");
+			check (X_error < epsilon * X_scale * 2, "single X");
+		}
+		else {
+			check (x_error <= x_step / 2 * (1 + 1e-9), "quantised x");
+			if (form == Estimate_encoder::Covariance)
+				check (X_error <= X_step / 2 * (1 + 1e-9), "quantised X");
+			else		// Quantised factor
+				check (X_error < 4 * X_step * (1 + std::sqrt(X_scale)), "quantised X factor");
+		}
+	}
+
+	void truncated ()
+	/* A truncated record leaves the previous values of its tag unchanged
+	 */
+	{
+		Trackers trackers;
+		Estimate_encoder encoder(NX, Estimate_encoder::Covariance, Estimate_encoder::Quantised, x_step, X_step);
+		Estimate_decoder decoder;
+		Vec x(NX);
+		SymMatrix X(NX,NX);
+		std::uint32_t tag;
+
+		trackers.step ();
+		encoder.begin ();
+		encoder.add (0, trackers.filters[0]);
+		std::vector<unsigned char> batch = encoder.end();		// Key record
+		decoder.begin (&batch[0], batch.size());
+		while (decoder.next (tag, x, X))
+			;
+		trackers.step ();
+		encoder.begin ();
+		encoder.add (0, trackers.filters[0]);
+		batch = encoder.end();									// Delta record
+
+		bool thrown = false;
+		decoder.begin (&batch[0], batch.size() - 2);
+		try {
+			decoder.next (tag, x, X);
+		}
+		catch (const Numeric_exception&) {
+			thrown = true;
+		}
+		check (thrown, "truncated record throws");
+
+		decoder.begin (&batch[0], batch.size());
+		Vec x_short(NX-1);
+		thrown = false;
+		try {
+			decoder.next (tag, x_short, X);
+		}
+		catch (const Logic_exception&) {
+			thrown = true;
+		}
+		check (thrown, "x of wrong size throws");
+
+		check (decoder.next (tag, x, X), "complete record after truncated record");
+		const Covariance_scheme& f = trackers.filters[0];
+		check (tag == 0 && norm_inf (x - f.x) <= x_step / 2 * (1 + 1e-9), "delta x after truncated record");
+		check (difference (X, f.X) <= X_step / 2 * (1 + 1e-9), "delta X after truncated record");
+		check (!decoder.next (tag, x, X), "end of batch");
+	}
+}//namespace
+
+
+int main ()
+{
+	round_trip (Estimate_encoder::Covariance, Estimate_encoder::Single, "Covariance Single");
+	round_trip (Estimate_encoder::Covariance, Estimate_encoder::Quantised, "Covariance Quantised");
+	round_trip (Estimate_encoder::UdU, Estimate_encoder::Single, "UdU Single");
+	round_trip (Estimate_encoder::UdU, Estimate_encoder::Quantised, "UdU Quantised");
+	round_trip (Estimate_encoder::Cholesky, Estimate_encoder::Single, "Cholesky Single");
+	round_trip (Estimate_encoder::Cholesky, Estimate_encoder::Quantised, "Cholesky Quantised");
+	truncated ();
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,178 @@
+/*
+ * Bayes++ the Bayesian Filtering Library
+ * Copyright (c) 2002 Michael Stevens
+ * See accompanying Bayes++.htm for terms and conditions of use.
+ *
+ * $Id$
+ */
+
+/*
+ * Test Gaussian_sum_scheme
+ *  Runs init, predict, observe with and without noise modes, update and reduce. The test is built
+ *  without NDEBUG so the uBLAS expressions of the header only scheme are checked.
+ *  The moments of update and of merging in reduce are compared with those computed directly.
+ */
+
+#include "BayesFilter/covFlt.hpp"
+#include "BayesFilter/filters/gaussSum.hpp"
+#include <cmath>
+#include <iostream>
+
+using namespace Bayesian_filter;
+using namespace Bayesian_filter_matrix;
+
+namespace
+{
+	int failures = 0;
+
+	void check (bool ok, const char* what)
+	{
+		if (!ok) {
+			std::cout << "FAILED: " << what << std::endl;
+			++failures;
+		}
+	}
+
+	class Predict : public Linear_predict_model
+	{
+	public:
+		Predict () : Linear_predict_model(2, 1)
+		{
+			Fx(0,0) = 1; Fx(0,1) = 1;
+			Fx(1,0) = 0; Fx(1,1) = 1;
+			G(0,0) = 0.5; G(1,0) = 1;
+			q[0] = 0.01;
+		}
+	};
+
+	class Observe : public Linear_uncorrelated_observe_model
+	{
+	public:
+		Observe () : Linear_uncorrelated_observe_model(2, 1)
+		{
+			Hx(0,0) = 1; Hx(0,1) = 0;
+			Zv[0] = 1;
+		}
+	};
+
+	typedef Gaussian_sum_scheme<Covariance_scheme> Sum;
+
+	Float difference (const SymMatrix& A, const SymMatrix& B)
+	{
+		Float d = 0;
+		for (std::size_t r = 0; r != A.size1(); ++r)
+			for (std::size_t c = 0; c != A.size2(); ++c)
+				d = std::max (d, std::fabs(A(r,c) - B(r,c)));
+		return d;
+	}
+
+	void moments (const Sum::Components& components, Vec& x, SymMatrix& X)
+	// Moments of the mixture computed elementwise
+	{
+		x.clear();
+		for (std::size_t i = 0; i != components.size(); ++i)
+			for (std::size_t r = 0; r != x.size(); ++r)
+				x[r] += components[i].weight * components[i].x[r];
+		X.clear();
+		for (std::size_t i = 0; i != components.size(); ++i)
+			for (std::size_t r = 0; r != x.size(); ++r)
+				for (std::size_t c = r; c != x.size(); ++c)
+					X(r,c) += components[i].weight * (components[i].X(r,c)
+						+ (components[i].x[r] - x[r]) * (components[i].x[c] - x[c]));
+	}
+
+	void single ()
+	/* A single component mixture is the component
+	 */
+	{
+		Covariance_scheme working(2, 1);
+		Sum f(2, working, 4);
+		f.x[0] = 1; f.x[1] = 2;
+		f.X.clear();
+		f.X(0,0) = 3; f.X(0,1) = 0.5; f.X(1,1) = 2;
+		f.init ();
+		const SymMatrix X0(f.X);
+		f.update ();
+		check (difference (f.X, X0) == 0, "single component update X");
+		check (f.x[0] == 1 && f.x[1] == 2, "single component update x");
+	}
+
+	void track ()
+	/* Bimodal prior of a constant velocity target, with direct or reflected observations
+	 */
+	{
+		Covariance_scheme working(2, 1);
+		Sum f(2, working, 4);
+		f.x.clear();
+		f.X.clear();
+		f.X(0,0) = f.X(1,1) = 1;
+		f.init ();
+		f.components.push_back (Sum::Component(1, f.x, f.X));
+		f.components[0].x[0] = -10;
+		f.components[1].x[0] = 10;
+		f.components[0].weight = f.components[1].weight = 0.5;
+
+		Sum::Noise_modes modes;
+		Vec mean(1), Zv(1);
+		mean[0] = 0; Zv[0] = 1;
+		modes.push_back (Sum::Noise_mode(0.8, mean, Zv));		// Direct
+		mean[0] = 5; Zv[0] = 4;
+		modes.push_back (Sum::Noise_mode(0.2, mean, Zv));		// Reflected
+
+		Predict predict;
+		Observe observe;
+		Vec z(1), x(2);
+		SymMatrix X(2,2);
+		Float truth = 10;
+		for (int k = 0; k != 20; ++k) {
+			f.predict (predict);
+			truth += 1;
+			z[0] = truth + (k % 5 == 3 ? 5 : 0);		// Reflected every 5th observation
+			if (k % 2 == 0)
+				f.observe (observe, modes, z);
+			else
+				f.observe (observe, z);
+			f.update ();
+			check (f.components.size() <= f.max_components, "components bound");
+			moments (f.components, x, X);
+			check (norm_inf(f.x - x) < 1e-9, "update x");
+			check (difference (f.X, X) < 1e-9, "update X");
+		}
+		std::cout << "Position " << f.x[0] << " truth " << truth << " velocity " << f.x[1] << std::endl;
+		check (std::fabs(f.x[0] - truth) < 2, "position");
+		check (std::fabs(f.x[1] - 1) < 0.5, "velocity");
+	}
+
+	void merge ()
+	/* Reducing to a single component conserves the moments of the mixture
+	 */
+	{
+		Covariance_scheme working(2, 1);
+		Sum f(2, working, 1);
+		f.x.clear();
+		f.X.clear();
+		f.X(0,0) = 2; f.X(1,1) = 1; f.X(0,1) = 0.3;
+		f.init ();
+		f.components.push_back (Sum::Component(0.3, f.x, f.X));
+		f.components.push_back (Sum::Component(0.2, f.x, f.X));
+		f.components[0].weight = 0.5;
+		f.components[1].x[0] = 3; f.components[1].x[1] = -1;
+		f.components[2].x[0] = -2; f.components[2].X(1,1) = 4;
+		Vec x(2);
+		SymMatrix X(2,2);
+		moments (f.components, x, X);
+		f.reduce ();
+		check (f.components.size() == 1, "reduce to one component");
+		check (norm_inf(f.components[0].x - x) < 1e-12, "merge x");
+		check (difference (f.components[0].X, X) < 1e-12, "merge X");
+	}
+}//namespace
+
+
+int main ()
+{
+	single ();
+	track ();
+	merge ();
+	return failures == 0 ? 0 : 1;
+}
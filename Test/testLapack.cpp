@@ -0,0 +1,213 @@
+/*
+ * Bayes++ the Bayesian Filtering Library
+ * Copyright (c) 2002 Michael Stevens
+ * See accompanying Bayes++.htm for terms and conditions of use.
+ *
+ * $Id$
+ */
+
+/*
+ * Test BLAS/LAPACK dispatch consistency
+ *  Each dispatched operation is computed with lapack_dispatch_size set so every operation is dispatched,
+ *  and again so none are, and the results compared. The factor, rcond and determinant must agree to rounding.
+ *  Without BAYES_FILTER_LAPACK both computations use the uBLAS algorithms.
+ */
+
+#include "BayesFilter/bayesFlt.hpp"
+#include "BayesFilter/matSup.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+
+using namespace Bayesian_filter_matrix;
+
+namespace
+{
+	int failures = 0;
+
+	void check (bool ok, const char* what)
+	{
+		if (!ok) {
+			std::cout << "FAILED: " << what << std::endl;
+			++failures;
+		}
+	}
+
+	const std::size_t N = 12;
+	const Float tolerance = 1e-10;
+
+	std::mt19937 rng (5);
+
+	void random (RowMatrix& M)
+	{
+		std::normal_distribution<Float> normal;
+		for (std::size_t r = 0; r != M.size1(); ++r)
+			for (std::size_t c = 0; c != M.size2(); ++c)
+				M(r,c) = normal(rng);
+	}
+
+	SymMatrix random_PD (std::size_t n)
+	// Random Positive Definite matrix
+	{
+		RowMatrix A(n,n);
+		random (A);
+		SymMatrix P(n,n);
+		P = prod(A, trans(A));
+		return P;
+	}
+
+	SymMatrix random_PSD (std::size_t n)
+	// Random Positive Semi-definite matrix, exactly singular with a zero row and column
+	{
+		SymMatrix P = random_PD (n);
+		for (std::size_t i = 0; i != n; ++i)
+			P(n/2,i) = 0;
+		return P;
+	}
+
+	Float difference (const SymMatrix& A, const SymMatrix& B)
+	// Largest difference relative to the largest element of B
+	{
+		Float d = 0, m = 0;
+		for (std::size_t r = 0; r != A.size1(); ++r)
+			for (std::size_t c = r; c != A.size2(); ++c) {
+				d = std::max (d, std::fabs(A(r,c) - B(r,c)));
+				m = std::max (m, std::fabs(B(r,c)));
+			}
+		return d / m;
+	}
+
+	void dispatch (bool lapack)
+	{
+		lapack_dispatch_size = lapack ? 1 : std::numeric_limits<std::size_t>::max();
+	}
+
+	void factor ()
+	/* UdUfactor, the factor and rcond agree. Semi-definite and negative matrices are not PD for LAPACK
+	 */
+	{
+		const SymMatrix P = random_PD (N);
+		RowMatrix L(P), U(P);
+		dispatch (true);
+		const Float lrcond = UdUfactor (L, N);
+		dispatch (false);
+		const Float urcond = UdUfactor (U, N);
+		Float d = 0;
+		for (std::size_t r = 0; r != N; ++r)
+			for (std::size_t c = r; c != N; ++c)
+				d = std::max (d, std::fabs(L(r,c) - U(r,c)) / (std::fabs(U(r,c)) + 1));
+		std::cout << "UdUfactor difference " << d << " rcond " << lrcond << ' ' << urcond << std::endl;
+		check (d < tolerance, "UdUfactor factor");
+		check (std::fabs(lrcond - urcond) <= tolerance * urcond, "UdUfactor rcond");
+
+		RowMatrix S(random_PSD (N));
+		dispatch (true);
+		check (UdUfactor (S, N) == 0, "UdUfactor semi-definite rcond");
+		RowMatrix Neg(-random_PD (N));
+		check (UdUfactor (Neg, N) < 0, "UdUfactor negative rcond");
+	}
+
+	void inverse ()
+	/* UdUinversePD, the inverse, rcond and determinant agree
+	 */
+	{
+		const SymMatrix P = random_PD (N);
+		SymMatrix L(N,N), U(N,N);
+		Float ldet, udet;
+		dispatch (true);
+		const Float lrcond = UdUinversePD (L, ldet, P);
+		dispatch (false);
+		const Float urcond = UdUinversePD (U, udet, P);
+		const Float d = difference (L, U);
+		std::cout << "UdUinversePD difference " << d << " rcond " << lrcond << ' ' << urcond << std::endl;
+		check (d < tolerance, "UdUinversePD inverse");
+		check (std::fabs(lrcond - urcond) <= tolerance * urcond, "UdUinversePD rcond");
+		check (std::fabs(ldet - udet) <= tolerance * udet, "UdUinversePD determinant");
+
+		SymMatrix S = random_PSD (N);
+		dispatch (true);
+		check (UdUinversePD (S) == 0, "UdUinversePD semi-definite rcond");
+	}
+
+	void solve ()
+	/* UdUsolve_right
+	 */
+	{
+		RowMatrix UD(random_PD (N));
+		UdUfactor (UD, N);
+		RowMatrix B(3,N);
+		random (B);
+		RowMatrix L(B), U(B);
+		dispatch (true);
+		UdUsolve_right (UD, L);
+		dispatch (false);
+		UdUsolve_right (UD, U);
+		Float d = 0;
+		for (std::size_t r = 0; r != B.size1(); ++r)
+			for (std::size_t c = 0; c != N; ++c)
+				d = std::max (d, std::fabs(L(r,c) - U(r,c)) / (std::fabs(U(r,c)) + 1));
+		std::cout << "UdUsolve_right difference " << d << std::endl;
+		check (d < tolerance, "UdUsolve_right");
+	}
+
+	void products ()
+	/* assign_prod_SPD, minus_assign_prod_SPD and assign_sample_covariance, the upper triangles agree
+	 */
+	{
+		const SymMatrix S = random_PD (N);
+		RowMatrix X(N-3,N), XStemp(N-3,N);
+		random (X);
+		SymMatrix L(N-3,N-3), U(N-3,N-3);
+		dispatch (true);
+		assign_prod_SPD (L, X, S, XStemp);
+		dispatch (false);
+		assign_prod_SPD (U, X, S, XStemp);
+		Float d = difference (L, U);
+		std::cout << "assign_prod_SPD difference " << d << std::endl;
+		check (d < tolerance, "assign_prod_SPD");
+
+		SymMatrix LM(U), UM(U);
+		LM *= 3; UM *= 3;
+		dispatch (true);
+		minus_assign_prod_SPD (LM, X, S, XStemp);
+		dispatch (false);
+		minus_assign_prod_SPD (UM, X, S, XStemp);
+		d = difference (LM, UM);
+		std::cout << "minus_assign_prod_SPD difference " << d << std::endl;
+		check (d < tolerance, "minus_assign_prod_SPD");
+
+		ColMatrix Samples(N, 50);
+		std::normal_distribution<Float> normal;
+		for (std::size_t r = 0; r != N; ++r)
+			for (std::size_t c = 0; c != Samples.size2(); ++c)
+				Samples(r,c) = normal(rng);
+		Vec mean(N);
+		for (std::size_t r = 0; r != N; ++r)
+			mean[r] = normal(rng);
+		SymMatrix LC(N,N), UC(N,N);
+		dispatch (true);
+		assign_sample_covariance (LC, Samples, mean);
+		dispatch (false);
+		assign_sample_covariance (UC, Samples, mean);
+		d = difference (LC, UC);
+		std::cout << "assign_sample_covariance difference " << d << std::endl;
+		check (d < tolerance, "assign_sample_covariance");
+	}
+}//namespace
+
+
+int main ()
+{
+#ifdef BAYES_FILTER_LAPACK
+	std::cout << "BLAS/LAPACK dispatch compared with uBLAS" << std::endl;
+#else
+	std::cout << "Without BAYES_FILTER_LAPACK, uBLAS compared with uBLAS" << std::endl;
+#endif
+	factor ();
+	inverse ();
+	solve ();
+	products ();
+	return failures == 0 ? 0 : 1;
+}
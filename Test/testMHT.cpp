@@ -0,0 +1,172 @@
+/*
+ * Bayes++ the Bayesian Filtering Library
+ * Copyright (c) 2002 Michael Stevens
+ * See accompanying Bayes++.htm for terms and conditions of use.
+ *
+ * $Id$
+ */
+
+/*
+ * Test Hypothesis_tracker
+ *  With one measurement per scan every hypothesis forks in two, so N-scan pruning must keep
+ *  1, 2 and 4 hypotheses for n_scan 0, 1 and 2. A target is tracked in clutter with bounds on the
+ *  number of hypotheses and the storage of their states, which must be honoured every scan.
+ *  The test is built without NDEBUG so the uBLAS expressions of the header only filter are checked.
+ */
+
+#include "BayesFilter/covFlt.hpp"
+#include "BayesFilter/filters/mht.hpp"
+#include <cmath>
+#include <iostream>
+#include <random>
+
+using namespace Bayesian_filter;
+using namespace Bayesian_filter_matrix;
+
+namespace
+{
+	int failures = 0;
+
+	void check (bool ok, const char* what)
+	{
+		if (!ok) {
+			std::cout << "FAILED: " << what << std::endl;
+			++failures;
+		}
+	}
+
+	class Predict : public Linear_predict_model
+	{
+	public:
+		Predict () : Linear_predict_model(2, 1)
+		{
+			Fx(0,0) = 1; Fx(0,1) = 1;
+			Fx(1,0) = 0; Fx(1,1) = 1;
+			G(0,0) = 0.5; G(1,0) = 1;
+			q[0] = 0.01;
+		}
+	};
+
+	class Observe : public Linear_uncorrelated_observe_model
+	{
+	public:
+		Observe () : Linear_uncorrelated_observe_model(2, 1)
+		{
+			Hx(0,0) = 1; Hx(0,1) = 0;
+			Zv[0] = 0.25;
+		}
+	};
+
+	typedef Hypothesis_tracker<Covariance_scheme> Tracker;
+
+	void init (Tracker& mht)
+	{
+		Vec x(2);
+		x[0] = 0; x[1] = 0;
+		SymMatrix X(2,2);
+		X.clear();
+		X(0,0) = X(1,1) = 1;
+		mht.init (x, X);
+	}
+
+	void n_scan ()
+	/* Hypotheses differ only in their last n_scan decisions
+	 */
+	{
+		const std::size_t expected[] = {1, 2, 4};
+		Predict predict;
+		Observe observe;
+		for (std::size_t n = 0; n != 3; ++n) {
+			Covariance_scheme working(2, 1);
+			Tracker mht(working, n, 1000, 1 << 24);
+			init (mht);
+			std::vector<Vec> zs(1, Vec(1));
+			zs[0][0] = 0.1;
+			for (int k = 0; k != 4; ++k) {
+				mht.predict (predict);
+				mht.observe (observe, zs, -1);
+			}
+			std::cout << "n_scan " << n << " hypotheses " << mht.all().size() << std::endl;
+			check (mht.all().size() == expected[n], "n_scan hypotheses");
+			check (mht.best().log_weight == 0, "n_scan best normalised");
+		}
+	}
+
+	void budget ()
+	/* Target in clutter with a bound on the storage of states
+	 */
+	{
+		Predict predict;
+		Observe observe;
+		Covariance_scheme working(2, 1);
+		Tracker probe(working, 3, 50, 1 << 24);
+		init (probe);
+		const std::size_t state_bytes = probe.state_bytes();		// Storage of one state
+		const std::size_t max_state_bytes = 5 * state_bytes;
+
+		Tracker mht(working, 3, 50, max_state_bytes);
+		init (mht);
+		std::mt19937 rng (3);
+		std::normal_distribution<Float> normal;
+		std::uniform_real_distribution<Float> uniform;
+		Vec truth(2);
+		truth[0] = 0; truth[1] = 0.5;
+		std::size_t most = 0;
+		bool bounded = true, ordered = true;
+		Float se = 0;
+		const int scans = 100;
+		for (int k = 0; k != scans; ++k) {
+			truth = predict.f(truth);
+			std::vector<Vec> zs;
+			Vec z(1);
+			if (uniform(rng) < 0.9) {
+				z[0] = truth[0] + 0.5 * normal(rng);
+				zs.push_back (z);
+			}
+			for (int c = 0; c != 2; ++c) {		// Clutter
+				z[0] = truth[0] + (uniform(rng) - 0.5) * 20;
+				zs.push_back (z);
+			}
+			mht.predict (predict);
+			mht.observe (observe, zs, std::log(0.1) - std::log(0.9));
+
+			bounded = bounded && mht.state_bytes() <= max_state_bytes && mht.all().size() <= mht.max_hypotheses;
+			for (std::size_t i = 1; i != mht.all().size(); ++i)
+				ordered = ordered && mht.all()[i-1].log_weight >= mht.all()[i].log_weight;
+			most = std::max (most, mht.all().size());
+			const Float e = mht.best().state->x[0] - truth[0];
+			se += e*e;
+		}
+		const Float rmse = std::sqrt(se / scans);
+		std::cout << "Most hypotheses " << most << " state bytes " << mht.state_bytes()
+			<< " of " << max_state_bytes << " rmse " << rmse << std::endl;
+		check (bounded, "max_state_bytes and max_hypotheses honoured");
+		check (most > 1, "multiple hypotheses within budget");
+		check (ordered, "hypotheses ordered by likelihood");
+		check (rmse < 1, "tracking in clutter");
+	}
+
+	void no_hypotheses ()
+	/* A zero hypothesis budget is a logic error
+	 */
+	{
+		Covariance_scheme working(2, 1);
+		bool thrown = false;
+		try {
+			Tracker mht(working, 1, 0, 1 << 24);
+		}
+		catch (const Logic_exception&) {
+			thrown = true;
+		}
+		check (thrown, "max_hypotheses 0 throws");
+	}
+}//namespace
+
+
+int main ()
+{
+	n_scan ();
+	budget ();
+	no_hypotheses ();
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,184 @@
+/*
+ * Bayes++ the Bayesian Filtering Library
+ * Copyright (c) 2002 Michael Stevens
+ * See accompanying Bayes++.htm for terms and conditions of use.
+ *
+ * $Id$
+ */
+
+/*
+ * Test Proposal_SIR_scheme
+ *  A 2D random walk is observed by sharp range measurements from three beacons in turn. The bootstrap
+ *  SIR_scheme, which samples the prior transition, needs many samples as few fall within the likelihood.
+ *  With 100 samples the proposal must reach the accuracy of the bootstrap with 1000 samples, with both
+ *  the unscented (Unscented_scheme) and the extended Kalman filter (Covariance_scheme) proposals.
+ *  The test is built without NDEBUG so the uBLAS expressions of the header only filter are checked.
+ */
+
+#include "BayesFilter/covFlt.hpp"
+#include "BayesFilter/unsFlt.hpp"
+#include "BayesFilter/SIRFlt.hpp"
+#include "BayesFilter/models.hpp"
+#include "BayesFilter/monteCarlo.hpp"
+#include "BayesFilter/filters/proposal.hpp"
+#include <cmath>
+#include <iostream>
+
+using namespace Bayesian_filter;
+using namespace Bayesian_filter_matrix;
+
+namespace
+{
+	int failures = 0;
+
+	void check (bool ok, const char* what)
+	{
+		if (!ok) {
+			std::cout << "FAILED: " << what << std::endl;
+			++failures;
+		}
+	}
+
+	const Float WALK_NOISE = 0.5;		// Random walk std. dev. per step
+	const Float RANGE_NOISE = 0.02;		// Range observation std. dev.
+	const int steps = 50;
+	const unsigned trials = 10;
+
+	class Walk : public Sampled_LiAd_predict_model
+	{
+	public:
+		Walk (SIR_random& random) : Sampled_LiAd_predict_model(2, 2, random)
+		{
+			Fx.clear();
+			Fx(0,0) = Fx(1,1) = 1;
+			G.clear();
+			G(0,0) = G(1,1) = 1;
+			q[0] = q[1] = WALK_NOISE*WALK_NOISE;
+		}
+	};
+
+	class Range : public General_LzUnAd_observe_model
+	/* Range from a beacon, Hx is linearised at x by h(x) as required by the extended Kalman filter proposal
+	 */
+	{
+	public:
+		Range (Float bx, Float by) : General_LzUnAd_observe_model(2, 1), bx(bx), by(by), z_pred(1)
+		{
+			Zv[0] = RANGE_NOISE*RANGE_NOISE;
+		}
+		const Vec& h (const Vec& x) const
+		{
+			const Float dx = x[0] - bx, dy = x[1] - by;
+			const Float r = std::sqrt(dx*dx + dy*dy);
+			z_pred[0] = r;
+			FM::Matrix& H = const_cast<FM::Matrix&>(Hx);
+			H(0,0) = dx / r;
+			H(0,1) = dy / r;
+			return z_pred;
+		}
+	private:
+		const Float bx, by;
+		mutable Vec z_pred;
+	};
+
+	void predict_observe (SIR_scheme& f, Walk& walk, Range& range, const Vec& z)
+	// Bootstrap: sample the prior transition and weight by the likelihood
+	{
+		f.predict (walk);
+		range.Lz (z);
+		f.observe (range, z);
+	}
+
+	template <class Local_filter>
+	void predict_observe (Proposal_SIR_scheme<Local_filter>& f, Walk& walk, Range& range, const Vec& z)
+	{
+		f.predict_observe (walk, range, z);
+	}
+
+	template <class Scheme>
+	Float trial (unsigned seed, std::size_t samples)
+	/* RMSE of the sample mean position
+	 */
+	{
+		Monte_carlo_random truth_random(seed, 0), scheme_random(seed, 1), predict_random(seed, 2);
+		Scheme f(2, samples, 2, scheme_random);
+		f.rougheningK = 0.2;
+		Walk walk(predict_random);
+		Range beacon0(0,0), beacon1(10,0), beacon2(0,10);
+		Range* beacons[3] = {&beacon0, &beacon1, &beacon2};
+
+		Vec x(2), z(1);
+		x[0] = 3; x[1] = 4;
+		for (std::size_t i = 0; i != samples; ++i) {
+			f.S(0,i) = x[0] + truth_random.normal();
+			f.S(1,i) = x[1] + truth_random.normal();
+		}
+		f.init_S ();
+
+		Float se = 0;
+		for (int k = 0; k != steps; ++k) {
+			x[0] += WALK_NOISE * truth_random.normal();
+			x[1] += WALK_NOISE * truth_random.normal();
+			Range& range = *beacons[k % 3];
+			z[0] = range.h(x)[0] + RANGE_NOISE * truth_random.normal();
+			predict_observe (f, walk, range, z);
+			f.update_resample ();
+
+			Float mx = 0, my = 0;
+			for (std::size_t i = 0; i != samples; ++i) {
+				mx += f.S(0,i);
+				my += f.S(1,i);
+			}
+			mx /= Float(samples); my /= Float(samples);
+			se += (mx - x[0])*(mx - x[0]) + (my - x[1])*(my - x[1]);
+		}
+		return std::sqrt(se / steps);
+	}
+
+	class Bootstrap : public SIR_scheme
+	// SIR_scheme with the constructor signature of Proposal_SIR_scheme
+	{
+	public:
+		Bootstrap (std::size_t x_size, std::size_t s_size, std::size_t, SIR_random& random_helper) :
+			Sample_state_filter (x_size, s_size),
+			SIR_scheme (x_size, s_size, random_helper)
+		{}
+	};
+
+	template <class Scheme>
+	Float mean_rmse (std::size_t samples, unsigned& failed)
+	// Mean RMSE of the trials which did not fail
+	{
+		Float sum = 0;
+		failed = 0;
+		for (unsigned seed = 1; seed <= trials; ++seed) {
+			try {
+				sum += trial<Scheme> (seed, samples);
+			}
+			catch (const Numeric_exception&) {		// All weights zero
+				++failed;
+			}
+		}
+		return failed == trials ? 0 : sum / Float(trials - failed);
+	}
+}//namespace
+
+
+int main ()
+{
+	unsigned failed_boot100, failed_boot1000, failed_unscented, failed_ekf;
+	const Float boot100 = mean_rmse<Bootstrap> (100, failed_boot100);
+	const Float boot1000 = mean_rmse<Bootstrap> (1000, failed_boot1000);
+	const Float unscented = mean_rmse<Proposal_SIR_scheme<Unscented_scheme> > (100, failed_unscented);
+	const Float ekf = mean_rmse<Proposal_SIR_scheme<Covariance_scheme> > (100, failed_ekf);
+	std::cout << "RMSE (failed trials of " << trials << ")" << std::endl;
+	std::cout << "Bootstrap 100 samples  " << boot100 << " (" << failed_boot100 << ')' << std::endl;
+	std::cout << "Bootstrap 1000 samples " << boot1000 << " (" << failed_boot1000 << ')' << std::endl;
+	std::cout << "Unscented proposal 100 samples " << unscented << " (" << failed_unscented << ')' << std::endl;
+	std::cout << "EKF proposal 100 samples       " << ekf << " (" << failed_ekf << ')' << std::endl;
+
+	check (failed_boot1000 == 0, "bootstrap 1000 samples");
+	check (failed_unscented == 0 && unscented < 1.1 * boot1000, "unscented proposal accuracy");
+	check (failed_ekf == 0 && ekf < 1.1 * boot1000, "EKF proposal accuracy");
+	return failures == 0 ? 0 : 1;
+}